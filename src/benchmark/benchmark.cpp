@@ -0,0 +1,1531 @@
+#include "conversionstats.h"
+#include "doubleformat.h"
+#include "doublestreamwriter.h"
+#include "doubletodecimal.h"
+#include "doubletonumber.h"
+#include "doubletonumberbatch.h"
+#include "doubletonumbercache.h"
+#include "numbertodouble.h"
+#include "packednumber.h"
+#include "parallelconvert.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <random>
+#include <vector>
+#include <fcntl.h>
+
+#if defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define BENCHMARK_HAS_TSC 1
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define BENCHMARK_HAS_TSC 1
+#else
+#define BENCHMARK_HAS_TSC 0
+#endif
+
+// std::to_chars for doubles came with C++17 and is still missing from some standard
+// libraries.
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#define BENCHMARK_HAS_TO_CHARS 1
+#else
+#define BENCHMARK_HAS_TO_CHARS 0
+#endif
+
+// Benchmarks for the conversion engine.
+//
+// Usage: doubletonumberbenchmark [--json] [filter]
+// Runs every benchmark whose name contains `filter`, or all of them. Every result is
+// reported in ns, cycles and heap allocations per item. With --json each result is
+// printed as one JSON object per line instead, for tracking regressions:
+// {"benchmark":"...","variant":"...","items":N,"ns":x,"cycles":x,"allocations":x}
+// "cycles" is null where there is no cycle counter.
+
+static std::atomic<uint64_t> allocationCount(0);
+
+#if defined(__GLIBC__)
+// With glibc every allocation of the process, operator new and the ones inside the C
+// library included, goes through these, so we count them and forward to glibc.
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pMemory, size_t size);
+
+extern "C" void* malloc(size_t size) __THROW
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) __THROW
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pMemory, size_t size) __THROW
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pMemory, size);
+}
+#else
+// Elsewhere only operator new is counted.
+void* operator new(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* pMemory = malloc(size != 0 ? size : 1);
+    if (pMemory == NULL)
+    {
+        throw std::bad_alloc();
+    }
+
+    return pMemory;
+}
+
+void operator delete(void* pMemory) noexcept
+{
+    free(pMemory);
+}
+#endif
+
+// Time stamp counter ticks, which run at a constant rate close to the nominal clock
+// of the CPU rather than its current one.
+static uint64_t readCycleCounter()
+{
+#if BENCHMARK_HAS_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+struct Measurement
+{
+    double seconds;
+    uint64_t cycles;
+    uint64_t allocations;
+};
+
+class Stopwatch
+{
+public:
+    Stopwatch()
+        :m_start(std::chrono::steady_clock::now()),
+        m_startCycles(readCycleCounter()),
+        m_startAllocations(allocationCount.load(std::memory_order_relaxed))
+    {
+    }
+
+    Measurement elapsed() const
+    {
+        Measurement measurement;
+        measurement.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+        measurement.cycles = readCycleCounter() - m_startCycles;
+        measurement.allocations = allocationCount.load(std::memory_order_relaxed) - m_startAllocations;
+        return measurement;
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+    uint64_t m_startCycles;
+    uint64_t m_startAllocations;
+};
+
+static bool isJsonOutput = false;
+
+// The names and variants are our own and contain nothing which needs escaping in JSON.
+static void report(const char* name, const char* variant, size_t items, const Measurement& measurement)
+{
+    double ns = measurement.seconds * 1e9 / items;
+    double cycles = (double)measurement.cycles / items;
+    double allocations = (double)measurement.allocations / items;
+    if (isJsonOutput)
+    {
+        char cyclesText[32] = "null";
+        if (BENCHMARK_HAS_TSC)
+        {
+            sprintf(cyclesText, "%.1f", cycles);
+        }
+
+        printf("{\"benchmark\":\"%s\",\"variant\":\"%s\",\"items\":%zu,\"ns\":%.1f,\"cycles\":%s,\"allocations\":%.3f}\n",
+            name, variant, items, ns, cyclesText, allocations);
+    }
+    else
+    {
+        printf("%-18s %-44s %8.1f ns/op %8.1f cycles/op %6.2f allocs/op\n", name, variant, ns, cycles, allocations);
+    }
+
+    fflush(stdout);
+}
+
+// Random finite doubles: a mix of uniformly random bit patterns, prices with two
+// decimals and integers, which is roughly what our exports contain.
+static std::vector<double> generateMixedValues(size_t count)
+{
+    std::mt19937_64 random(42);
+    std::vector<double> values(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t bits = random();
+        switch (i % 3)
+        {
+        case 0:
+            bits &= 0x7FEFFFFFFFFFFFFF;
+            memcpy(&values[i], &bits, sizeof(double));
+            break;
+        case 1:
+            values[i] = (double)(bits % 10000000) / 100;
+            break;
+        default:
+            values[i] = (double)(bits % 100000000);
+            break;
+        }
+    }
+
+    return values;
+}
+
+static void benchmarkParallelConvert()
+{
+    const size_t count = 8 * 1024 * 1024;
+    const int precision = 17;
+    std::vector<double> values = generateMixedValues(count);
+    std::vector<NUMBER> numbers(count);
+
+    Stopwatch singleStopwatch;
+    for (size_t i = 0; i < count; ++i)
+    {
+        DoubleToNumber(values[i], precision, &numbers[i]);
+    }
+
+    Measurement singleTime = singleStopwatch.elapsed();
+    report("ParallelConvert", "DoubleToNumber loop", count, singleTime);
+
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    double oneThreadSeconds = 0;
+    for (unsigned int threads = 1; ; threads = std::min(threads * 2, maxThreads))
+    {
+        ParallelConverter converter(threads);
+
+        Stopwatch stopwatch;
+        converter.convert(values.data(), count, precision, numbers.data());
+        Measurement time = stopwatch.elapsed();
+
+        if (threads == 1)
+        {
+            oneThreadSeconds = time.seconds;
+        }
+
+        char variant[64];
+        sprintf(variant, "%u threads (x%.2f)", threads, oneThreadSeconds / time.seconds);
+        report("ParallelConvert", variant, count, time);
+
+        if (threads == maxThreads)
+        {
+            break;
+        }
+    }
+}
+
+// The BigNum path only, without the Grisu fast path in front of it. The block size of
+// BigNum is chosen at compile time, so configure once with and once without
+// DOUBLETONUMBER_BIGNUM_BLOCK32 to compare the two backends.
+static void benchmarkBigNumBackend()
+{
+    const size_t count = 1024 * 1024;
+    std::vector<double> values = generateMixedValues(count);
+    const char* backend = BigNum::BLOCKBITS == 64 ? "64 bit blocks" : "32 bit blocks";
+
+    char digits[NUMBER_MAXDIGITS + 1];
+    int dec = 0;
+    int sign = 0;
+
+    const int precisions[] = { 17, 30, 50 };
+    for (size_t p = 0; p < sizeof(precisions) / sizeof(precisions[0]); ++p)
+    {
+        Stopwatch stopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            Dragon4Double(values[i], precisions[p], digits, &dec, &sign);
+        }
+
+        char variant[64];
+        sprintf(variant, "%s, precision %d", backend, precisions[p]);
+        report("BigNumBackend", variant, count, stopwatch.elapsed());
+    }
+
+    Stopwatch stopwatch;
+    for (size_t i = 0; i < count; ++i)
+    {
+        Dragon4DoubleShortest(values[i], digits, &dec, &sign);
+    }
+
+    char variant[64];
+    sprintf(variant, "%s, shortest", backend);
+    report("BigNumBackend", variant, count, stopwatch.elapsed());
+}
+
+static int openNullDevice()
+{
+#ifdef _WIN32
+    return _open("NUL", _O_WRONLY);
+#else
+    return open("/dev/null", O_WRONLY);
+#endif
+}
+
+// Text output of a CSV column to /dev/null: the writer against the snprintf("%.17g") loop
+// it replaces, which appends to a buffer of the same size and writes it out when full.
+static void benchmarkStreamWriter()
+{
+    const size_t count = 4 * 1024 * 1024;
+    std::vector<double> values = generateMixedValues(count);
+    int fd = openNullDevice();
+    if (fd < 0)
+    {
+        printf("StreamWriter: cannot open the null device\n");
+        return;
+    }
+
+    std::vector<char> buffer(DOUBLESTREAMWRITER_BUFFERSIZE);
+    size_t used = 0;
+    size_t bytes = 0;
+
+    Stopwatch snprintfStopwatch;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (buffer.size() - used < 32)
+        {
+            write(fd, buffer.data(), (unsigned int)used);
+            bytes += used;
+            used = 0;
+        }
+
+        used += snprintf(buffer.data() + used, buffer.size() - used, "%.17g", values[i]);
+        buffer[used++] = '\n';
+    }
+
+    write(fd, buffer.data(), (unsigned int)used);
+    bytes += used;
+
+    Measurement snprintfTime = snprintfStopwatch.elapsed();
+    char variant[64];
+    sprintf(variant, "snprintf %%.17g, %.0f MB/s", bytes / snprintfTime.seconds / 1e6);
+    report("StreamWriter", variant, count, snprintfTime);
+
+    const int precisions[] = { 17, 0 };
+    for (size_t p = 0; p < sizeof(precisions) / sizeof(precisions[0]); ++p)
+    {
+        Stopwatch stopwatch;
+        {
+            DoubleStreamWriter writer(fd);
+            writer.setPrecision(precisions[p]);
+            writer.writeRow(values.data(), count, '\n');
+        }
+
+        Measurement time = stopwatch.elapsed();
+
+        // Count the bytes outside of the timed loop.
+        bytes = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            char text[32];
+            DoubleToCharsResult<char> result = precisions[p] == 0
+                ? DoubleToChars(text, text + sizeof(text), values[i])
+                : DoubleToChars(text, text + sizeof(text), values[i], CHARS_FORMAT_GENERAL, precisions[p]);
+            bytes += result.ptr - text + 1;
+        }
+
+        sprintf(variant, "%s, %.0f MB/s (x%.2f)", precisions[p] == 0 ? "writer shortest" : "writer %.17g", bytes / time.seconds / 1e6, snprintfTime.seconds / time.seconds);
+        report("StreamWriter", variant, count, time);
+    }
+
+    close(fd);
+}
+
+// A float column converted by FloatToNumber against widening every value to double.
+// The shortest mode of the double path gives the shortest digits of the double, which
+// are longer, but that is what converting through double costs today.
+static void benchmarkFloatToNumber()
+{
+    const size_t count = 1024 * 1024;
+    std::vector<double> doubles = generateMixedValues(count);
+    std::vector<float> values(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        values[i] = (float)doubles[i];
+        if (i % 3 == 0)
+        {
+            // Uniformly random bits of a finite float instead of an overflow.
+            uint32_t bits = (uint32_t)(i * 2654435761u) & 0x7F7FFFFF;
+            memcpy(&values[i], &bits, sizeof(float));
+        }
+    }
+
+    struct ModeEntry
+    {
+        const char* name;
+        DoubleToNumberMode mode;
+        int precision;
+    };
+
+    const ModeEntry modes[] =
+    {
+        { "precision 9", DTN_PRECISION, 9 },
+        { "shortest", DTN_SHORTEST, 0 },
+        { "fixed 3", DTN_FIXED, 3 },
+    };
+
+    NUMBER number;
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m)
+    {
+        Stopwatch doubleStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            DoubleToNumber((double)values[i], modes[m].precision, modes[m].mode, &number);
+        }
+
+        Measurement doubleTime = doubleStopwatch.elapsed();
+
+        Stopwatch floatStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            FloatToNumber(values[i], modes[m].precision, modes[m].mode, &number);
+        }
+
+        Measurement floatTime = floatStopwatch.elapsed();
+
+        char variant[64];
+        sprintf(variant, "%s, via double", modes[m].name);
+        report("FloatToNumber", variant, count, doubleTime);
+        sprintf(variant, "%s (x%.2f)", modes[m].name, doubleTime.seconds / floatTime.seconds);
+        report("FloatToNumber", variant, count, floatTime);
+    }
+}
+
+// The cost of the long double and binary128 paths relative to DoubleToNumber: first for
+// the same values in the range of doubles, then for long doubles spread over their whole
+// exponent range, where only the BigNum path applies.
+static void benchmarkLongDouble()
+{
+    const size_t count = 256 * 1024;
+    std::vector<double> values = generateMixedValues(count);
+
+    struct ModeEntry
+    {
+        const char* name;
+        DoubleToNumberMode mode;
+        int precision;
+    };
+
+    const ModeEntry modes[] =
+    {
+        { "17 digits", DTN_PRECISION, 17 },
+        { "shortest", DTN_SHORTEST, 0 },
+    };
+
+    NUMBER number;
+    char variant[64];
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m)
+    {
+        Stopwatch doubleStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            DoubleToNumber(values[i], modes[m].precision, modes[m].mode, &number);
+        }
+
+        Measurement doubleTime = doubleStopwatch.elapsed();
+        sprintf(variant, "%s double", modes[m].name);
+        report("LongDouble", variant, count, doubleTime);
+
+        Stopwatch longDoubleStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            LongDoubleToNumber((long double)values[i], modes[m].precision, modes[m].mode, &number);
+        }
+
+        Measurement longDoubleTime = longDoubleStopwatch.elapsed();
+        sprintf(variant, "%s long double (x%.2f)", modes[m].name, doubleTime.seconds / longDoubleTime.seconds);
+        report("LongDouble", variant, count, longDoubleTime);
+
+#if defined(__SIZEOF_FLOAT128__) && defined(__SIZEOF_INT128__)
+        Stopwatch float128Stopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            Float128ToNumber((__float128)values[i], modes[m].precision, modes[m].mode, &number);
+        }
+
+        Measurement float128Time = float128Stopwatch.elapsed();
+        sprintf(variant, "%s float128 (x%.2f)", modes[m].name, doubleTime.seconds / float128Time.seconds);
+        report("LongDouble", variant, count, float128Time);
+#endif
+    }
+
+    // Random x87 long doubles over the whole exponent range. On targets where long double
+    // is a double this measures the double path again.
+    const size_t wideCount = 16 * 1024;
+    std::vector<long double> wideValues(wideCount);
+    std::mt19937_64 random(42);
+    for (size_t i = 0; i < wideCount; ++i)
+    {
+        long double scale = (long double)(random() % 1000000) / 1000000 + 1;
+        int exponent = (int)(random() % 32000) - 16000;
+        wideValues[i] = ldexpl(scale, exponent);
+    }
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m)
+    {
+        Stopwatch stopwatch;
+        for (size_t i = 0; i < wideCount; ++i)
+        {
+            LongDoubleToNumber(wideValues[i], modes[m].precision, modes[m].mode, &number);
+        }
+
+        sprintf(variant, "%s full range", modes[m].name);
+        report("LongDouble", variant, wideCount, stopwatch.elapsed());
+    }
+}
+
+// Parsing our own output back: ParseDouble against strtod on the same texts, for the
+// shortest digits and for 17 digits, and NumberToDouble straight from the NUMBERs.
+static void benchmarkParseDouble()
+{
+    const size_t count = 1024 * 1024;
+    std::vector<double> values = generateMixedValues(count);
+
+    const int precisions[] = { 0, 17 };
+    for (size_t p = 0; p < sizeof(precisions) / sizeof(precisions[0]); ++p)
+    {
+        const char* name = precisions[p] == 0 ? "shortest" : "17 digits";
+
+        // All texts null terminated back to back, for strtod.
+        std::vector<char> texts;
+        std::vector<size_t> offsets;
+        std::vector<NUMBER> numbers(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            char text[32];
+            DoubleToCharsResult<char> result = precisions[p] == 0
+                ? DoubleToChars(text, text + sizeof(text), values[i])
+                : DoubleToChars(text, text + sizeof(text), values[i], CHARS_FORMAT_SCIENTIFIC, precisions[p] - 1);
+            offsets.push_back(texts.size());
+            texts.insert(texts.end(), text, result.ptr);
+            texts.push_back(0);
+
+            DoubleToNumber(values[i], precisions[p], precisions[p] == 0 ? DTN_SHORTEST : DTN_PRECISION, &numbers[i]);
+        }
+
+        offsets.push_back(texts.size());
+
+        // The sums keep the compiler from dropping the loops.
+        double strtodSum = 0;
+        Stopwatch strtodStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            strtodSum += strtod(&texts[offsets[i]], NULL);
+        }
+
+        Measurement strtodTime = strtodStopwatch.elapsed();
+
+        double parseSum = 0;
+        Stopwatch parseStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            double value = 0;
+            ParseDouble(&texts[offsets[i]], &texts[offsets[i + 1] - 1], &value);
+            parseSum += value;
+        }
+
+        Measurement parseTime = parseStopwatch.elapsed();
+
+        double numberSum = 0;
+        Stopwatch numberStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            double value = 0;
+            NumberToDouble(&numbers[i], &value);
+            numberSum += value;
+        }
+
+        Measurement numberTime = numberStopwatch.elapsed();
+
+        if (parseSum != strtodSum || numberSum != strtodSum)
+        {
+            printf("ParseDouble: results differ from strtod\n");
+        }
+
+        char variant[64];
+        sprintf(variant, "%s, strtod", name);
+        report("ParseDouble", variant, count, strtodTime);
+        sprintf(variant, "%s (x%.2f)", name, strtodTime.seconds / parseTime.seconds);
+        report("ParseDouble", variant, count, parseTime);
+        sprintf(variant, "%s, NumberToDouble (x%.2f)", name, strtodTime.seconds / numberTime.seconds);
+        report("ParseDouble", variant, count, numberTime);
+    }
+}
+
+// Counted digits from the BigNum path against the whole DoubleToNumber, which answers up
+// to 17 digits from Grisu, over the range of precisions. BigNum divides out several
+// digits per step, so its cost grows in steps of BigNum::DIGITCHUNKCOUNT digits.
+static void benchmarkDigitChunks()
+{
+    const size_t count = 256 * 1024;
+    std::vector<double> values = generateMixedValues(count);
+
+    char digits[NUMBER_MAXDIGITS + 1];
+    int dec = 0;
+    int sign = 0;
+    NUMBER number;
+
+    const int precisions[] = { 1, 2, 4, 8, 9, 10, 15, 17, 18, 19, 25, 27, 30, 36, 40, 45, 50 };
+    for (size_t p = 0; p < sizeof(precisions) / sizeof(precisions[0]); ++p)
+    {
+        Stopwatch bigNumStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            Dragon4Double(values[i], precisions[p], digits, &dec, &sign);
+        }
+
+        Measurement bigNumTime = bigNumStopwatch.elapsed();
+
+        Stopwatch numberStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            DoubleToNumber(values[i], precisions[p], &number);
+        }
+
+        Measurement numberTime = numberStopwatch.elapsed();
+
+        char variant[64];
+        sprintf(variant, "precision %d, BigNum", precisions[p]);
+        report("DigitChunks", variant, count, bigNumTime);
+        sprintf(variant, "precision %d, DoubleToNumber", precisions[p]);
+        report("DigitChunks", variant, count, numberTime);
+    }
+}
+
+// DoubleToNumber on values sorted by how wide the arithmetic for their digits has to be:
+// integers below 2^53, prices with two decimals and values between 1e-5 and 1e19 fit
+// into native integers, random bit patterns mostly need BigNum. Precision 30 is beyond
+// Grisu, so every value goes through Dragon4 there.
+static void benchmarkNativeTiers()
+{
+    const size_t count = 256 * 1024;
+    std::mt19937_64 random(42);
+    std::vector<double> integers(count);
+    std::vector<double> prices(count);
+    std::vector<double> moderates(count);
+    std::vector<double> wides(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        integers[i] = (double)(random() >> (11 + random() % 40));
+        prices[i] = (double)(random() % 10000000) / 100;
+
+        // 2^-17 to 2^63.
+        uint64_t bits = (random() & 0x000FFFFFFFFFFFFF) | ((uint64_t)(1006 + random() % 80) << 52);
+        memcpy(&moderates[i], &bits, sizeof(double));
+
+        bits = random() & 0x7FEFFFFFFFFFFFFF;
+        memcpy(&wides[i], &bits, sizeof(double));
+    }
+
+    const struct
+    {
+        const char* name;
+        const std::vector<double>* values;
+    } sets[] =
+    {
+        { "integers", &integers },
+        { "prices", &prices },
+        { "1e-5 to 1e19", &moderates },
+        { "random bits", &wides },
+    };
+
+    const struct
+    {
+        const char* name;
+        DoubleToNumberMode mode;
+        int precision;
+    } modes[] =
+    {
+        { "precision 17", DTN_PRECISION, 17 },
+        { "precision 30", DTN_PRECISION, 30 },
+        { "fixed 6", DTN_FIXED, 6 },
+        { "shortest", DTN_SHORTEST, 0 },
+    };
+
+    NUMBER number;
+    for (size_t s = 0; s < sizeof(sets) / sizeof(sets[0]); ++s)
+    {
+        const std::vector<double>& values = *sets[s].values;
+        for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m)
+        {
+            Stopwatch stopwatch;
+            for (size_t i = 0; i < count; ++i)
+            {
+                DoubleToNumber(values[i], modes[m].precision, modes[m].mode, &number);
+            }
+
+            char variant[64];
+            sprintf(variant, "%s, %s", sets[s].name, modes[m].name);
+            report("NativeTiers", variant, count, stopwatch.elapsed());
+        }
+    }
+}
+
+enum Distribution
+{
+    DISTRIBUTION_UNIFORMBITS,
+    DISTRIBUTION_PRICES,
+    DISTRIBUTION_SMALLINTEGERS,
+    DISTRIBUTION_SUBNORMALS,
+    DISTRIBUTION_HUGEEXPONENTS,
+    DISTRIBUTION_COUNT,
+};
+
+static const char* const distributionNames[DISTRIBUTION_COUNT] =
+{
+    "uniform bits",
+    "prices",
+    "small integers",
+    "subnormals",
+    "huge exponents",
+};
+
+// Positive finite doubles of one kind: uniformly random bit patterns, prices with two
+// decimals below 100000, integers below 100000, subnormals, and values beyond 1e+-290.
+static std::vector<double> generateValues(Distribution distribution, size_t count)
+{
+    std::mt19937_64 random(42);
+    std::vector<double> values(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t bits = random();
+        switch (distribution)
+        {
+        case DISTRIBUTION_UNIFORMBITS:
+            bits &= 0x7FEFFFFFFFFFFFFF;
+            break;
+        case DISTRIBUTION_PRICES:
+            values[i] = (double)(bits % 10000000) / 100;
+            continue;
+        case DISTRIBUTION_SMALLINTEGERS:
+            values[i] = (double)(bits % 100000);
+            continue;
+        case DISTRIBUTION_SUBNORMALS:
+            bits = (bits & 0x000FFFFFFFFFFFFF) | 1;
+            break;
+        default:
+        {
+            // Biased exponents 1 to 63 and 1983 to 2046.
+            uint64_t exponent = 1 + (bits >> 52) % 63;
+            bits = (bits & 0x000FFFFFFFFFFFFF) | ((bits & 1) != 0 ? 2047 - exponent : exponent) << 52;
+            break;
+        }
+        }
+
+        memcpy(&values[i], &bits, sizeof(double));
+    }
+
+    return values;
+}
+
+// DoubleToNumber and DoubleToChars against snprintf and std::to_chars producing the same
+// text, for each distribution: 17 significant digits and the shortest round trip digits.
+// _ecvt2 shows what the allocating API costs on top of _ecvt2_s.
+static void benchmarkDistributions()
+{
+    const size_t count = 256 * 1024;
+    char text[64];
+    char variant[64];
+    NUMBER number;
+
+    // The lengths keep the compiler from dropping the loops.
+    size_t length = 0;
+
+    for (int d = 0; d < DISTRIBUTION_COUNT; ++d)
+    {
+        std::vector<double> values = generateValues((Distribution)d, count);
+        const char* name = distributionNames[d];
+
+        Stopwatch numberStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            DoubleToNumber(values[i], 17, &number);
+            length += number.digits[0];
+        }
+
+        Measurement numberTime = numberStopwatch.elapsed();
+
+        Stopwatch ecvtStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            int dec = 0;
+            int sign = 0;
+            char* digits = _ecvt2(values[i], 17, &dec, &sign);
+            length += digits[0];
+            free(digits);
+        }
+
+        Measurement ecvtTime = ecvtStopwatch.elapsed();
+
+        Stopwatch snprintfStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            length += snprintf(text, sizeof(text), "%.16e", values[i]);
+        }
+
+        Measurement snprintfTime = snprintfStopwatch.elapsed();
+
+        Stopwatch charsStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            length += DoubleToChars(text, text + sizeof(text), values[i], CHARS_FORMAT_SCIENTIFIC, 16).ptr - text;
+        }
+
+        Measurement charsTime = charsStopwatch.elapsed();
+
+        Stopwatch shortestStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            length += DoubleToChars(text, text + sizeof(text), values[i]).ptr - text;
+        }
+
+        Measurement shortestTime = shortestStopwatch.elapsed();
+
+        sprintf(variant, "%s, DoubleToNumber 17", name);
+        report("Distributions", variant, count, numberTime);
+        sprintf(variant, "%s, _ecvt2 17", name);
+        report("Distributions", variant, count, ecvtTime);
+        sprintf(variant, "%s, snprintf %%.16e", name);
+        report("Distributions", variant, count, snprintfTime);
+        sprintf(variant, "%s, DoubleToChars %%.16e (x%.2f)", name, snprintfTime.seconds / charsTime.seconds);
+        report("Distributions", variant, count, charsTime);
+
+#if BENCHMARK_HAS_TO_CHARS
+        Stopwatch stdCharsStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            length += std::to_chars(text, text + sizeof(text), values[i], std::chars_format::scientific, 16).ptr - text;
+        }
+
+        Measurement stdCharsTime = stdCharsStopwatch.elapsed();
+
+        Stopwatch stdShortestStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            length += std::to_chars(text, text + sizeof(text), values[i]).ptr - text;
+        }
+
+        Measurement stdShortestTime = stdShortestStopwatch.elapsed();
+
+        sprintf(variant, "%s, std::to_chars %%.16e", name);
+        report("Distributions", variant, count, stdCharsTime);
+        sprintf(variant, "%s, std::to_chars shortest", name);
+        report("Distributions", variant, count, stdShortestTime);
+        sprintf(variant, "%s, DoubleToChars shortest (x%.2f)", name, stdShortestTime.seconds / shortestTime.seconds);
+#else
+        sprintf(variant, "%s, DoubleToChars shortest", name);
+#endif
+        report("Distributions", variant, count, shortestTime);
+    }
+
+    if (length == 0)
+    {
+        printf("Distributions: no output\n");
+    }
+}
+
+// The operands of Dragon4 for one value (Step 3 of Dragon4Cutoff): the power of two of
+// the binary exponent (times the mantissa if it is positive), the power of ten of the
+// decimal exponent, and the numerator and denominator prepared for dividing out a chunk
+// of digits.
+struct BigNumOperands
+{
+    uint64_t shiftInput;
+    int shift;
+    int tenExponent;
+    BigNum shifted;
+    BigNum power;
+    BigNum numerator;
+    BigNum denominator;
+};
+
+static void setBigNumOperands(double value, BigNumOperands* pOperands)
+{
+    const FPDOUBLE* pValue = (const FPDOUBLE*)&value;
+    uint64_t mantissa = ((uint64_t)pValue->mantHi << 32) | pValue->mantLo;
+    int exponent = -1074;
+    if (pValue->exp > 0)
+    {
+        mantissa += (uint64_t)1 << 52;
+        exponent = pValue->exp - 1075;
+    }
+
+    int firstDigitExponent = (int)(ceil(double((int)BigNum::logBase2(mantissa) + exponent) * 0.30102999566398119521373889472449 - 0.69));
+
+    pOperands->shiftInput = exponent < 0 ? 1 : mantissa;
+    pOperands->shift = exponent < 0 ? -exponent : exponent;
+    pOperands->tenExponent = firstDigitExponent < 0 ? -firstDigitExponent : firstDigitExponent;
+    BigNum::shiftLeft(pOperands->shiftInput, pOperands->shift, pOperands->shifted);
+    BigNum::pow10(pOperands->tenExponent, pOperands->power);
+
+    // value = numerator / denominator * 10^firstDigitExponent
+    BigNum* pScaled = exponent < 0 ? &pOperands->denominator : &pOperands->numerator;
+    BigNum* pOther = exponent < 0 ? &pOperands->numerator : &pOperands->denominator;
+    *pScaled = pOperands->shifted;
+    pOther->setUInt64(exponent < 0 ? mantissa : 1);
+    if (firstDigitExponent > 0)
+    {
+        pOperands->denominator.multiply(pOperands->power);
+    }
+    else
+    {
+        pOperands->numerator.multiply(pOperands->power);
+    }
+
+    if (BigNum::compare(pOperands->numerator, pOperands->denominator) >= 0)
+    {
+        pOperands->denominator.multiply(10);
+    }
+
+    BigNum::prepareChunkDivide(&pOperands->numerator, &pOperands->denominator);
+    pOperands->numerator.multiply(1000000000);
+}
+
+// The BigNum primitives on the operands Dragon4 builds for each distribution. In-place
+// operations work on a copy of their input, which is timed as well.
+static void benchmarkBigNumPrimitives()
+{
+    const size_t count = 16 * 1024;
+    const int rounds = 16;
+    const char* backend = BigNum::BLOCKBITS == 64 ? "64 bit" : "32 bit";
+    std::vector<BigNumOperands> operands(count);
+    char variant[64];
+    BigNum result;
+    uint64_t sum = 0;
+
+    for (int d = 0; d < DISTRIBUTION_COUNT; ++d)
+    {
+        std::vector<double> values = generateValues((Distribution)d, count);
+        const char* name = distributionNames[d];
+        for (size_t i = 0; i < count; ++i)
+        {
+            setBigNumOperands(values[i], &operands[i]);
+        }
+
+        Stopwatch pow10Stopwatch;
+        for (int r = 0; r < rounds; ++r)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                BigNum::pow10(operands[i].tenExponent, result);
+                sum += result.isZero();
+            }
+        }
+
+        Measurement pow10Time = pow10Stopwatch.elapsed();
+
+        Stopwatch shiftStopwatch;
+        for (int r = 0; r < rounds; ++r)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                BigNum::shiftLeft(operands[i].shiftInput, operands[i].shift, result);
+                sum += result.isZero();
+            }
+        }
+
+        Measurement shiftTime = shiftStopwatch.elapsed();
+
+        Stopwatch multiplyStopwatch;
+        for (int r = 0; r < rounds; ++r)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                BigNum::multiply(operands[i].shifted, operands[i].power, result);
+                sum += result.isZero();
+            }
+        }
+
+        Measurement multiplyTime = multiplyStopwatch.elapsed();
+
+        Stopwatch multiplyUInt32Stopwatch;
+        for (int r = 0; r < rounds; ++r)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                BigNum::multiply(operands[i].denominator, 1000000000, result);
+                sum += result.isZero();
+            }
+        }
+
+        Measurement multiplyUInt32Time = multiplyUInt32Stopwatch.elapsed();
+
+        Stopwatch divideStopwatch;
+        for (int r = 0; r < rounds; ++r)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                result = operands[i].numerator;
+                sum += BigNum::heuristicDivide(&result, operands[i].denominator);
+            }
+        }
+
+        Measurement divideTime = divideStopwatch.elapsed();
+
+        sprintf(variant, "%s, %s, pow10", backend, name);
+        report("BigNumPrimitives", variant, count * rounds, pow10Time);
+        sprintf(variant, "%s, %s, shiftLeft", backend, name);
+        report("BigNumPrimitives", variant, count * rounds, shiftTime);
+        sprintf(variant, "%s, %s, multiply", backend, name);
+        report("BigNumPrimitives", variant, count * rounds, multiplyTime);
+        sprintf(variant, "%s, %s, multiply uint32", backend, name);
+        report("BigNumPrimitives", variant, count * rounds, multiplyUInt32Time);
+        sprintf(variant, "%s, %s, heuristicDivide", backend, name);
+        report("BigNumPrimitives", variant, count * rounds, divideTime);
+    }
+
+    if (sum == 0)
+    {
+        printf("BigNumPrimitives: no output\n");
+    }
+}
+
+// The upper bound in ticks of the histogram bucket below which `fraction` of the
+// entries lie.
+static uint64_t histogramPercentile(const uint64_t* buckets, double fraction)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < CONVERSIONSTATS_BUCKETCOUNT; ++i)
+    {
+        total += buckets[i];
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < CONVERSIONSTATS_BUCKETCOUNT; ++i)
+    {
+        seen += buckets[i];
+        if (seen >= fraction * total)
+        {
+            return (uint64_t)2 << i;
+        }
+    }
+
+    return 0;
+}
+
+// What the instrumentation of a DOUBLETONUMBER_STATS build sees for 17 digits and the
+// shortest digits of each distribution: which engine served the calls, how often the
+// slow paths had to correct themselves, the latency percentiles and the slowest input.
+static void benchmarkConversionStats()
+{
+    ConversionStats stats;
+    GetConversionStats(&stats);
+    if (!stats.isEnabled)
+    {
+        printf("ConversionStats: disabled, build with DOUBLETONUMBER_STATS=1\n");
+        return;
+    }
+
+    static const char* const engineNames[CONVERSIONENGINE_COUNT] = { "uint64", "grisu", "native64", "native128", "bignum" };
+    static const char* const phaseNames[CONVERSIONPHASE_COUNT] = { "call", "scale", "digits", "round" };
+
+    const size_t count = 256 * 1024;
+    NUMBER number;
+    for (int d = 0; d < DISTRIBUTION_COUNT; ++d)
+    {
+        std::vector<double> values = generateValues((Distribution)d, count);
+
+        ResetConversionStats();
+        for (size_t i = 0; i < count; ++i)
+        {
+            DoubleToNumber(values[i], 17, &number);
+            DoubleToNumber(values[i], 0, DTN_SHORTEST, &number);
+        }
+
+        GetConversionStats(&stats);
+
+        if (isJsonOutput)
+        {
+            printf("{\"benchmark\":\"ConversionStats\",\"variant\":\"%s\",\"calls\":%zu", distributionNames[d], count * 2);
+            for (int i = 0; i < CONVERSIONENGINE_COUNT; ++i)
+            {
+                printf(",\"%s\":%llu", engineNames[i], (unsigned long long)stats.engineCalls[i]);
+            }
+
+            printf(",\"exponentFixups\":%llu,\"quotientCorrections\":%llu,\"divideShifts\":%llu,\"carryPropagations\":%llu,\"maxBigNumLength\":%llu",
+                (unsigned long long)stats.exponentFixups, (unsigned long long)stats.quotientCorrections,
+                (unsigned long long)stats.divideShifts, (unsigned long long)stats.carryPropagations,
+                (unsigned long long)stats.maxBigNumLength);
+
+            for (int i = 0; i < CONVERSIONPHASE_COUNT; ++i)
+            {
+                printf(",\"%sP50\":%llu,\"%sP999\":%llu", phaseNames[i], (unsigned long long)histogramPercentile(stats.phaseHistograms[i], 0.5),
+                    phaseNames[i], (unsigned long long)histogramPercentile(stats.phaseHistograms[i], 0.999));
+            }
+
+            printf(",\"slowestTicks\":%llu}\n", (unsigned long long)stats.slowestCallTicks);
+            continue;
+        }
+
+        printf("ConversionStats    %s, %zu calls\n", distributionNames[d], count * 2);
+        printf("  engines:");
+        for (int i = 0; i < CONVERSIONENGINE_COUNT; ++i)
+        {
+            printf(" %s %.1f%%", engineNames[i], 100.0 * stats.engineCalls[i] / (count * 2));
+        }
+
+        printf("\n  exponent fixups %llu, quotient corrections %llu, divide shifts %llu, 9-carries %llu, max BigNum blocks %llu\n",
+            (unsigned long long)stats.exponentFixups, (unsigned long long)stats.quotientCorrections,
+            (unsigned long long)stats.divideShifts, (unsigned long long)stats.carryPropagations,
+            (unsigned long long)stats.maxBigNumLength);
+
+        for (int i = 0; i < CONVERSIONPHASE_COUNT; ++i)
+        {
+            printf("  %-6s ticks p50 < %llu, p99 < %llu, p99.9 < %llu\n", phaseNames[i],
+                (unsigned long long)histogramPercentile(stats.phaseHistograms[i], 0.5),
+                (unsigned long long)histogramPercentile(stats.phaseHistograms[i], 0.99),
+                (unsigned long long)histogramPercentile(stats.phaseHistograms[i], 0.999));
+        }
+
+        printf("  slowest call %llu ticks: mantissa 0x%llX * 2^%d\n", (unsigned long long)stats.slowestCallTicks,
+            (unsigned long long)stats.slowestMantissaLow, stats.slowestExponent);
+    }
+
+    fflush(stdout);
+}
+
+// DoubleToNumber against DoubleToNumberCache on streams which repeat values the way
+// exports do: draws from a pool of distinct mixed values with Zipf (s = 1) frequencies,
+// so a few values make up most of the stream. The pools are smaller than, about as large
+// as and much larger than the default cache with its 1024 slots.
+static void benchmarkDoubleToNumberCache()
+{
+    const size_t count = 1024 * 1024;
+    const size_t poolSizes[] = { 256, 4096, 256 * 1024 };
+
+    const struct
+    {
+        const char* name;
+        DoubleToNumberMode mode;
+        int precision;
+    } modes[] =
+    {
+        { "precision 17", DTN_PRECISION, 17 },
+        { "shortest", DTN_SHORTEST, 0 },
+    };
+
+    NUMBER number;
+    for (size_t p = 0; p < sizeof(poolSizes) / sizeof(poolSizes[0]); ++p)
+    {
+        std::vector<double> pool = generateMixedValues(poolSizes[p]);
+        std::vector<double> weights(poolSizes[p]);
+        for (size_t i = 0; i < weights.size(); ++i)
+        {
+            weights[i] = 1.0 / (i + 1);
+        }
+
+        std::mt19937_64 random(42);
+        std::discrete_distribution<size_t> zipf(weights.begin(), weights.end());
+        std::vector<double> values(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            values[i] = pool[zipf(random)];
+        }
+
+        for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m)
+        {
+            Stopwatch stopwatch;
+            for (size_t i = 0; i < count; ++i)
+            {
+                DoubleToNumber(values[i], modes[m].precision, modes[m].mode, &number);
+            }
+
+            char variant[64];
+            sprintf(variant, "%zu distinct, %s, uncached", poolSizes[p], modes[m].name);
+            report("DoubleToNumberCache", variant, count, stopwatch.elapsed());
+
+            DoubleToNumberCache cache;
+            Stopwatch cachedStopwatch;
+            for (size_t i = 0; i < count; ++i)
+            {
+                cache.convert(values[i], modes[m].precision, modes[m].mode, &number);
+            }
+
+            Measurement cachedTime = cachedStopwatch.elapsed();
+            sprintf(variant, "%zu distinct, %s, cached (%.1f%% hits)", poolSizes[p], modes[m].name,
+                100.0 * cache.hitCount() / count);
+            report("DoubleToNumberCache", variant, count, cachedTime);
+        }
+    }
+}
+
+// Buffering converted values as NUMBER against PACKEDNUMBER: converting straight into
+// either array, and the conversions between the two.
+static void benchmarkPackedNumber()
+{
+    const size_t count = 1024 * 1024;
+    std::vector<double> values = generateMixedValues(count);
+    std::vector<NUMBER> numbers(count);
+    std::vector<PACKEDNUMBER> packed(count);
+
+    const struct
+    {
+        const char* name;
+        DoubleToNumberMode mode;
+        int precision;
+    } modes[] =
+    {
+        { "precision 17", DTN_PRECISION, 17 },
+        { "shortest", DTN_SHORTEST, 0 },
+    };
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m)
+    {
+        char variant[64];
+        Stopwatch numberStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            DoubleToNumber(values[i], modes[m].precision, modes[m].mode, &numbers[i]);
+        }
+
+        sprintf(variant, "%s, DoubleToNumber (%zu bytes)", modes[m].name, sizeof(NUMBER));
+        report("PackedNumber", variant, count, numberStopwatch.elapsed());
+
+        Stopwatch packedStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            DoubleToPackedNumber(values[i], modes[m].precision, modes[m].mode, &packed[i]);
+        }
+
+        sprintf(variant, "%s, DoubleToPackedNumber (%zu bytes)", modes[m].name, sizeof(PACKEDNUMBER));
+        report("PackedNumber", variant, count, packedStopwatch.elapsed());
+
+        Stopwatch packStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            PackNumber(numbers[i], &packed[i]);
+        }
+
+        sprintf(variant, "%s, PackNumber", modes[m].name);
+        report("PackedNumber", variant, count, packStopwatch.elapsed());
+
+        Stopwatch unpackStopwatch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            UnpackNumber(packed[i], &numbers[i]);
+        }
+
+        sprintf(variant, "%s, UnpackNumber", modes[m].name);
+        report("PackedNumber", variant, count, unpackStopwatch.elapsed());
+    }
+}
+
+// Columnar output against an array of NUMBER: DoubleToNumberBatch for 17 digits and a
+// DoubleToNumber loop for the shortest digits, then DoubleToNumberColumns without and
+// with a validity bitmap marking every tenth value null.
+static void benchmarkColumns()
+{
+    const size_t count = 1024 * 1024;
+    std::vector<double> values = generateMixedValues(count);
+    std::vector<NUMBER> numbers(count);
+    std::vector<uint8_t> validity((count + 7) / 8, 0xFF);
+    for (size_t i = 0; i < count; i += 10)
+    {
+        validity[i / 8] &= (uint8_t)~(1 << (i % 8));
+    }
+
+    std::vector<char> digits(DoubleToNumberColumnsCapacity(count, 17, DTN_PRECISION));
+    std::vector<int32_t> offsets(count + 1);
+    std::vector<int> scales(count);
+    std::vector<uint8_t> signs(count);
+    std::vector<int> precisions(count);
+    NumberColumns columns = { digits.data(), offsets.data(), scales.data(), signs.data(), precisions.data() };
+
+    Stopwatch batchStopwatch;
+    DoubleToNumberBatch(values.data(), count, 17, numbers.data());
+    report("Columns", "precision 17, DoubleToNumberBatch", count, batchStopwatch.elapsed());
+
+    Stopwatch columnsStopwatch;
+    DoubleToNumberColumns(values.data(), NULL, count, 17, DTN_PRECISION, columns);
+    report("Columns", "precision 17, columns", count, columnsStopwatch.elapsed());
+
+    Stopwatch nullsStopwatch;
+    DoubleToNumberColumns(values.data(), validity.data(), count, 17, DTN_PRECISION, columns);
+    report("Columns", "precision 17, columns, 10% nulls", count, nullsStopwatch.elapsed());
+
+    Stopwatch loopStopwatch;
+    for (size_t i = 0; i < count; ++i)
+    {
+        DoubleToNumber(values[i], 0, DTN_SHORTEST, &numbers[i]);
+    }
+
+    report("Columns", "shortest, DoubleToNumber loop", count, loopStopwatch.elapsed());
+
+    Stopwatch shortestStopwatch;
+    DoubleToNumberColumns(values.data(), NULL, count, 0, DTN_SHORTEST, columns);
+    report("Columns", "shortest, columns", count, shortestStopwatch.elapsed());
+
+    Stopwatch shortestNullsStopwatch;
+    DoubleToNumberColumns(values.data(), validity.data(), count, 0, DTN_SHORTEST, columns);
+    report("Columns", "shortest, columns, 10% nulls", count, shortestNullsStopwatch.elapsed());
+}
+
+// The digit string path DoubleToDecimal replaces: parse the digits of a NUMBER back into
+// a coefficient and drop the trailing zeros after the decimal point. Assumes the scale
+// fits, which it does for the values of benchmarkDecimal.
+static void numberToDecimal(const NUMBER& number, DECIMAL96* decimal)
+{
+    DecimalCoefficient coefficient;
+    int count = 0;
+    for (; number.digits[count] != 0; ++count)
+    {
+        coefficient.multiplyAdd(10, (uint32_t)(number.digits[count] - '0'));
+    }
+
+    int exponent10 = number.scale - count + 1;
+    for (; exponent10 > 0; --exponent10)
+    {
+        coefficient.multiplyAdd(10, 0);
+    }
+
+    for (; exponent10 < 0; ++exponent10)
+    {
+        DecimalCoefficient quotient = coefficient;
+        if (quotient.divide(10) != 0)
+        {
+            break;
+        }
+
+        coefficient = quotient;
+    }
+
+    decimal->lo = coefficient.word(0);
+    decimal->mid = coefficient.word(1);
+    decimal->hi = coefficient.word(2);
+    decimal->scale = -exponent10;
+    decimal->sign = number.sign;
+}
+
+// DoubleToDecimal against DoubleToNumber followed by parsing the digits, for 15 digits
+// (what System.Decimal takes from a double) and 17, on prices and on values between
+// 1e-5 and 1e15.
+static void benchmarkDecimal()
+{
+    const size_t count = 1024 * 1024;
+    std::mt19937_64 random(42);
+    std::vector<double> prices(count);
+    std::vector<double> moderates(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        prices[i] = (double)(random() % 10000000) / 100;
+
+        // 2^-17 to 2^50.
+        uint64_t bits = (random() & 0x000FFFFFFFFFFFFF) | ((uint64_t)(1006 + random() % 67) << 52);
+        memcpy(&moderates[i], &bits, sizeof(double));
+    }
+
+    const struct
+    {
+        const char* name;
+        const std::vector<double>* values;
+    } sets[] =
+    {
+        { "prices", &prices },
+        { "1e-5 to 1e15", &moderates },
+    };
+
+    const int precisions[] = { 15, 17 };
+
+    NUMBER number;
+    DECIMAL96 decimal;
+    DECIMAL128 decimal128 = {};
+    uint64_t checksum = 0;
+    for (size_t s = 0; s < sizeof(sets) / sizeof(sets[0]); ++s)
+    {
+        const std::vector<double>& values = *sets[s].values;
+        for (size_t p = 0; p < sizeof(precisions) / sizeof(precisions[0]); ++p)
+        {
+            int precision = precisions[p];
+            char variant[64];
+
+            Stopwatch parseStopwatch;
+            for (size_t i = 0; i < count; ++i)
+            {
+                DoubleToNumber(values[i], precision, &number);
+                numberToDecimal(number, &decimal);
+                checksum += decimal.lo;
+            }
+
+            sprintf(variant, "%s, %d digits, DoubleToNumber + parse", sets[s].name, precision);
+            report("Decimal", variant, count, parseStopwatch.elapsed());
+
+            Stopwatch decimalStopwatch;
+            for (size_t i = 0; i < count; ++i)
+            {
+                DoubleToDecimal(values[i], precision, &decimal);
+                checksum += decimal.lo;
+            }
+
+            sprintf(variant, "%s, %d digits, DoubleToDecimal", sets[s].name, precision);
+            report("Decimal", variant, count, decimalStopwatch.elapsed());
+
+            Stopwatch decimal128Stopwatch;
+            for (size_t i = 0; i < count; ++i)
+            {
+                DoubleToDecimal128(values[i], precision, &decimal128);
+                checksum += decimal128.low;
+            }
+
+            sprintf(variant, "%s, %d digits, DoubleToDecimal128", sets[s].name, precision);
+            report("Decimal", variant, count, decimal128Stopwatch.elapsed());
+        }
+    }
+
+    // Keeps the conversions from being optimized away.
+    if (checksum == 42)
+    {
+        printf("\n");
+    }
+}
+
+// Compiled format plans against snprintf with the equivalent specifier, on prices and on
+// mixed values. printf has no group separators in the "C" locale, so N2 runs against
+// %.2f, and no shortest digits, so R runs against %.17g.
+static void benchmarkFormat()
+{
+    const size_t count = 1024 * 1024;
+    std::mt19937_64 random(42);
+    std::vector<double> prices(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        prices[i] = (double)(random() % 100000000) / 100;
+    }
+
+    std::vector<double> mixed = generateMixedValues(count);
+
+    const struct
+    {
+        const char* name;
+        const std::vector<double>* values;
+    } sets[] =
+    {
+        { "prices", &prices },
+        { "mixed", &mixed },
+    };
+
+    const struct
+    {
+        const char* format;
+        const char* printfFormat;
+    } specifiers[] =
+    {
+        { "F2", "%.2f" },
+        { "N2", "%.2f" },
+        { "E10", "%.10E" },
+        { "G17", "%.17G" },
+        { "R", "%.17g" },
+    };
+
+    // Room for the N2 text of the largest doubles.
+    char text[512];
+    uint64_t checksum = 0;
+    for (size_t s = 0; s < sizeof(sets) / sizeof(sets[0]); ++s)
+    {
+        const std::vector<double>& values = *sets[s].values;
+        for (size_t f = 0; f < sizeof(specifiers) / sizeof(specifiers[0]); ++f)
+        {
+            char variant[64];
+
+            Stopwatch snprintfStopwatch;
+            for (size_t i = 0; i < count; ++i)
+            {
+                checksum += snprintf(text, sizeof(text), specifiers[f].printfFormat, values[i]);
+            }
+
+            Measurement snprintfTime = snprintfStopwatch.elapsed();
+            sprintf(variant, "%s, snprintf %s", sets[s].name, specifiers[f].printfFormat);
+            report("Format", variant, count, snprintfTime);
+
+            DoubleFormat plan;
+            plan.compile(specifiers[f].format);
+
+            Stopwatch planStopwatch;
+            for (size_t i = 0; i < count; ++i)
+            {
+                checksum += plan.format(text, text + sizeof(text), values[i]).ptr - text;
+            }
+
+            Measurement planTime = planStopwatch.elapsed();
+            sprintf(variant, "%s, DoubleFormat %s (x%.2f)", sets[s].name, specifiers[f].format, snprintfTime.seconds / planTime.seconds);
+            report("Format", variant, count, planTime);
+        }
+    }
+
+    // Keeps the conversions from being optimized away.
+    if (checksum == 42)
+    {
+        printf("\n");
+    }
+}
+
+struct BenchmarkEntry
+{
+    const char* name;
+    void (*function)();
+};
+
+static const BenchmarkEntry benchmarks[] =
+{
+    { "ParallelConvert", benchmarkParallelConvert },
+    { "BigNumBackend", benchmarkBigNumBackend },
+    { "StreamWriter", benchmarkStreamWriter },
+    { "FloatToNumber", benchmarkFloatToNumber },
+    { "LongDouble", benchmarkLongDouble },
+    { "ParseDouble", benchmarkParseDouble },
+    { "DigitChunks", benchmarkDigitChunks },
+    { "NativeTiers", benchmarkNativeTiers },
+    { "Distributions", benchmarkDistributions },
+    { "BigNumPrimitives", benchmarkBigNumPrimitives },
+    { "ConversionStats", benchmarkConversionStats },
+    { "DoubleToNumberCache", benchmarkDoubleToNumberCache },
+    { "PackedNumber", benchmarkPackedNumber },
+    { "Columns", benchmarkColumns },
+    { "Decimal", benchmarkDecimal },
+    { "Format", benchmarkFormat },
+};
+
+int main(int argc, char** argv)
+{
+    const char* filter = "";
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--json") == 0)
+        {
+            isJsonOutput = true;
+        }
+        else
+        {
+            filter = argv[i];
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); ++i)
+    {
+        if (strstr(benchmarks[i].name, filter) != NULL)
+        {
+            benchmarks[i].function();
+        }
+    }
+
+    return 0;
+}
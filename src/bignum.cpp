@@ -1,10 +1,9 @@
 #include "bignum.h"
 #include <algorithm>
-#include <cassert>
 
 using std::swap;
 
-uint32_t BigNum::m_power10UInt32Table[UINT32POWER10NUM] =
+const uint32_t BigNumBase::m_power10UInt32Table[UINT32POWER10NUM] =
 {
     1,          // 10^0
     10,         // 10^1
@@ -15,91 +14,27 @@ uint32_t BigNum::m_power10UInt32Table[UINT32POWER10NUM] =
     1000000,    // 10^6
     10000000,   // 10^7
 };
-
-BigNum BigNum::m_power10BigNumTable[BIGPOWER10NUM];
-BigNum::StaticInitializer BigNum::m_initializer;
-
-BigNum::BigNum()
-    :m_len(0)
-{
-}
-
-BigNum::BigNum(uint32_t value)
-{
-    setUInt32(value);
-}
-
-BigNum::BigNum(uint64_t value)
-{
-    setUInt64(value);
-}
-
-BigNum::~BigNum()
-{
-}
-
-BigNum& BigNum::operator=(const BigNum &rhs)
-{
-    uint8_t length = rhs.m_len;
-    uint32_t* pCurrent = m_blocks;
-    const uint32_t* pRhsCurrent = rhs.m_blocks;
-    const uint32_t* pRhsEnd = pRhsCurrent + length;
-
-    while (pRhsCurrent != pRhsEnd)
-    {
-        *pCurrent = *pRhsCurrent;
-
-        ++pCurrent;
-        ++pRhsCurrent;
-    }
 
-    m_len = length;
-
-    return *this;
-}
-
-int BigNum::compare(const BigNum& lhs, uint32_t value)
+int BigNumBase::compare(const Block* pLhs, uint16_t lhsLength, const Block* pRhs, uint16_t rhsLength)
 {
-    if (lhs.m_len == 0)
-    {
-        return value == 0 ? 0 : -1;
-    }
-
-    uint32_t lhsValue = lhs.m_blocks[0];
-
-    if (lhsValue > value || lhs.m_len > 1)
-    {
-        return 1;
-    }
-
-    if (lhsValue < value)
-    {
-        return -1;
-    }
-
-    return 0;
-}
-
-int BigNum::compare(const BigNum& lhs, const BigNum& rhs)
-{
-    int lenDiff = lhs.m_len - rhs.m_len;
+    int lenDiff = lhsLength - rhsLength;
     if (lenDiff != 0)
     {
         return lenDiff;
     }
 
-    for (int i = lhs.m_len - 1; i >= 0; --i)
+    for (int i = lhsLength - 1; i >= 0; --i)
     {
-        if (lhs.m_blocks[i] == rhs.m_blocks[i])
+        if (pLhs[i] == pRhs[i])
         {
             continue;
         }
 
-        if (lhs.m_blocks[i] > rhs.m_blocks[i])
+        if (pLhs[i] > pRhs[i])
         {
             return 1;
         }
-        else if (lhs.m_blocks[i] < rhs.m_blocks[i])
+        else if (pLhs[i] < pRhs[i])
         {
             return -1;
         }
@@ -108,66 +43,69 @@ int BigNum::compare(const BigNum& lhs, const BigNum& rhs)
     return 0;
 }
 
-void BigNum::shiftLeft(uint64_t input, int shift, BigNum& output)
+uint16_t BigNumBase::add(const Block* pLhs, uint16_t lhsLength, const Block* pRhs, uint16_t rhsLength, Block* pResult)
 {
-    int shiftBlocks = shift / 32;
-    int remaningToShiftBits = shift % 32;
-
-    for (int i = 0; i < shiftBlocks; ++i)
+    const Block* pLargeCurrent = pLhs;
+    const Block* pSmallCurrent = pRhs;
+    uint16_t largeLength = lhsLength;
+    uint16_t smallLength = rhsLength;
+    if (lhsLength < rhsLength)
     {
-        // If blocks shifted, we should fill the corresponding blocks with zero.
-        output.extendBlock(0);
+        swap(pLargeCurrent, pSmallCurrent);
+        swap(largeLength, smallLength);
     }
 
-    if (remaningToShiftBits == 0)
+    const Block* pLargeEnd = pLargeCurrent + largeLength;
+    const Block* pSmallEnd = pSmallCurrent + smallLength;
+    Block* pResultCurrent = pResult;
+
+    // Add the blocks which both BigNums have.
+    DoubleBlock carry = 0;
+    while (pSmallCurrent != pSmallEnd)
     {
-        // We shift 32 * n (n >= 1) bits. No remaining bits.
-        output.extendBlock((uint32_t)(input & 0xFFFFFFFF));
+        DoubleBlock sum = carry + (DoubleBlock)(*pLargeCurrent) + (DoubleBlock)(*pSmallCurrent);
+        carry = sum >> BLOCKBITS;
+        *pResultCurrent = (Block)sum;
 
-        uint32_t highBits = (uint32_t)(input >> 32);
-        if (highBits != 0)
-        {
-            output.extendBlock(highBits);
-        }
+        ++pLargeCurrent;
+        ++pSmallCurrent;
+        ++pResultCurrent;
     }
-    else
+
+    // Propagate the carry through the remaining blocks of the large BigNum.
+    while (pLargeCurrent != pLargeEnd)
     {
-        // Extract the high position bits which would be shifted out of range.
-        uint32_t highPositionBits = (uint32_t)input >> (32 + 32 - remaningToShiftBits);
+        DoubleBlock sum = carry + (DoubleBlock)(*pLargeCurrent);
+        carry = sum >> BLOCKBITS;
+        *pResultCurrent = (Block)sum;
 
-        // Shift the input. The result should be stored to current block.
-        uint64_t shiftedInput = input << remaningToShiftBits;
-        output.extendBlock(shiftedInput & 0xFFFFFFFF);
+        ++pLargeCurrent;
+        ++pResultCurrent;
+    }
 
-        uint32_t highBits = (uint32_t)(input >> 32);
-        if (highBits != 0)
-        {
-            output.extendBlock(highBits);
-        }
+    if (carry != 0)
+    {
+        *pResultCurrent = (Block)carry;
+        return largeLength + 1;
+    }
 
-        if (highPositionBits != 0)
-        {
-            // If the high position bits is not 0, we should store them to next block.
-            output.extendBlock(highPositionBits);
-        }
-    }
+    return largeLength;
 }
 
-void BigNum::shiftLeft(BigNum* pResult, uint32_t shift)
+uint16_t BigNumBase::shiftLeft(Block* pBlocks, uint16_t length, uint32_t shift)
 {
-    uint32_t shiftBlocks = shift / 32;
-    uint32_t shiftBits = shift % 32;
+    uint32_t shiftBlocks = shift / BLOCKBITS;
+    uint32_t shiftBits = shift % BLOCKBITS;
 
     // process blocks high to low so that we can safely process in place
-    const uint32_t* pInBlocks = pResult->m_blocks;
-    int inLength = pResult->m_len;
+    int inLength = length;
 
     // check if the shift is block aligned
     if (shiftBits == 0)
     {
         // copy blcoks from high to low
-        for (uint32_t * pInCur = pResult->m_blocks + inLength, *pOutCur = pInCur + shiftBlocks;
-            pInCur >= pInBlocks;
+        for (Block * pInCur = pBlocks + inLength - 1, *pOutCur = pInCur + shiftBlocks;
+            pInCur >= pBlocks;
             --pInCur, --pOutCur)
         {
             *pOutCur = *pInCur;
@@ -175,347 +113,344 @@ void BigNum::shiftLeft(BigNum* pResult, uint32_t shift)
 
         // zero the remaining low blocks
         for (uint32_t i = 0; i < shiftBlocks; ++i)
-            pResult->m_blocks[i] = 0;
+            pBlocks[i] = 0;
 
-        pResult->m_len += shiftBlocks;
+        return (uint16_t)(length + shiftBlocks);
     }
-    // else we need to shift partial blocks
-    else
-    {
-        int inBlockIdx = inLength - 1;
-        uint32_t outBlockIdx = inLength + shiftBlocks;
-
-        // set the length to hold the shifted blocks
-        pResult->m_len = outBlockIdx + 1;
-
-        // output the initial blocks
-        const uint32_t lowBitsShift = (32 - shiftBits);
-        uint32_t highBits = 0;
-        uint32_t block = pResult->m_blocks[inBlockIdx];
-        uint32_t lowBits = block >> lowBitsShift;
-        while (inBlockIdx > 0)
-        {
-            pResult->m_blocks[outBlockIdx] = highBits | lowBits;
-            highBits = block << shiftBits;
 
-            --inBlockIdx;
-            --outBlockIdx;
+    // else we need to shift partial blocks
+    int inBlockIdx = inLength - 1;
+    uint32_t outBlockIdx = inLength + shiftBlocks;
 
-            block = pResult->m_blocks[inBlockIdx];
-            lowBits = block >> lowBitsShift;
-        }
+    // set the length to hold the shifted blocks
+    uint16_t outLength = (uint16_t)(outBlockIdx + 1);
 
-        // output the final blocks
-        pResult->m_blocks[outBlockIdx] = highBits | lowBits;
-        pResult->m_blocks[outBlockIdx - 1] = block << shiftBits;
+    // output the initial blocks
+    const uint32_t lowBitsShift = (BLOCKBITS - shiftBits);
+    Block highBits = 0;
+    Block block = pBlocks[inBlockIdx];
+    Block lowBits = block >> lowBitsShift;
+    while (inBlockIdx > 0)
+    {
+        pBlocks[outBlockIdx] = highBits | lowBits;
+        highBits = block << shiftBits;
 
-        // zero the remaining low blocks
-        for (uint32_t i = 0; i < shiftBlocks; ++i)
-            pResult->m_blocks[i] = 0;
+        --inBlockIdx;
+        --outBlockIdx;
 
-        // check if the terminating block has no set bits
-        if (pResult->m_blocks[pResult->m_len - 1] == 0)
-            --pResult->m_len;
+        block = pBlocks[inBlockIdx];
+        lowBits = block >> lowBitsShift;
     }
-}
 
-void BigNum::pow10(int exp, BigNum& result)
-{
-    BigNum temp1;
-    BigNum temp2;
+    // output the final blocks
+    pBlocks[outBlockIdx] = highBits | lowBits;
+    pBlocks[outBlockIdx - 1] = block << shiftBits;
 
-    BigNum* pCurrentTemp = &temp1;
-    BigNum* pNextTemp = &temp2;
+    // zero the remaining low blocks
+    for (uint32_t i = 0; i < shiftBlocks; ++i)
+        pBlocks[i] = 0;
 
-    uint32_t smallExp = exp & 0x7;
-    pCurrentTemp->setUInt32(m_power10UInt32Table[smallExp]);
+    // check if the terminating block has no set bits
+    if (pBlocks[outLength - 1] == 0)
+        --outLength;
 
-    exp >>= 3;
-    uint32_t idx = 0;
+    return outLength;
+}
 
-    while (exp != 0)
+uint16_t BigNumBase::pow10(uint32_t exp, Block* pResult)
+{
+    // Copy the largest table entry which does not exceed 10^exp.
+    const Block* pEntry = NULL;
+    uint16_t length = 0;
+    uint32_t entryExp = 0;
+#if !BIGNUM_POW10_COMPACT
+    if (exp >= POWER10LARGESTEP)
+    {
+        uint32_t idx = std::min(exp / POWER10LARGESTEP, POWER10LARGENUM - 1);
+        uint32_t offset = m_power10LargeTable.offsets[idx];
+        pEntry = m_power10LargeTable.blocks + offset;
+        length = (uint16_t)(m_power10LargeTable.offsets[idx + 1] - offset);
+        entryExp = idx * POWER10LARGESTEP;
+    }
+    else
+#endif
     {
-        // if the current bit is set, multiply it with the corresponding power of 10
-        if (exp & 1)
-        {
-            // multiply into the next temporary
-            multiply(*pCurrentTemp, m_power10BigNumTable[idx], *pNextTemp);
-
-            // swap to the next temporary
-            swap(pNextTemp, pCurrentTemp);
-        }
-
-        // advance to the next bit
-        ++idx;
-        exp >>= 1;
+        uint32_t idx = std::min(exp / POWER10TABLESTEP, POWER10TABLENUM - 1);
+        uint32_t offset = m_power10Table.offsets[idx];
+        pEntry = m_power10Table.blocks + offset;
+        length = (uint16_t)(m_power10Table.offsets[idx + 1] - offset);
+        entryExp = idx * POWER10TABLESTEP;
     }
 
-    result = *pCurrentTemp;
-}
+    memcpy(pResult, pEntry, length * sizeof(Block));
 
-void BigNum::prepareHeuristicDivide(BigNum* pDividend, BigNum* pDivisor)
-{
-    uint32_t hiBlock = pDivisor->m_blocks[pDivisor->m_len - 1];
-    if (hiBlock < 8 || hiBlock > 429496729)
+    // Multiply in what the table entry is missing. This is only needed for the compact
+    // table and beyond the range of doubles.
+    uint32_t remainingExp = exp - entryExp;
+    if (remainingExp != 0)
     {
-        // Inspired by http://www.ryanjuckett.com/programming/printing-floating-point-numbers/
-        // Perform a bit shift on all values to get the highest block of the divisor into
-        // the range [8,429496729]. We are more likely to make accurate quotient estimations
-        // in heuristicDivide() with higher divisor values so
-        // we shift the divisor to place the highest bit at index 27 of the highest block.
-        // This is safe because (2^28 - 1) = 268435455 which is less than 429496729. This means
-        // that all values with a highest bit at index 27 are within range.         
-        uint32_t hiBlockLog2 = logBase2(hiBlock);
-        uint32_t shift = (59 - hiBlockLog2) % 32;
-
-        BigNum::shiftLeft(pDivisor, shift);
-        BigNum::shiftLeft(pDividend, shift);
+        length = multiplyPow10(pResult, length, remainingExp);
     }
+
+    return length;
 }
 
-uint32_t BigNum::heuristicDivide(BigNum* pDividend, const BigNum& divisor)
+uint32_t BigNumBase::heuristicDivide(Block* pDividend, uint16_t* pDividendLength, const Block* pDivisor, uint16_t divisorLength)
 {
-    uint8_t len = divisor.m_len;
-    if (pDividend->m_len < len)
+    uint16_t len = divisorLength;
+    if (*pDividendLength < len)
     {
         return 0;
     }
 
-    const uint32_t* pFinalDivisorBlock = divisor.m_blocks + len - 1;
-    uint32_t* pFinalDividendBlock = pDividend->m_blocks + len - 1;
+    const Block* pFinalDivisorBlock = pDivisor + len - 1;
+    Block* pFinalDividendBlock = pDividend + len - 1;
 
     // This is an estimated quotient. Its error should be less than 2.
     // Reference inequality:
     // a/b - floor(floor(a)/(floor(b) + 1)) < 2
-    uint32_t quotient = *pFinalDividendBlock / (*pFinalDivisorBlock + 1);
+    uint32_t quotient = (uint32_t)(*pFinalDividendBlock / (*pFinalDivisorBlock + 1));
 
     if (quotient != 0)
     {
         // Now we use our estimated quotient to update each block of dividend.
         // dividend = dividend - divisor * quotient
-        const uint32_t *pDivisorCurrent = divisor.m_blocks;
-        uint32_t *pDividendCurrent = pDividend->m_blocks;
+        const Block *pDivisorCurrent = pDivisor;
+        Block *pDividendCurrent = pDividend;
 
-        uint64_t borrow = 0;
-        uint64_t carry = 0;
+        DoubleBlock borrow = 0;
+        DoubleBlock carry = 0;
         do
         {
-            uint64_t product = (uint64_t)*pDivisorCurrent * (uint64_t)quotient + carry;
-            carry = product >> 32;
+            DoubleBlock product = (DoubleBlock)*pDivisorCurrent * (DoubleBlock)quotient + carry;
+            carry = product >> BLOCKBITS;
 
-            uint64_t difference = (uint64_t)*pDividendCurrent - (product & 0xFFFFFFFF) - borrow;
-            borrow = (difference >> 32) & 1;
+            DoubleBlock difference = (DoubleBlock)*pDividendCurrent - (Block)product - borrow;
+            borrow = (difference >> BLOCKBITS) & 1;
 
-            *pDividendCurrent = difference & 0xFFFFFFFF;
+            *pDividendCurrent = (Block)difference;
 
             ++pDivisorCurrent;
             ++pDividendCurrent;
         } while (pDivisorCurrent <= pFinalDivisorBlock);
 
         // Remove all leading zero blocks from dividend
-        while (len > 0 && pDividend->m_blocks[len - 1] == 0)
+        while (len > 0 && pDividend[len - 1] == 0)
         {
             --len;
         }
 
-        pDividend->m_len = len;
+        *pDividendLength = len;
     }
 
     // If the dividend is still larger than the divisor, we overshot our estimate quotient. To correct,
     // we increment the quotient and subtract one more divisor from the dividend (Because we guaranteed the error range).
-    if (BigNum::compare(*pDividend, divisor) >= 0)
+    if (compare(pDividend, *pDividendLength, pDivisor, divisorLength) >= 0)
     {
         ++quotient;
+        CONVERSIONSTATS_COUNT(quotientCorrections);
 
         // dividend = dividend - divisor
-        const uint32_t *pDivisorCur = divisor.m_blocks;
-        uint32_t *pDividendCur = pDividend->m_blocks;
+        const Block *pDivisorCur = pDivisor;
+        Block *pDividendCur = pDividend;
 
-        uint64_t borrow = 0;
+        DoubleBlock borrow = 0;
         do
         {
-            uint64_t difference = (uint64_t)*pDividendCur - (uint64_t)*pDivisorCur - borrow;
-            borrow = (difference >> 32) & 1;
+            DoubleBlock difference = (DoubleBlock)*pDividendCur - (DoubleBlock)*pDivisorCur - borrow;
+            borrow = (difference >> BLOCKBITS) & 1;
 
-            *pDividendCur = difference & 0xFFFFFFFF;
+            *pDividendCur = (Block)difference;
 
             ++pDivisorCur;
             ++pDividendCur;
         } while (pDivisorCur <= pFinalDivisorBlock);
 
         // Remove all leading zero blocks from dividend
-        while (len > 0 && pDividend->m_blocks[len - 1] == 0)
+        while (len > 0 && pDividend[len - 1] == 0)
         {
             --len;
         }
 
-        pDividend->m_len = len;
+        *pDividendLength = len;
     }
 
     return quotient;
 }
 
-void BigNum::multiply(uint32_t value)
-{
-    multiply(*this, value, *this);
-}
-
-void BigNum::multiply(const BigNum& value)
-{
-    BigNum temp;
-    BigNum::multiply(*this, value, temp);
-
-    memcpy(m_blocks, temp.m_blocks, temp.m_len * sizeof(uint32_t));
-    m_len = temp.m_len;
-}
-
-void BigNum::multiply(const BigNum& lhs, uint32_t value, BigNum& result)
+uint16_t BigNumBase::multiplyPow10(Block* pBlocks, uint16_t length, uint32_t exp)
 {
-    if (lhs.m_len == 0)
+    // The powers of ten between the table entries fit into 32 bits.
+    uint32_t smallExp = exp % POWER10TABLESTEP;
+    if (smallExp != 0)
     {
-        return;
+        length = multiply(pBlocks, length, m_power10UInt32Table[smallExp], pBlocks);
     }
 
-    if (lhs.m_len < BIGSIZE)
+    exp -= smallExp;
+
+    // Multiply by the table entries directly, exponents beyond the table take several steps.
+    while (exp != 0)
     {
-        // Set the highest + 1 bit to zero so that
-        // we can check if there's a carry later.
-        result.m_blocks[lhs.m_len] = 0;
+#if !BIGNUM_POW10_COMPACT
+        if (exp >= POWER10LARGESTEP)
+        {
+            uint32_t idx = std::min(exp / POWER10LARGESTEP, POWER10LARGENUM - 1);
+            uint32_t offset = m_power10LargeTable.offsets[idx];
+
+            length = multiplyInPlace(pBlocks, length, m_power10LargeTable.blocks + offset, (uint16_t)(m_power10LargeTable.offsets[idx + 1] - offset));
+
+            exp -= idx * POWER10LARGESTEP;
+            continue;
+        }
+#endif
+
+        uint32_t idx = std::min(exp / POWER10TABLESTEP, POWER10TABLENUM - 1);
+        uint32_t offset = m_power10Table.offsets[idx];
+
+        length = multiplyInPlace(pBlocks, length, m_power10Table.blocks + offset, (uint16_t)(m_power10Table.offsets[idx + 1] - offset));
+
+        exp -= idx * POWER10TABLESTEP;
     }
 
-    const uint32_t* pCurrent = lhs.m_blocks;
-    const uint32_t* pEnd = pCurrent + lhs.m_len;
-    uint32_t* pResultCurrent = result.m_blocks;
+    return length;
+}
 
-    uint64_t carry = 0;
+uint16_t BigNumBase::multiply(const Block* pLhs, uint16_t lhsLength, uint32_t value, Block* pResult)
+{
+    const Block* pCurrent = pLhs;
+    const Block* pEnd = pCurrent + lhsLength;
+    Block* pResultCurrent = pResult;
+
+    DoubleBlock carry = 0;
     while (pCurrent != pEnd)
     {
-        uint64_t product = (uint64_t)(*pCurrent) * (uint64_t)value + carry;
-        carry = product >> 32;
-        *pResultCurrent = (uint32_t)(product & 0xFFFFFFFF);
+        DoubleBlock product = (DoubleBlock)(*pCurrent) * (DoubleBlock)value + carry;
+        carry = product >> BLOCKBITS;
+        *pResultCurrent = (Block)product;
 
         ++pResultCurrent;
         ++pCurrent;
     }
 
-    if (lhs.m_len < BIGSIZE && result.m_blocks[lhs.m_len] != 0)
-    {
-        result.m_len = lhs.m_len + 1;
-    }
-    else
+    if (carry != 0)
     {
-        result.m_len = lhs.m_len;
+        // Store the carry to the next block.
+        *pResultCurrent = (Block)carry;
+        return lhsLength + 1;
     }
+
+    return lhsLength;
 }
 
-void BigNum::multiply(const BigNum& lhs, const BigNum& rhs, BigNum& result)
+uint16_t BigNumBase::multiply(const Block* pLhs, uint16_t lhsLength, const Block* pRhs, uint16_t rhsLength, Block* pResult)
 {
-    const BigNum* pLarge = NULL;
-    const BigNum* pSmall = NULL;
-    if (lhs.m_len < rhs.m_len)
-    {
-        pSmall = &lhs;
-        pLarge = &rhs;
-    }
-    else
+    const Block* pLargeBegin = pLhs;
+    const Block* pSmallCurrent = pRhs;
+    uint16_t largeLength = lhsLength;
+    uint16_t smallLength = rhsLength;
+    if (lhsLength < rhsLength)
     {
-        pSmall = &rhs;
-        pLarge = &lhs;
+        swap(pLargeBegin, pSmallCurrent);
+        swap(largeLength, smallLength);
     }
 
-    uint8_t maxResultLength = pSmall->m_len + pLarge->m_len;
+    uint16_t maxResultLength = smallLength + largeLength;
 
-    // Zero out result internal blocks.
-    memset(result.m_blocks, 0, sizeof(uint32_t) * BIGSIZE);
+    // Zero out the result blocks we are going to accumulate into.
+    memset(pResult, 0, sizeof(Block) * maxResultLength);
 
-    const uint32_t* pLargeBegin = pLarge->m_blocks;
-    const uint32_t* pLargeEnd = pLarge->m_blocks + pLarge->m_len;
+    const Block* pLargeEnd = pLargeBegin + largeLength;
 
-    uint32_t* pResultStart = result.m_blocks;
-    const uint32_t* pSmallCurrent = pSmall->m_blocks;
-    const uint32_t* pSmallEnd = pSmallCurrent + pSmall->m_len;
+    Block* pResultStart = pResult;
+    const Block* pSmallEnd = pSmallCurrent + smallLength;
 
     while (pSmallCurrent != pSmallEnd)
     {
         // Multiply each block of large BigNum.
         if (*pSmallCurrent != 0)
         {
-            const uint32_t* pLargeCurrent = pLargeBegin;
-            uint32_t* pResultCurrent = pResultStart;
-            uint64_t carry = 0;
+            const Block* pLargeCurrent = pLargeBegin;
+            Block* pResultCurrent = pResultStart;
+            DoubleBlock carry = 0;
 
             do
             {
-                uint64_t product = (uint64_t)(*pResultCurrent) + (uint64_t)(*pSmallCurrent) * (uint64_t)(*pLargeCurrent) + carry;
-                carry = product >> 32;
-                *pResultCurrent = (uint32_t)(product & 0xFFFFFFFF);
+                DoubleBlock product = (DoubleBlock)(*pResultCurrent) + (DoubleBlock)(*pSmallCurrent) * (DoubleBlock)(*pLargeCurrent) + carry;
+                carry = product >> BLOCKBITS;
+                *pResultCurrent = (Block)product;
 
                 ++pResultCurrent;
                 ++pLargeCurrent;
             } while (pLargeCurrent != pLargeEnd);
 
-            *pResultCurrent = (uint32_t)(carry & 0xFFFFFFFF);
+            *pResultCurrent = (Block)carry;
         }
 
         ++pSmallCurrent;
         ++pResultStart;
     }
 
-    if (maxResultLength > 0 && result.m_blocks[maxResultLength - 1] == 0)
-    {
-        result.m_len = maxResultLength - 1;
-    }
-    else
+    if (maxResultLength > 0 && pResult[maxResultLength - 1] == 0)
     {
-        result.m_len = maxResultLength;
+        return maxResultLength - 1;
     }
+
+    return maxResultLength;
 }
 
-bool BigNum::isZero()
+uint16_t BigNumBase::multiplyInPlace(Block* pBlocks, uint16_t length, const Block* pRhs, uint16_t rhsLength)
 {
-    if (m_len == 0)
-    {
-        return true;
-    }
+    uint16_t maxResultLength = length + rhsLength;
+    memset(pBlocks + length, 0, sizeof(Block) * rhsLength);
 
-    for (uint8_t i = 0; i < m_len; ++i)
+    // Go from the highest block down. Block i is read before it is cleared, and its partial
+    // product only touches blocks i and above, which were either read already or are zero.
+    for (int i = length - 1; i >= 0; --i)
     {
-        if (m_blocks[i] != 0)
+        Block factor = pBlocks[i];
+        pBlocks[i] = 0;
+
+        if (factor == 0)
         {
-            return false;
+            continue;
         }
-    }
 
-    return true;
-}
+        Block* pResultCurrent = pBlocks + i;
+        const Block* pRhsCurrent = pRhs;
+        const Block* pRhsEnd = pRhs + rhsLength;
+        DoubleBlock carry = 0;
 
-void BigNum::setUInt32(uint32_t value)
-{
-    m_len = 1;
-    m_blocks[0] = value;
-}
+        do
+        {
+            DoubleBlock product = (DoubleBlock)(*pResultCurrent) + (DoubleBlock)factor * (DoubleBlock)(*pRhsCurrent) + carry;
+            carry = product >> BLOCKBITS;
+            *pResultCurrent = (Block)product;
 
-void BigNum::setUInt64(uint64_t value)
-{
-    m_len = 0;
-    m_blocks[0] = (uint32_t)(value & 0xFFFFFFFF);
-    m_len++;
+            ++pResultCurrent;
+            ++pRhsCurrent;
+        } while (pRhsCurrent != pRhsEnd);
 
-    uint32_t highBits = (uint32_t)(value >> 32);
-    if (highBits != 0)
+        // The blocks above may hold partial products of the higher blocks already.
+        while (carry != 0)
+        {
+            DoubleBlock sum = (DoubleBlock)(*pResultCurrent) + carry;
+            carry = sum >> BLOCKBITS;
+            *pResultCurrent = (Block)sum;
+
+            ++pResultCurrent;
+        }
+    }
+
+    if (maxResultLength > 0 && pBlocks[maxResultLength - 1] == 0)
     {
-        m_blocks[1] = highBits;
-        m_len++;
+        return maxResultLength - 1;
     }
-}
 
-void BigNum::extendBlock(uint32_t newBlock)
-{
-    m_blocks[m_len] = newBlock;
-    ++m_len;
+    return maxResultLength;
 }
 
-uint32_t BigNum::logBase2(uint32_t val)
+uint32_t BigNumBase::logBase2(uint32_t val)
 {
     static const uint8_t logTable[256] =
     {
@@ -558,7 +493,7 @@ uint32_t BigNum::logBase2(uint32_t val)
     return logTable[val];
 }
 
-uint32_t BigNum::logBase2(uint64_t val)
+uint32_t BigNumBase::logBase2(uint64_t val)
 {
     uint64_t temp = val >> 32;
     if (temp != 0)
@@ -1,132 +1,559 @@
 #ifndef BIGNUM_H
 #define BIGNUM_H
 
+#include "conversionstats.h"
 #include <cmath>
 #include <cstdint>
 #include <algorithm>
+#include <cassert>
+#include <cstring>
 
-class BigNum
+// BigNum stores its value in 64 bit blocks when the compiler offers a 128 bit integer type
+// for the intermediate products (GCC and Clang on 64 bit targets), which halves the number
+// of iterations in every loop. Otherwise 32 bit blocks with 64 bit intermediates are used.
+// Define BIGNUM_BLOCK64 to 0 or 1 to select the block size explicitly.
+#ifndef BIGNUM_BLOCK64
+#if defined(__SIZEOF_INT128__)
+#define BIGNUM_BLOCK64 1
+#else
+#define BIGNUM_BLOCK64 0
+#endif
+#endif
+
+// The arithmetic on arrays of blocks shared by all BigNumT sizes. Every function only
+// touches the blocks which are in use and returns the new length where it changes.
+class BigNumBase
 {
 public:
-    BigNum();
-    BigNum(uint32_t value);
-    BigNum(uint64_t value);
-    ~BigNum();
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 UInt128;
+#endif
+
+#if BIGNUM_BLOCK64
+    typedef uint64_t Block;
+    typedef UInt128 DoubleBlock;
+#else
+    typedef uint32_t Block;
+    typedef uint64_t DoubleBlock;
+#endif
 
-    BigNum & operator=(const BigNum &rhs);
+    static const uint32_t BLOCKBITS = sizeof(Block) * 8;
 
     static uint32_t logBase2(uint32_t val);
     static uint32_t logBase2(uint64_t val);
 
-    static int compare(const BigNum& lhs, uint32_t value);
-    static int compare(const BigNum& lhs, const BigNum& rhs);
+    // The number of blocks needed for values of up to `bits` bits.
+    static constexpr uint16_t blocksForBits(uint32_t bits)
+    {
+        return (uint16_t)((bits + BLOCKBITS - 1) / BLOCKBITS);
+    }
+
+    // The most decimal digits one heuristicDivide() can produce after
+    // prepareChunkDivide(): the quotient must stay below 2^(BLOCKBITS / 2 - 2).
+    static const int DIGITCHUNKCOUNT = BIGNUM_BLOCK64 ? 9 : 4;
+
+protected:
+    static const uint8_t UINT32POWER10NUM = 8;
+    static const uint32_t m_power10UInt32Table[UINT32POWER10NUM];
+
+    // Powers of ten 10^(i * POWER10TABLESTEP), see bignumpow10table.cpp.
+#if BIGNUM_POW10_COMPACT
+    static const uint32_t POWER10TABLESTEP = 8;
+    static const uint32_t POWER10TABLENUM = 41;
+    static const uint32_t POWER10BLOCKSNUM = BIGNUM_BLOCK64 ? 361 : 701;
+#else
+    static const uint32_t POWER10TABLESTEP = 1;
+    static const uint32_t POWER10TABLENUM = 325;
+    static const uint32_t POWER10BLOCKSNUM = BIGNUM_BLOCK64 ? 2897 : 5630;
+#endif
+
+    struct Power10Table
+    {
+        Block blocks[POWER10BLOCKSNUM];
+        uint16_t offsets[POWER10TABLENUM + 1];
+    };
+
+    static const Power10Table m_power10Table;
+    static constexpr Power10Table makePower10Table();
+
+#if !BIGNUM_POW10_COMPACT
+    // Powers of ten 10^(i * POWER10LARGESTEP) for the exponents of long double and
+    // binary128 (up to 10^4966), so that any power of ten takes at most one entry of each
+    // table. Compact builds reach them by repeated multiplication.
+    static const uint32_t POWER10LARGESTEP = POWER10TABLESTEP * POWER10TABLENUM;
+    static const uint32_t POWER10LARGENUM = 16;
+    static const uint32_t POWER10LARGEBLOCKSNUM = BIGNUM_BLOCK64 ? 2033 : 4057;
+
+    struct Power10LargeTable
+    {
+        Block blocks[POWER10LARGEBLOCKSNUM];
+        uint16_t offsets[POWER10LARGENUM + 1];
+    };
+
+    static const Power10LargeTable m_power10LargeTable;
+    static constexpr Power10LargeTable makePower10LargeTable();
+#endif
+
+    static int compare(const Block* pLhs, uint16_t lhsLength, const Block* pRhs, uint16_t rhsLength);
+    static uint16_t add(const Block* pLhs, uint16_t lhsLength, const Block* pRhs, uint16_t rhsLength, Block* pResult);
+    static uint16_t shiftLeft(Block* pBlocks, uint16_t length, uint32_t shift);
+    static uint16_t multiply(const Block* pLhs, uint16_t lhsLength, uint32_t value, Block* pResult);
+    static uint16_t multiply(const Block* pLhs, uint16_t lhsLength, const Block* pRhs, uint16_t rhsLength, Block* pResult);
+    static uint16_t multiplyInPlace(Block* pBlocks, uint16_t length, const Block* pRhs, uint16_t rhsLength);
+    static uint16_t multiplyPow10(Block* pBlocks, uint16_t length, uint32_t exp);
+    static uint16_t pow10(uint32_t exp, Block* pResult);
+    static uint32_t heuristicDivide(Block* pDividend, uint16_t* pDividendLength, const Block* pDivisor, uint16_t divisorLength);
+};
+
+// An unsigned integer of up to Capacity blocks. Capacity must hold the largest
+// intermediate value of the algorithm using it, nothing checks for overflow in release
+// builds. All values taking part in one operation have the same capacity.
+template <uint16_t Capacity>
+class BigNumT : public BigNumBase
+{
+public:
+    static const uint16_t CAPACITY = Capacity;
+
+    BigNumT();
+    BigNumT(uint32_t value);
+    BigNumT(uint64_t value);
+
+    BigNumT& operator=(const BigNumT& rhs);
+
+    static int compare(const BigNumT& lhs, uint32_t value);
+    static int compare(const BigNumT& lhs, const BigNumT& rhs);
 
-    static void shiftLeft(uint64_t input, int shift, BigNum& output);
-    static void shiftLeft(BigNum* pResult, uint32_t shift);
-    static void pow10(int exp, BigNum& result);
-    static void prepareHeuristicDivide(BigNum* pDividend, BigNum* divisor);
-    static uint32_t heuristicDivide(BigNum* pDividend, const BigNum& divisor);
-    static void multiply(const BigNum& lhs, uint32_t value, BigNum& result);
-    static void multiply(const BigNum& lhs, const BigNum& rhs, BigNum& result);
+    static void add(const BigNumT& lhs, const BigNumT& rhs, BigNumT& result);
+    static void shiftLeft(uint64_t input, int shift, BigNumT& output);
+    static void shiftLeft(BigNumT* pResult, uint32_t shift);
+    static void pow10(int exp, BigNumT& result);
+    static uint32_t prepareHeuristicDivide(BigNumT* pDividend, BigNumT* divisor);
+    static uint32_t prepareChunkDivide(BigNumT* pDividend, BigNumT* pDivisor);
+    static uint32_t heuristicDivide(BigNumT* pDividend, const BigNumT& divisor);
+    static void multiply(const BigNumT& lhs, uint32_t value, BigNumT& result);
+    static void multiply(const BigNumT& lhs, const BigNumT& rhs, BigNumT& result);
 
-    bool isZero();
+    bool isZero() const;
 
     void multiply(uint32_t value);
-    void multiply(const BigNum& value);
+    void multiply(const BigNumT& value);
+    void multiplyPow10(uint32_t exp);
     void setUInt32(uint32_t value);
     void setUInt64(uint64_t value);
-    void extendBlock(uint32_t newBlock);
+#if defined(__SIZEOF_INT128__)
+    void setUInt128(UInt128 value);
+#endif
+    void extendBlock(Block newBlock);
 
 private:
+    uint16_t m_len;
+    Block m_blocks[Capacity];
+};
 
-    static const uint8_t BIGSIZE = 35;
-    static const uint8_t UINT32POWER10NUM = 8;
-    static const uint8_t BIGPOWER10NUM = 6;
-    static uint32_t m_power10UInt32Table[UINT32POWER10NUM];
-    static BigNum m_power10BigNumTable[BIGPOWER10NUM];
+// Sized for the numerator and denominator of a double: up to 4 * 10^324 (1079 bits),
+// shifted by less than a block by prepareHeuristicDivide or prepareChunkDivide. The
+// shortest digits multiply the numerator by 10 for the next digit, which the 4 extra bits
+// are for. The counted digits multiply it by up to 10^DIGITCHUNKCOUNT, but
+// prepareChunkDivide leaves the highest bit of the denominator at BLOCKBITS / 2 of its
+// highest block, and the numerator is below the denominator. The product stays below
+// denominator * 2^(BLOCKBITS / 2 - 2), so it fits into the headroom of that block.
+typedef BigNumT<BigNumBase::blocksForBits(1079 + BigNumBase::BLOCKBITS - 1 + 4)> BigNum;
+
+// The same for an x87 80 bit long double or an IEEE binary128: up to 4 * 2^16494 (16496
+// bits), the denominator of the smallest binary128 subnormal.
+typedef BigNumT<BigNumBase::blocksForBits(16496 + BigNumBase::BLOCKBITS - 1 + 4)> LongBigNum;
+
+// Sized for parsing: up to 769 decimal digits are compared with a halfway point between
+// two doubles, the larger side is at most (2^54 - 1) * 10^1092 (3682 bits). The extra
+// block is for multiplyInPlace.
+typedef BigNumT<BigNumBase::blocksForBits(3682 + BigNumBase::BLOCKBITS)> ParseBigNum;
+
+template <uint16_t Capacity>
+BigNumT<Capacity>::BigNumT()
+    :m_len(0)
+{
+}
+
+template <uint16_t Capacity>
+BigNumT<Capacity>::BigNumT(uint32_t value)
+{
+    setUInt32(value);
+}
+
+template <uint16_t Capacity>
+BigNumT<Capacity>::BigNumT(uint64_t value)
+{
+    setUInt64(value);
+}
+
+template <uint16_t Capacity>
+BigNumT<Capacity>& BigNumT<Capacity>::operator=(const BigNumT& rhs)
+{
+    memcpy(m_blocks, rhs.m_blocks, rhs.m_len * sizeof(Block));
+    m_len = rhs.m_len;
+
+    return *this;
+}
+
+template <uint16_t Capacity>
+int BigNumT<Capacity>::compare(const BigNumT& lhs, uint32_t value)
+{
+    if (lhs.m_len == 0)
+    {
+        return value == 0 ? 0 : -1;
+    }
+
+    Block lhsValue = lhs.m_blocks[0];
+
+    if (lhsValue > value || lhs.m_len > 1)
+    {
+        return 1;
+    }
+
+    if (lhsValue < value)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+template <uint16_t Capacity>
+int BigNumT<Capacity>::compare(const BigNumT& lhs, const BigNumT& rhs)
+{
+    return BigNumBase::compare(lhs.m_blocks, lhs.m_len, rhs.m_blocks, rhs.m_len);
+}
+
+template <uint16_t Capacity>
+void BigNumT<Capacity>::add(const BigNumT& lhs, const BigNumT& rhs, BigNumT& result)
+{
+    result.m_len = BigNumBase::add(lhs.m_blocks, lhs.m_len, rhs.m_blocks, rhs.m_len, result.m_blocks);
+    assert(result.m_len <= Capacity);
+    CONVERSIONSTATS_MAX(maxBigNumLength, result.m_len);
+}
+
+template <uint16_t Capacity>
+void BigNumT<Capacity>::shiftLeft(uint64_t input, int shift, BigNumT& output)
+{
+    output.setUInt64(input);
+    shiftLeft(&output, shift);
+}
+
+template <uint16_t Capacity>
+void BigNumT<Capacity>::shiftLeft(BigNumT* pResult, uint32_t shift)
+{
+    pResult->m_len = BigNumBase::shiftLeft(pResult->m_blocks, pResult->m_len, shift);
+    assert(pResult->m_len <= Capacity);
+    CONVERSIONSTATS_MAX(maxBigNumLength, pResult->m_len);
+}
+
+template <uint16_t Capacity>
+void BigNumT<Capacity>::pow10(int exp, BigNumT& result)
+{
+    result.m_len = BigNumBase::pow10((uint32_t)exp, result.m_blocks);
+    assert(result.m_len <= Capacity);
+    CONVERSIONSTATS_MAX(maxBigNumLength, result.m_len);
+}
+
+template <uint16_t Capacity>
+uint32_t BigNumT<Capacity>::prepareHeuristicDivide(BigNumT* pDividend, BigNumT* pDivisor)
+{
+    uint32_t shift = 0;
+    Block hiBlock = pDivisor->m_blocks[pDivisor->m_len - 1];
+    if (hiBlock < 8 || hiBlock > (Block)-1 / 10)
+    {
+        // Inspired by http://www.ryanjuckett.com/programming/printing-floating-point-numbers/
+        // Perform a bit shift on all values to get the highest block of the divisor into
+        // the range [8,429496729]. We are more likely to make accurate quotient estimations
+        // in heuristicDivide() with higher divisor values so
+        // we shift the divisor to place the highest bit at index 27 of the highest block.
+        // This is safe because (2^28 - 1) = 268435455 which is less than 429496729. This means
+        // that all values with a highest bit at index 27 are within range.
+        // With 64 bit blocks the highest bit is placed at index 59 for the same reason.
+        uint32_t hiBlockLog2 = logBase2(hiBlock);
+        shift = (2 * BLOCKBITS - 5 - hiBlockLog2) % BLOCKBITS;
+
+        shiftLeft(pDivisor, shift);
+        shiftLeft(pDividend, shift);
+        CONVERSIONSTATS_COUNT(divideShifts);
+    }
+
+    return shift;
+}
+
+// Like prepareHeuristicDivide(), but for quotients of up to DIGITCHUNKCOUNT digits: the
+// highest bit of the divisor goes to index BLOCKBITS / 2 of its highest block. A dividend
+// below divisor * 2^(BLOCKBITS / 2 - 2) then has no more blocks than the divisor, and the
+// estimate of heuristicDivide() is still off by at most one.
+template <uint16_t Capacity>
+uint32_t BigNumT<Capacity>::prepareChunkDivide(BigNumT* pDividend, BigNumT* pDivisor)
+{
+    Block hiBlock = pDivisor->m_blocks[pDivisor->m_len - 1];
+    uint32_t shift = (BLOCKBITS + BLOCKBITS / 2 - logBase2(hiBlock)) % BLOCKBITS;
+    if (shift != 0)
+    {
+        shiftLeft(pDivisor, shift);
+        shiftLeft(pDividend, shift);
+        CONVERSIONSTATS_COUNT(divideShifts);
+    }
+
+    return shift;
+}
+
+template <uint16_t Capacity>
+uint32_t BigNumT<Capacity>::heuristicDivide(BigNumT* pDividend, const BigNumT& divisor)
+{
+    return BigNumBase::heuristicDivide(pDividend->m_blocks, &pDividend->m_len, divisor.m_blocks, divisor.m_len);
+}
+
+template <uint16_t Capacity>
+void BigNumT<Capacity>::multiply(const BigNumT& lhs, uint32_t value, BigNumT& result)
+{
+    result.m_len = BigNumBase::multiply(lhs.m_blocks, lhs.m_len, value, result.m_blocks);
+    assert(result.m_len <= Capacity);
+    CONVERSIONSTATS_MAX(maxBigNumLength, result.m_len);
+}
+
+template <uint16_t Capacity>
+void BigNumT<Capacity>::multiply(const BigNumT& lhs, const BigNumT& rhs, BigNumT& result)
+{
+    assert(lhs.m_len + rhs.m_len <= Capacity);
+    result.m_len = BigNumBase::multiply(lhs.m_blocks, lhs.m_len, rhs.m_blocks, rhs.m_len, result.m_blocks);
+    CONVERSIONSTATS_MAX(maxBigNumLength, result.m_len);
+}
 
-    static class StaticInitializer
+template <uint16_t Capacity>
+bool BigNumT<Capacity>::isZero() const
+{
+    for (uint16_t i = 0; i < m_len; ++i)
     {
-    public:
-        StaticInitializer()
+        if (m_blocks[i] != 0)
         {
-            // 10^8
-            m_power10BigNumTable[0].m_len = (uint8_t)1;
-            m_power10BigNumTable[0].m_blocks[0] = (uint32_t)100000000;
-
-            // 10^16
-            m_power10BigNumTable[1].m_len = (uint8_t)2;
-            m_power10BigNumTable[1].m_blocks[0] = (uint32_t)0x6fc10000;
-            m_power10BigNumTable[1].m_blocks[1] = (uint32_t)0x002386f2;
-
-            // 10^32
-            m_power10BigNumTable[2].m_len = (uint8_t)4;
-            m_power10BigNumTable[2].m_blocks[0] = (uint32_t)0x00000000;
-            m_power10BigNumTable[2].m_blocks[1] = (uint32_t)0x85acef81;
-            m_power10BigNumTable[2].m_blocks[2] = (uint32_t)0x2d6d415b;
-            m_power10BigNumTable[2].m_blocks[3] = (uint32_t)0x000004ee;
-
-            // 10^64
-            m_power10BigNumTable[3].m_len = (uint8_t)7;
-            m_power10BigNumTable[3].m_blocks[0] = (uint32_t)0x00000000;
-            m_power10BigNumTable[3].m_blocks[1] = (uint32_t)0x00000000;
-            m_power10BigNumTable[3].m_blocks[2] = (uint32_t)0xbf6a1f01;
-            m_power10BigNumTable[3].m_blocks[3] = (uint32_t)0x6e38ed64;
-            m_power10BigNumTable[3].m_blocks[4] = (uint32_t)0xdaa797ed;
-            m_power10BigNumTable[3].m_blocks[5] = (uint32_t)0xe93ff9f4;
-            m_power10BigNumTable[3].m_blocks[6] = (uint32_t)0x00184f03;
-
-            // 10^128
-            m_power10BigNumTable[4].m_len = (uint8_t)14;
-            m_power10BigNumTable[4].m_blocks[0] = (uint32_t)0x00000000;
-            m_power10BigNumTable[4].m_blocks[1] = (uint32_t)0x00000000;
-            m_power10BigNumTable[4].m_blocks[2] = (uint32_t)0x00000000;
-            m_power10BigNumTable[4].m_blocks[3] = (uint32_t)0x00000000;
-            m_power10BigNumTable[4].m_blocks[4] = (uint32_t)0x2e953e01;
-            m_power10BigNumTable[4].m_blocks[5] = (uint32_t)0x03df9909;
-            m_power10BigNumTable[4].m_blocks[6] = (uint32_t)0x0f1538fd;
-            m_power10BigNumTable[4].m_blocks[7] = (uint32_t)0x2374e42f;
-            m_power10BigNumTable[4].m_blocks[8] = (uint32_t)0xd3cff5ec;
-            m_power10BigNumTable[4].m_blocks[9] = (uint32_t)0xc404dc08;
-            m_power10BigNumTable[4].m_blocks[10] = (uint32_t)0xbccdb0da;
-            m_power10BigNumTable[4].m_blocks[11] = (uint32_t)0xa6337f19;
-            m_power10BigNumTable[4].m_blocks[12] = (uint32_t)0xe91f2603;
-            m_power10BigNumTable[4].m_blocks[13] = (uint32_t)0x0000024e;
-
-            // 10^256
-            m_power10BigNumTable[5].m_len = (uint8_t)27;
-            m_power10BigNumTable[5].m_blocks[0] = (uint32_t)0x00000000;
-            m_power10BigNumTable[5].m_blocks[1] = (uint32_t)0x00000000;
-            m_power10BigNumTable[5].m_blocks[2] = (uint32_t)0x00000000;
-            m_power10BigNumTable[5].m_blocks[3] = (uint32_t)0x00000000;
-            m_power10BigNumTable[5].m_blocks[4] = (uint32_t)0x00000000;
-            m_power10BigNumTable[5].m_blocks[5] = (uint32_t)0x00000000;
-            m_power10BigNumTable[5].m_blocks[6] = (uint32_t)0x00000000;
-            m_power10BigNumTable[5].m_blocks[7] = (uint32_t)0x00000000;
-            m_power10BigNumTable[5].m_blocks[8] = (uint32_t)0x982e7c01;
-            m_power10BigNumTable[5].m_blocks[9] = (uint32_t)0xbed3875b;
-            m_power10BigNumTable[5].m_blocks[10] = (uint32_t)0xd8d99f72;
-            m_power10BigNumTable[5].m_blocks[11] = (uint32_t)0x12152f87;
-            m_power10BigNumTable[5].m_blocks[12] = (uint32_t)0x6bde50c6;
-            m_power10BigNumTable[5].m_blocks[13] = (uint32_t)0xcf4a6e70;
-            m_power10BigNumTable[5].m_blocks[14] = (uint32_t)0xd595d80f;
-            m_power10BigNumTable[5].m_blocks[15] = (uint32_t)0x26b2716e;
-            m_power10BigNumTable[5].m_blocks[16] = (uint32_t)0xadc666b0;
-            m_power10BigNumTable[5].m_blocks[17] = (uint32_t)0x1d153624;
-            m_power10BigNumTable[5].m_blocks[18] = (uint32_t)0x3c42d35a;
-            m_power10BigNumTable[5].m_blocks[19] = (uint32_t)0x63ff540e;
-            m_power10BigNumTable[5].m_blocks[20] = (uint32_t)0xcc5573c0;
-            m_power10BigNumTable[5].m_blocks[21] = (uint32_t)0x65f9ef17;
-            m_power10BigNumTable[5].m_blocks[22] = (uint32_t)0x55bc28f2;
-            m_power10BigNumTable[5].m_blocks[23] = (uint32_t)0x80dcc7f7;
-            m_power10BigNumTable[5].m_blocks[24] = (uint32_t)0xf46eeddc;
-            m_power10BigNumTable[5].m_blocks[25] = (uint32_t)0x5fdcefce;
-            m_power10BigNumTable[5].m_blocks[26] = (uint32_t)0x000553f7;
+            return false;
         }
-    } m_initializer;
+    }
+
+    return true;
+}
+
+template <uint16_t Capacity>
+void BigNumT<Capacity>::multiply(uint32_t value)
+{
+    m_len = BigNumBase::multiply(m_blocks, m_len, value, m_blocks);
+    assert(m_len <= Capacity);
+    CONVERSIONSTATS_MAX(maxBigNumLength, m_len);
+}
+
+template <uint16_t Capacity>
+void BigNumT<Capacity>::multiply(const BigNumT& value)
+{
+    assert(m_len + value.m_len <= Capacity);
+    m_len = BigNumBase::multiplyInPlace(m_blocks, m_len, value.m_blocks, value.m_len);
+    CONVERSIONSTATS_MAX(maxBigNumLength, m_len);
+}
+
+template <uint16_t Capacity>
+void BigNumT<Capacity>::multiplyPow10(uint32_t exp)
+{
+    m_len = BigNumBase::multiplyPow10(m_blocks, m_len, exp);
+    assert(m_len <= Capacity);
+    CONVERSIONSTATS_MAX(maxBigNumLength, m_len);
+}
+
+template <uint16_t Capacity>
+void BigNumT<Capacity>::setUInt32(uint32_t value)
+{
+    m_len = 1;
+    m_blocks[0] = value;
+}
+
+template <uint16_t Capacity>
+void BigNumT<Capacity>::setUInt64(uint64_t value)
+{
+#if BIGNUM_BLOCK64
+    m_len = 1;
+    m_blocks[0] = value;
+#else
+    m_len = 0;
+    m_blocks[0] = (uint32_t)(value & 0xFFFFFFFF);
+    m_len++;
+
+    uint32_t highBits = (uint32_t)(value >> 32);
+    if (highBits != 0)
+    {
+        m_blocks[1] = highBits;
+        m_len++;
+    }
+#endif
+}
+
+#if defined(__SIZEOF_INT128__)
+template <uint16_t Capacity>
+void BigNumT<Capacity>::setUInt128(UInt128 value)
+{
+    m_len = 0;
+    do
+    {
+        m_blocks[m_len] = (Block)value;
+        ++m_len;
+        value >>= BLOCKBITS;
+    } while (value != 0);
+}
+#endif
+
+template <uint16_t Capacity>
+void BigNumT<Capacity>::extendBlock(Block newBlock)
+{
+    assert(m_len < Capacity);
+    m_blocks[m_len] = newBlock;
+    ++m_len;
+}
+
+// The subset of the BigNumT interface used by Dragon4Cutoff and Dragon4Shortest on a
+// single native unsigned integer, for values whose numerator and denominator fit into
+// it. Nothing checks for overflow: the denominator may have at most MAXDENOMINATORBITS
+// bits, which leaves room for multiplying by 10^DIGITCHUNKCOUNT (< 2^30) while the
+// numerator stays below it. heuristicDivide() is an exact native division, so no
+// normalization shift is needed.
+template <typename TUInt>
+class NativeNumT
+{
+public:
+    static const uint32_t BITS = sizeof(TUInt) * 8;
+    static const int DIGITCHUNKCOUNT = 9;
+    static const int MAXDENOMINATORBITS = BITS - 30;
+
+    NativeNumT();
+
+    static int compare(const NativeNumT& lhs, const NativeNumT& rhs);
+
+    static void add(const NativeNumT& lhs, const NativeNumT& rhs, NativeNumT& result);
+    static void shiftLeft(uint64_t input, int shift, NativeNumT& output);
+    static void shiftLeft(NativeNumT* pResult, uint32_t shift);
+    static uint32_t prepareHeuristicDivide(NativeNumT* pDividend, NativeNumT* pDivisor);
+    static uint32_t prepareChunkDivide(NativeNumT* pDividend, NativeNumT* pDivisor);
+    static uint32_t heuristicDivide(NativeNumT* pDividend, const NativeNumT& divisor);
+
+    bool isZero() const;
+
+    void multiply(uint32_t value);
+    void multiplyPow10(uint32_t exp);
+    void setUInt32(uint32_t value);
+    void setUInt64(uint64_t value);
+#if defined(__SIZEOF_INT128__)
+    void setUInt128(BigNumBase::UInt128 value);
+#endif
+
+private:
+    static const uint32_t m_power10UInt32Table[10];
+
+    TUInt m_value;
+};
+
+typedef NativeNumT<uint64_t> NativeNum64;
+#if defined(__SIZEOF_INT128__)
+typedef NativeNumT<BigNumBase::UInt128> NativeNum128;
+#endif
 
-    uint8_t m_len;
-    uint32_t m_blocks[BIGSIZE];
+template <typename TUInt>
+const uint32_t NativeNumT<TUInt>::m_power10UInt32Table[10] =
+{
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
 };
 
-#endif // BIGNUM_H
\ No newline at end of file
+template <typename TUInt>
+NativeNumT<TUInt>::NativeNumT()
+    :m_value(0)
+{
+}
+
+template <typename TUInt>
+int NativeNumT<TUInt>::compare(const NativeNumT& lhs, const NativeNumT& rhs)
+{
+    return lhs.m_value < rhs.m_value ? -1 : (lhs.m_value > rhs.m_value ? 1 : 0);
+}
+
+template <typename TUInt>
+void NativeNumT<TUInt>::add(const NativeNumT& lhs, const NativeNumT& rhs, NativeNumT& result)
+{
+    result.m_value = lhs.m_value + rhs.m_value;
+}
+
+template <typename TUInt>
+void NativeNumT<TUInt>::shiftLeft(uint64_t input, int shift, NativeNumT& output)
+{
+    output.m_value = (TUInt)input << shift;
+}
+
+template <typename TUInt>
+void NativeNumT<TUInt>::shiftLeft(NativeNumT* pResult, uint32_t shift)
+{
+    pResult->m_value <<= shift;
+}
+
+template <typename TUInt>
+uint32_t NativeNumT<TUInt>::prepareHeuristicDivide(NativeNumT*, NativeNumT*)
+{
+    return 0;
+}
+
+template <typename TUInt>
+uint32_t NativeNumT<TUInt>::prepareChunkDivide(NativeNumT*, NativeNumT*)
+{
+    return 0;
+}
+
+template <typename TUInt>
+uint32_t NativeNumT<TUInt>::heuristicDivide(NativeNumT* pDividend, const NativeNumT& divisor)
+{
+    TUInt quotient = pDividend->m_value / divisor.m_value;
+    pDividend->m_value -= quotient * divisor.m_value;
+
+    return (uint32_t)quotient;
+}
+
+template <typename TUInt>
+bool NativeNumT<TUInt>::isZero() const
+{
+    return m_value == 0;
+}
+
+template <typename TUInt>
+void NativeNumT<TUInt>::multiply(uint32_t value)
+{
+    m_value *= value;
+}
+
+template <typename TUInt>
+void NativeNumT<TUInt>::multiplyPow10(uint32_t exp)
+{
+    while (exp > 9)
+    {
+        m_value *= m_power10UInt32Table[9];
+        exp -= 9;
+    }
+
+    m_value *= m_power10UInt32Table[exp];
+}
+
+template <typename TUInt>
+void NativeNumT<TUInt>::setUInt32(uint32_t value)
+{
+    m_value = value;
+}
+
+template <typename TUInt>
+void NativeNumT<TUInt>::setUInt64(uint64_t value)
+{
+    m_value = (TUInt)value;
+}
+
+#if defined(__SIZEOF_INT128__)
+template <typename TUInt>
+void NativeNumT<TUInt>::setUInt128(BigNumBase::UInt128 value)
+{
+    m_value = (TUInt)value;
+}
+#endif
+
+#endif // BIGNUM_H
@@ -0,0 +1,118 @@
+#include "bignum.h"
+
+// Powers of ten for BigNum::pow10() and BigNum::multiplyPow10().
+//
+// Every entry is stored as its little endian BigNum blocks, m_power10Table.blocks holds all
+// entries back to back and entry i spans [offsets[i], offsets[i + 1]).
+//
+// The full table holds every power from 10^0 to 10^324, which covers every exponent the
+// conversion of a double can reach, so pow10() is a plain copy. It takes about 23 KB.
+// Memory constrained builds can define BIGNUM_POW10_COMPACT to only keep every 8th power
+// (about 3 KB). pow10() then needs one extra multiplication by a 32 bit power of ten.
+//
+// Builds with the full table also get a second table with every 325th power up to
+// 10^4875 (about 16 KB) for the exponent range of long double and binary128.
+//
+// The table is computed by the compiler, so it lives in read only data and needs no
+// initialization at runtime. It is therefore safe to use from other static constructors.
+// A POWER10BLOCKSNUM which is too small fails to compile.
+
+constexpr BigNumBase::Power10Table BigNumBase::makePower10Table()
+{
+    uint32_t stepValue = 1;
+    for (uint32_t i = 0; i < POWER10TABLESTEP; ++i)
+    {
+        stepValue *= 10;
+    }
+
+    Power10Table table = {};
+    table.blocks[0] = 1;
+    table.offsets[0] = 0;
+    table.offsets[1] = 1;
+
+    // Every entry is the previous one multiplied by 10^POWER10TABLESTEP.
+    for (uint32_t i = 1; i < POWER10TABLENUM; ++i)
+    {
+        uint32_t current = table.offsets[i - 1];
+        uint32_t end = table.offsets[i];
+        uint32_t next = end;
+
+        DoubleBlock carry = 0;
+        while (current != end)
+        {
+            DoubleBlock product = (DoubleBlock)table.blocks[current] * (DoubleBlock)stepValue + carry;
+            carry = product >> BLOCKBITS;
+            table.blocks[next] = (Block)product;
+
+            ++current;
+            ++next;
+        }
+
+        if (carry != 0)
+        {
+            table.blocks[next] = (Block)carry;
+            ++next;
+        }
+
+        table.offsets[i + 1] = (uint16_t)next;
+    }
+
+    return table;
+}
+
+constexpr BigNumBase::Power10Table BigNumBase::m_power10Table = BigNumBase::makePower10Table();
+
+#if !BIGNUM_POW10_COMPACT
+constexpr BigNumBase::Power10LargeTable BigNumBase::makePower10LargeTable()
+{
+    Power10LargeTable table = {};
+    table.blocks[0] = 1;
+    table.offsets[0] = 0;
+    table.offsets[1] = 1;
+
+    // Every entry is a copy of the previous one multiplied by 10^POWER10LARGESTEP, at most
+    // 10^9 at a time.
+    for (uint32_t i = 1; i < POWER10LARGENUM; ++i)
+    {
+        uint32_t previous = table.offsets[i - 1];
+        uint32_t begin = table.offsets[i];
+        uint32_t length = begin - previous;
+        for (uint32_t j = 0; j < length; ++j)
+        {
+            table.blocks[begin + j] = table.blocks[previous + j];
+        }
+
+        for (uint32_t exp = POWER10LARGESTEP; exp > 0; )
+        {
+            uint32_t stepExp = exp < 9 ? exp : 9;
+            uint32_t stepValue = 1;
+            for (uint32_t j = 0; j < stepExp; ++j)
+            {
+                stepValue *= 10;
+            }
+
+            DoubleBlock carry = 0;
+            for (uint32_t j = 0; j < length; ++j)
+            {
+                DoubleBlock product = (DoubleBlock)table.blocks[begin + j] * (DoubleBlock)stepValue + carry;
+                carry = product >> BLOCKBITS;
+                table.blocks[begin + j] = (Block)product;
+            }
+
+            if (carry != 0)
+            {
+                table.blocks[begin + length] = (Block)carry;
+                ++length;
+            }
+
+            exp -= stepExp;
+        }
+
+        table.offsets[i + 1] = (uint16_t)(begin + length);
+    }
+
+    return table;
+}
+
+constexpr BigNumBase::Power10LargeTable BigNumBase::m_power10LargeTable = BigNumBase::makePower10LargeTable();
+#endif
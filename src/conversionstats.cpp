@@ -0,0 +1,120 @@
+#include "conversionstats.h"
+#include <algorithm>
+#include <cstring>
+
+#if DOUBLETONUMBER_STATS
+#include <mutex>
+#include <vector>
+
+// The counters of the running threads, and the sum of those which have exited.
+static std::mutex conversionStatsMutex;
+static std::vector<ConversionStatsCounters*> conversionStatsThreads;
+static ConversionStats conversionStatsExited;
+
+thread_local ConversionStatsThreadSlot conversionStatsThreadSlot;
+
+static void ClearConversionCounters(ConversionStatsCounters* pCounters)
+{
+    for (int i = 0; i < CONVERSIONENGINE_COUNT; ++i)
+    {
+        pCounters->engineCalls[i].store(0, std::memory_order_relaxed);
+    }
+
+    pCounters->exponentFixups.store(0, std::memory_order_relaxed);
+    pCounters->quotientCorrections.store(0, std::memory_order_relaxed);
+    pCounters->divideShifts.store(0, std::memory_order_relaxed);
+    pCounters->carryPropagations.store(0, std::memory_order_relaxed);
+    pCounters->maxBigNumLength.store(0, std::memory_order_relaxed);
+
+    for (int i = 0; i < CONVERSIONPHASE_COUNT; ++i)
+    {
+        for (int j = 0; j < CONVERSIONSTATS_BUCKETCOUNT; ++j)
+        {
+            pCounters->phaseHistograms[i][j].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    pCounters->slowestCallTicks.store(0, std::memory_order_relaxed);
+    pCounters->slowestMantissaHigh.store(0, std::memory_order_relaxed);
+    pCounters->slowestMantissaLow.store(0, std::memory_order_relaxed);
+    pCounters->slowestExponent.store(0, std::memory_order_relaxed);
+}
+
+static void AddConversionCounters(const ConversionStatsCounters& counters, ConversionStats* pStats)
+{
+    for (int i = 0; i < CONVERSIONENGINE_COUNT; ++i)
+    {
+        pStats->engineCalls[i] += counters.engineCalls[i].load(std::memory_order_relaxed);
+    }
+
+    pStats->exponentFixups += counters.exponentFixups.load(std::memory_order_relaxed);
+    pStats->quotientCorrections += counters.quotientCorrections.load(std::memory_order_relaxed);
+    pStats->divideShifts += counters.divideShifts.load(std::memory_order_relaxed);
+    pStats->carryPropagations += counters.carryPropagations.load(std::memory_order_relaxed);
+    pStats->maxBigNumLength = std::max(pStats->maxBigNumLength, (uint64_t)counters.maxBigNumLength.load(std::memory_order_relaxed));
+
+    for (int i = 0; i < CONVERSIONPHASE_COUNT; ++i)
+    {
+        for (int j = 0; j < CONVERSIONSTATS_BUCKETCOUNT; ++j)
+        {
+            pStats->phaseHistograms[i][j] += counters.phaseHistograms[i][j].load(std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t slowestCallTicks = counters.slowestCallTicks.load(std::memory_order_relaxed);
+    if (slowestCallTicks > pStats->slowestCallTicks)
+    {
+        pStats->slowestCallTicks = slowestCallTicks;
+        pStats->slowestMantissaHigh = counters.slowestMantissaHigh.load(std::memory_order_relaxed);
+        pStats->slowestMantissaLow = counters.slowestMantissaLow.load(std::memory_order_relaxed);
+        pStats->slowestExponent = counters.slowestExponent.load(std::memory_order_relaxed);
+    }
+}
+
+ConversionStatsThreadSlot::ConversionStatsThreadSlot()
+{
+    ClearConversionCounters(&counters);
+
+    std::lock_guard<std::mutex> lock(conversionStatsMutex);
+    conversionStatsThreads.push_back(&counters);
+}
+
+ConversionStatsThreadSlot::~ConversionStatsThreadSlot()
+{
+    std::lock_guard<std::mutex> lock(conversionStatsMutex);
+    AddConversionCounters(counters, &conversionStatsExited);
+    conversionStatsThreads.erase(std::find(conversionStatsThreads.begin(), conversionStatsThreads.end(), &counters));
+}
+
+void GetConversionStats(ConversionStats* pStats)
+{
+    std::lock_guard<std::mutex> lock(conversionStatsMutex);
+    *pStats = conversionStatsExited;
+    pStats->isEnabled = true;
+
+    for (size_t i = 0; i < conversionStatsThreads.size(); ++i)
+    {
+        AddConversionCounters(*conversionStatsThreads[i], pStats);
+    }
+}
+
+void ResetConversionStats()
+{
+    std::lock_guard<std::mutex> lock(conversionStatsMutex);
+    memset(&conversionStatsExited, 0, sizeof(conversionStatsExited));
+
+    for (size_t i = 0; i < conversionStatsThreads.size(); ++i)
+    {
+        ClearConversionCounters(conversionStatsThreads[i]);
+    }
+}
+#else
+void GetConversionStats(ConversionStats* pStats)
+{
+    memset(pStats, 0, sizeof(*pStats));
+}
+
+void ResetConversionStats()
+{
+}
+#endif
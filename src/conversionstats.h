@@ -0,0 +1,246 @@
+#ifndef CONVERSIONSTATS_H
+#define CONVERSIONSTATS_H
+
+#include <cstdint>
+
+// Optional instrumentation of the digit engines, to find out why some conversions are so
+// much slower than others.
+//
+// Build everything (the library and all code including its headers) with
+// DOUBLETONUMBER_STATS defined to 1 to enable it. The engines then count which of them
+// served each call, how often Dragon4 had to fix up its exponent estimate, BigNum
+// quotient corrections and normalization shifts, the longest BigNum and 9-carries when
+// rounding, and record how many ticks every call and Dragon4 phase took. Every thread
+// counts into its own counters, GetConversionStats() adds them all up. Without
+// DOUBLETONUMBER_STATS the hooks are empty macros and GetConversionStats() returns zeros
+// with isEnabled == false.
+//
+// Ticks are time stamp counter ticks on x86 and nanoseconds elsewhere.
+#ifndef DOUBLETONUMBER_STATS
+#define DOUBLETONUMBER_STATS 0
+#endif
+
+enum ConversionEngine
+{
+    // UInt64ToDigits and UInt64ToShortestDigits for integers.
+    CONVERSIONENGINE_UINT64 = 0,
+    CONVERSIONENGINE_GRISU = 1,
+
+    // Dragon4 on NativeNum64 and NativeNum128.
+    CONVERSIONENGINE_NATIVE64 = 2,
+    CONVERSIONENGINE_NATIVE128 = 3,
+
+    // Dragon4 on BigNum or LongBigNum.
+    CONVERSIONENGINE_BIGNUM = 4,
+
+    CONVERSIONENGINE_COUNT = 5,
+};
+
+enum ConversionPhase
+{
+    // A whole GenerateCountedDigits, GenerateFixedDigits or GenerateShortestDigits call,
+    // whichever engine served it.
+    CONVERSIONPHASE_CALL = 0,
+
+    // Steps 2 and 3 of Dragon4: the exponent estimate and scaling by the power of ten.
+    CONVERSIONPHASE_SCALE = 1,
+
+    // Step 4 of Dragon4: the digit loop.
+    CONVERSIONPHASE_DIGITS = 2,
+
+    // Step 5 of Dragon4: rounding the last digit.
+    CONVERSIONPHASE_ROUND = 3,
+
+    CONVERSIONPHASE_COUNT = 4,
+};
+
+// Bucket i of a histogram counts the phases which took [2^i, 2^(i + 1)) ticks, bucket 0
+// also those below one tick and the last one everything above.
+#define CONVERSIONSTATS_BUCKETCOUNT 32
+
+struct ConversionStats
+{
+    // False if the library was built without DOUBLETONUMBER_STATS.
+    bool isEnabled;
+
+    // Fixed point values which round to zero before any engine runs are not counted.
+    uint64_t engineCalls[CONVERSIONENGINE_COUNT];
+
+    // Dragon4 exponent estimates which were one too low (firstDigitExponent += 1).
+    uint64_t exponentFixups;
+
+    // heuristicDivide() quotient estimates which were one too low.
+    uint64_t quotientCorrections;
+
+    // prepareHeuristicDivide() and prepareChunkDivide() calls which had to shift.
+    uint64_t divideShifts;
+
+    // Dragon4 roundings up which carried over one or more 9s.
+    uint64_t carryPropagations;
+
+    // The most blocks any BigNum has held.
+    uint64_t maxBigNumLength;
+
+    uint64_t phaseHistograms[CONVERSIONPHASE_COUNT][CONVERSIONSTATS_BUCKETCOUNT];
+
+    // The slowest call and its input mantissa * 2^exponent, the tail latency input to
+    // look at first. The mantissa is split into 64 bit halves for binary128.
+    uint64_t slowestCallTicks;
+    uint64_t slowestMantissaHigh;
+    uint64_t slowestMantissaLow;
+    int slowestExponent;
+};
+
+// A snapshot of the counters of all threads, those which have exited included. Counts
+// of threads which are converting at the same time may be a few calls behind.
+void GetConversionStats(ConversionStats* pStats);
+
+// Sets all counters to zero. Calls made at the same time on other threads may be lost.
+void ResetConversionStats();
+
+#if DOUBLETONUMBER_STATS
+#include <atomic>
+#include <chrono>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CONVERSIONSTATS_HAS_TSC 1
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define CONVERSIONSTATS_HAS_TSC 1
+#else
+#define CONVERSIONSTATS_HAS_TSC 0
+#endif
+
+// The counters of one thread. Only the owning thread writes them, so a relaxed load and
+// store is enough and costs no more than a plain increment, while other threads can
+// still read them without a data race.
+struct ConversionStatsCounters
+{
+    std::atomic<uint64_t> engineCalls[CONVERSIONENGINE_COUNT];
+    std::atomic<uint64_t> exponentFixups;
+    std::atomic<uint64_t> quotientCorrections;
+    std::atomic<uint64_t> divideShifts;
+    std::atomic<uint64_t> carryPropagations;
+    std::atomic<uint64_t> maxBigNumLength;
+    std::atomic<uint64_t> phaseHistograms[CONVERSIONPHASE_COUNT][CONVERSIONSTATS_BUCKETCOUNT];
+    std::atomic<uint64_t> slowestCallTicks;
+    std::atomic<uint64_t> slowestMantissaHigh;
+    std::atomic<uint64_t> slowestMantissaLow;
+    std::atomic<int> slowestExponent;
+};
+
+// Registers the counters of its thread with GetConversionStats() for its lifetime.
+class ConversionStatsThreadSlot
+{
+public:
+    ConversionStatsThreadSlot();
+    ~ConversionStatsThreadSlot();
+
+    ConversionStatsCounters counters;
+
+private:
+    ConversionStatsThreadSlot(const ConversionStatsThreadSlot&);
+    ConversionStatsThreadSlot& operator=(const ConversionStatsThreadSlot&);
+};
+
+extern thread_local ConversionStatsThreadSlot conversionStatsThreadSlot;
+
+inline ConversionStatsCounters& GetThreadConversionCounters()
+{
+    return conversionStatsThreadSlot.counters;
+}
+
+inline void IncrementConversionCounter(std::atomic<uint64_t>& counter)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+inline void MaxConversionCounter(std::atomic<uint64_t>& counter, uint64_t value)
+{
+    if (value > counter.load(std::memory_order_relaxed))
+    {
+        counter.store(value, std::memory_order_relaxed);
+    }
+}
+
+inline uint64_t ReadConversionTicks()
+{
+#if CONVERSIONSTATS_HAS_TSC
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+inline void RecordConversionTicks(ConversionPhase phase, uint64_t ticks)
+{
+    int bucket = 0;
+    while (ticks > 1 && bucket < CONVERSIONSTATS_BUCKETCOUNT - 1)
+    {
+        ticks >>= 1;
+        ++bucket;
+    }
+
+    IncrementConversionCounter(GetThreadConversionCounters().phaseHistograms[phase][bucket]);
+}
+
+// Records the ticks since *pStart for `phase` and restarts *pStart for the next phase.
+inline void RecordConversionPhase(ConversionPhase phase, uint64_t* pStart)
+{
+    uint64_t now = ReadConversionTicks();
+    RecordConversionTicks(phase, now - *pStart);
+    *pStart = now;
+}
+
+// Times one GenerateXxxDigits call from its construction to its destruction.
+class ConversionCallScope
+{
+public:
+    template <typename TMantissa>
+    ConversionCallScope(TMantissa mantissa, int exponent)
+        :m_mantissaHigh((uint64_t)(mantissa >> 32 >> 32)),
+        m_mantissaLow((uint64_t)mantissa),
+        m_exponent(exponent),
+        m_start(ReadConversionTicks())
+    {
+    }
+
+    ~ConversionCallScope()
+    {
+        uint64_t ticks = ReadConversionTicks() - m_start;
+        RecordConversionTicks(CONVERSIONPHASE_CALL, ticks);
+
+        ConversionStatsCounters& counters = GetThreadConversionCounters();
+        if (ticks > counters.slowestCallTicks.load(std::memory_order_relaxed))
+        {
+            counters.slowestCallTicks.store(ticks, std::memory_order_relaxed);
+            counters.slowestMantissaHigh.store(m_mantissaHigh, std::memory_order_relaxed);
+            counters.slowestMantissaLow.store(m_mantissaLow, std::memory_order_relaxed);
+            counters.slowestExponent.store(m_exponent, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    uint64_t m_mantissaHigh;
+    uint64_t m_mantissaLow;
+    int m_exponent;
+    uint64_t m_start;
+};
+
+#define CONVERSIONSTATS_COUNT(counter) IncrementConversionCounter(GetThreadConversionCounters().counter)
+#define CONVERSIONSTATS_ENGINE(engine) IncrementConversionCounter(GetThreadConversionCounters().engineCalls[engine])
+#define CONVERSIONSTATS_MAX(counter, value) MaxConversionCounter(GetThreadConversionCounters().counter, value)
+#define CONVERSIONSTATS_CALL(mantissa, exponent) ConversionCallScope conversionCallScope(mantissa, exponent)
+#define CONVERSIONSTATS_PHASESTART(start) uint64_t start = ReadConversionTicks()
+#define CONVERSIONSTATS_PHASEEND(phase, start) RecordConversionPhase(phase, &start)
+#else
+#define CONVERSIONSTATS_COUNT(counter) ((void)0)
+#define CONVERSIONSTATS_ENGINE(engine) ((void)0)
+#define CONVERSIONSTATS_MAX(counter, value) ((void)0)
+#define CONVERSIONSTATS_CALL(mantissa, exponent) ((void)0)
+#define CONVERSIONSTATS_PHASESTART(start) ((void)0)
+#define CONVERSIONSTATS_PHASEEND(phase, start) ((void)0)
+#endif
+
+#endif // CONVERSIONSTATS_H
@@ -0,0 +1,639 @@
+#ifndef DOUBLEFORMAT_H
+#define DOUBLEFORMAT_H
+
+#include "doubletochars.h"
+#include <cerrno>
+#include <cstring>
+
+// Compiled .NET style standard numeric format strings ("G", "R", "F2", "N2", "E10", "C",
+// "P1", ...) for doubles.
+//
+// DoubleFormat::compile() parses the format string once and works out everything the
+// layout needs: which digits to generate (the DoubleToNumber mode and precision), the
+// notation, how many digits go after the decimal point, the separators and symbols, and
+// the longest text any value can produce. format() then only generates the digits into
+// a buffer on the stack and lays them out, without parsing or allocating anything. A
+// compiled plan is not modified by format(), so one plan can be shared by any number of
+// threads.
+//
+// The format specifiers, each optionally followed by a precision n. Lower case letters
+// write a lower case 'e' in the exponent.
+//  - G[n]: n significant digits without trailing zeros, scientific when the exponent is
+//    below -4 or at least n, the same as printf's %.*G. Without n (or with n = 0) the
+//    shortest round trip digits, scientific when the exponent is at least 15 and at
+//    least the number of digits, like double.ToString() in .NET Core 3.0 and later.
+//  - R: the same as G, n is ignored.
+//  - F[n]: n digits after the decimal point (2 by default), like printf's %.*f.
+//  - N[n]: F with group separators between the thousands.
+//  - E[n]: one digit, n more after the decimal point (6 by default) and an exponent
+//    with a sign and at least 3 digits: 1.234560E+003.
+//  - C[n]: N after the currency symbol, in parentheses when negative.
+//  - P[n]: N of the value times 100, followed by a space and the percent symbol.
+//
+// The separators and symbols are those of .NET's invariant culture unless compile() is
+// given others, and groups always have three digits. Ties between two representable
+// results round to even like printf, where .NET rounds them away from zero ("F0" of 2.5
+// is "2", not "3"). Negative zero and negative values which round to zero keep their
+// sign, like in .NET Core 3.0 and later. Nothing is null terminated.
+
+// The most digits format() generates: all the integer and fraction digits of a double
+// in F, N, C and P with the largest precision, plus a terminator.
+#define DOUBLEFORMAT_FIXEDDIGITSSIZE (DOUBLETOCHARS_SCRATCHSIZE + DOUBLE_MAXFRACTIONDIGITS)
+
+// The smallest exponent from which the shortest round trip digits are written in
+// scientific notation, .NET's precision of a double.
+#define DOUBLEFORMAT_SHORTESTSCIENTIFICEXPONENT 15
+
+// UTF-8 strings, none of them may be NULL.
+struct NumberFormatSymbols
+{
+    const char* decimalSeparator;
+    const char* groupSeparator;
+    const char* negativeSign;
+    const char* currencySymbol;
+    const char* percentSymbol;
+    const char* nanSymbol;
+    const char* positiveInfinitySymbol;
+    const char* negativeInfinitySymbol;
+};
+
+// The symbols of .NET's invariant culture. The currency symbol is the generic ¤.
+inline const NumberFormatSymbols& GetInvariantNumberFormatSymbols()
+{
+    static const NumberFormatSymbols symbols = { ".", ",", "-", "\xC2\xA4", "%", "NaN", "Infinity", "-Infinity" };
+    return symbols;
+}
+
+class DoubleFormat
+{
+public:
+    // "G" with the invariant symbols.
+    DoubleFormat();
+
+    // Compiles a format string as described above with the invariant symbols. NULL and ""
+    // are "G". Returns 0, or EINVAL for anything else and for precisions beyond what the
+    // digit engines can generate (NUMBER_MAXDIGITS significant digits for G and E,
+    // DOUBLE_MAXFRACTIONDIGITS digits after the decimal point for F, N, C and P), in
+    // which case the plan is left unchanged.
+    int compile(const char* format);
+
+    // The same with other symbols. The strings are not copied and must outlive the plan.
+    int compile(const char* format, const NumberFormatSymbols& symbols);
+
+    // The DoubleToNumber mode and precision which generate the digits of this plan.
+    DoubleToNumberMode numberMode() const;
+    int numberPrecision() const;
+
+    // The most characters format() writes for any value.
+    size_t maxLength() const;
+
+    // Writes `value` into [first, last). ec is ERANGE if it does not fit.
+    DoubleToCharsResult<char> format(char* first, char* last, double value) const;
+
+    // Writes a NUMBER from DoubleToNumber(value, numberPrecision(), numberMode(), number),
+    // for example one from a DoubleToNumberCache. A NUMBER holds at most NUMBER_MAXDIGITS
+    // significant digits, the digits of F, N, C and P beyond are written as zeros.
+    DoubleToCharsResult<char> format(char* first, char* last, const NUMBER& number) const;
+
+private:
+    enum Kind
+    {
+        KIND_GENERAL,
+        KIND_FIXED,
+        KIND_NUMBER,
+        KIND_SCIENTIFIC,
+        KIND_CURRENCY,
+        KIND_PERCENT,
+    };
+
+    struct Symbol
+    {
+        const char* text;
+        size_t length;
+    };
+
+    static Symbol makeSymbol(const char* text);
+    static char* writeSymbol(char* p, const Symbol& symbol);
+
+    // The number of digits of `exponent`, at least minDigits.
+    static int exponentDigitCount(int exponent, int minDigits);
+
+    // Writes the exponent character, its sign and exponentDigitCount() digits.
+    char* writeExponent(char* p, int exponent, int digitCount) const;
+
+    // Writes integerCount digits, the decimal separator and fractionCount digits, where
+    // the last integer digit has the exponent 0. Digits outside [0, count) are zeros.
+    template <typename TDigit>
+    char* writeFixed(char* p, const TDigit* digits, int count, int dec, int integerCount, int fractionCount, bool hasGroups) const;
+
+    DoubleToCharsResult<char> formatSpecial(char* first, char* last, bool isNaN, bool isNegative) const;
+
+    // Lays out count digits with the exponent `dec`, no digits for zero.
+    template <typename TDigit>
+    DoubleToCharsResult<char> layout(char* first, char* last, const TDigit* digits, int count, int dec, bool isNegative) const;
+
+    // The worst case of layout() and formatSpecial() with the current settings.
+    size_t computeMaxLength() const;
+
+    Kind m_kind;
+    DoubleToNumberMode m_mode;
+    int m_precision;
+
+    // The digits after the decimal point of F, N, C, P and E.
+    int m_fractionCount;
+    char m_exponentChar;
+
+    Symbol m_decimalSeparator;
+    Symbol m_groupSeparator;
+    Symbol m_negativeSign;
+    Symbol m_currencySymbol;
+    Symbol m_percentSymbol;
+    Symbol m_nanSymbol;
+    Symbol m_positiveInfinitySymbol;
+    Symbol m_negativeInfinitySymbol;
+
+    size_t m_maxLength;
+};
+
+inline DoubleFormat::DoubleFormat()
+{
+    compile(NULL);
+}
+
+inline int DoubleFormat::compile(const char* format)
+{
+    return compile(format, GetInvariantNumberFormatSymbols());
+}
+
+inline int DoubleFormat::compile(const char* format, const NumberFormatSymbols& symbols)
+{
+    if (symbols.decimalSeparator == NULL || symbols.groupSeparator == NULL || symbols.negativeSign == NULL
+        || symbols.currencySymbol == NULL || symbols.percentSymbol == NULL || symbols.nanSymbol == NULL
+        || symbols.positiveInfinitySymbol == NULL || symbols.negativeInfinitySymbol == NULL)
+    {
+        return EINVAL;
+    }
+
+    // Step 1:
+    // Split the format string into the letter and the precision, -1 if there is none.
+    // Like .NET the precision has at most 9 digits.
+    const char* p = format == NULL ? "" : format;
+    char letter = *p == 0 ? 'G' : *p++;
+    int precision = -1;
+    if (*p != 0)
+    {
+        precision = 0;
+        int digitCount = 0;
+        while (*p >= '0' && *p <= '9' && digitCount < 9)
+        {
+            precision = precision * 10 + (*p - '0');
+            ++p;
+            ++digitCount;
+        }
+
+        if (digitCount == 0 || *p != 0)
+        {
+            return EINVAL;
+        }
+    }
+
+    // Step 2:
+    // Choose the digits to generate.
+    Kind kind = KIND_GENERAL;
+    DoubleToNumberMode mode = DTN_SHORTEST;
+    int numberPrecision = 0;
+    int fractionCount = 0;
+    switch (letter)
+    {
+    case 'G':
+    case 'g':
+        if (precision > 0)
+        {
+            mode = DTN_PRECISION;
+            numberPrecision = precision;
+        }
+
+        break;
+
+    case 'R':
+    case 'r':
+        break;
+
+    case 'E':
+    case 'e':
+        kind = KIND_SCIENTIFIC;
+        mode = DTN_PRECISION;
+        fractionCount = precision < 0 ? 6 : precision;
+        numberPrecision = fractionCount + 1;
+        break;
+
+    case 'F':
+    case 'f':
+    case 'N':
+    case 'n':
+    case 'C':
+    case 'c':
+        kind = (letter == 'F' || letter == 'f') ? KIND_FIXED : (letter == 'N' || letter == 'n') ? KIND_NUMBER : KIND_CURRENCY;
+        mode = DTN_FIXED;
+        fractionCount = precision < 0 ? 2 : precision;
+        numberPrecision = fractionCount;
+        break;
+
+    case 'P':
+    case 'p':
+        // The digits of value * 100 down to 10^-n are those of value down to 10^-(n + 2).
+        kind = KIND_PERCENT;
+        mode = DTN_FIXED;
+        fractionCount = precision < 0 ? 2 : precision;
+        numberPrecision = fractionCount + 2;
+        break;
+
+    default:
+        return EINVAL;
+    }
+
+    int maxPrecision = mode == DTN_FIXED ? DOUBLE_MAXFRACTIONDIGITS : NUMBER_MAXDIGITS;
+    if (numberPrecision > maxPrecision)
+    {
+        return EINVAL;
+    }
+
+    // Step 3:
+    // Store the plan and work out its longest text.
+    m_kind = kind;
+    m_mode = mode;
+    m_precision = numberPrecision;
+    m_fractionCount = fractionCount;
+    m_exponentChar = (letter >= 'a' && letter <= 'z') ? 'e' : 'E';
+
+    m_decimalSeparator = makeSymbol(symbols.decimalSeparator);
+    m_groupSeparator = makeSymbol(symbols.groupSeparator);
+    m_negativeSign = makeSymbol(symbols.negativeSign);
+    m_currencySymbol = makeSymbol(symbols.currencySymbol);
+    m_percentSymbol = makeSymbol(symbols.percentSymbol);
+    m_nanSymbol = makeSymbol(symbols.nanSymbol);
+    m_positiveInfinitySymbol = makeSymbol(symbols.positiveInfinitySymbol);
+    m_negativeInfinitySymbol = makeSymbol(symbols.negativeInfinitySymbol);
+
+    m_maxLength = computeMaxLength();
+    return 0;
+}
+
+inline DoubleToNumberMode DoubleFormat::numberMode() const
+{
+    return m_mode;
+}
+
+inline int DoubleFormat::numberPrecision() const
+{
+    return m_precision;
+}
+
+inline size_t DoubleFormat::maxLength() const
+{
+    return m_maxLength;
+}
+
+inline DoubleToCharsResult<char> DoubleFormat::format(char* first, char* last, double value) const
+{
+    FPDOUBLE* pValue = (FPDOUBLE*)&value;
+    if (pValue->exp == 0x7FF)
+    {
+        return formatSpecial(first, last, pValue->mantLo != 0 || pValue->mantHi != 0, pValue->sign != 0);
+    }
+
+    int count = 0;
+    int dec = 0;
+    int sign = 0;
+
+    // Unlike a NUMBER the buffer takes all fixed point digits, so F matches printf's %f
+    // for large values too.
+    if (m_mode == DTN_FIXED)
+    {
+        char digits[DOUBLEFORMAT_FIXEDDIGITSSIZE];
+        _fcvt2_s(digits, sizeof(digits), value, m_precision, &count, &dec, &sign);
+        return layout(first, last, digits, count, dec, sign != 0);
+    }
+
+    char digits[NUMBER_MAXDIGITS + 1];
+    if (m_mode == DTN_SHORTEST)
+    {
+        _ecvt2_shortest_s(digits, sizeof(digits), value, &count, &dec, &sign);
+    }
+    else
+    {
+        _ecvt2_s(digits, sizeof(digits), value, m_precision, &dec, &sign);
+        count = m_precision;
+    }
+
+    // Zero has no significant digits.
+    if (digits[0] == '0')
+    {
+        count = 0;
+    }
+
+    return layout(first, last, digits, count, dec, sign != 0);
+}
+
+inline DoubleToCharsResult<char> DoubleFormat::format(char* first, char* last, const NUMBER& number) const
+{
+    if (number.scale == (int)SCALE_NAN || number.scale == SCALE_INF)
+    {
+        return formatSpecial(first, last, number.scale == (int)SCALE_NAN, number.sign != 0);
+    }
+
+    int count = 0;
+    while (count < NUMBER_MAXDIGITS && number.digits[count] != 0)
+    {
+        ++count;
+    }
+
+    return layout(first, last, number.digits, count, number.scale, number.sign != 0);
+}
+
+inline DoubleFormat::Symbol DoubleFormat::makeSymbol(const char* text)
+{
+    Symbol symbol = { text, strlen(text) };
+    return symbol;
+}
+
+inline char* DoubleFormat::writeSymbol(char* p, const Symbol& symbol)
+{
+    memcpy(p, symbol.text, symbol.length);
+    return p + symbol.length;
+}
+
+inline int DoubleFormat::exponentDigitCount(int exponent, int minDigits)
+{
+    int digitCount = 1;
+    for (int rest = exponent < 0 ? -exponent : exponent; rest >= 10; rest /= 10)
+    {
+        ++digitCount;
+    }
+
+    return digitCount < minDigits ? minDigits : digitCount;
+}
+
+inline char* DoubleFormat::writeExponent(char* p, int exponent, int digitCount) const
+{
+    *p++ = m_exponentChar;
+    if (exponent < 0)
+    {
+        p = writeSymbol(p, m_negativeSign);
+        exponent = -exponent;
+    }
+    else
+    {
+        *p++ = '+';
+    }
+
+    for (int i = digitCount - 1; i >= 0; --i)
+    {
+        p[i] = (char)('0' + exponent % 10);
+        exponent /= 10;
+    }
+
+    return p + digitCount;
+}
+
+template <typename TDigit>
+inline char* DoubleFormat::writeFixed(char* p, const TDigit* digits, int count, int dec, int integerCount, int fractionCount, bool hasGroups) const
+{
+    // The index of the first integer digit in digits, negative for leading zeros.
+    int index = dec + 1 - integerCount;
+
+    // Digits until the next group separator.
+    int groupRest = hasGroups ? (integerCount - 1) % 3 + 1 : integerCount;
+    for (int i = 0; i < integerCount; ++i, ++index)
+    {
+        if (groupRest == 0)
+        {
+            p = writeSymbol(p, m_groupSeparator);
+            groupRest = 3;
+        }
+
+        *p++ = (index >= 0 && index < count) ? (char)digits[index] : '0';
+        --groupRest;
+    }
+
+    if (fractionCount > 0)
+    {
+        p = writeSymbol(p, m_decimalSeparator);
+        for (int i = 0; i < fractionCount; ++i, ++index)
+        {
+            *p++ = (index >= 0 && index < count) ? (char)digits[index] : '0';
+        }
+    }
+
+    return p;
+}
+
+inline DoubleToCharsResult<char> DoubleFormat::formatSpecial(char* first, char* last, bool isNaN, bool isNegative) const
+{
+    DoubleToCharsResult<char> result = { last, ERANGE };
+    const Symbol& symbol = isNaN ? m_nanSymbol : isNegative ? m_negativeInfinitySymbol : m_positiveInfinitySymbol;
+    if ((size_t)(last - first) < symbol.length)
+    {
+        return result;
+    }
+
+    result.ptr = writeSymbol(first, symbol);
+    result.ec = 0;
+    return result;
+}
+
+template <typename TDigit>
+inline DoubleToCharsResult<char> DoubleFormat::layout(char* first, char* last, const TDigit* digits, int count, int dec, bool isNegative) const
+{
+    DoubleToCharsResult<char> result = { last, ERANGE };
+    size_t signLength = isNegative ? m_negativeSign.length : 0;
+    char* p = first;
+
+    if (m_kind == KIND_SCIENTIFIC)
+    {
+        // Zero is all zeros with the exponent 0.
+        int exponent = count == 0 ? 0 : dec;
+        int exponentDigits = exponentDigitCount(exponent, 3);
+        size_t length = signLength + 1 + (m_fractionCount > 0 ? m_decimalSeparator.length + m_fractionCount : 0)
+            + 1 + (exponent < 0 ? m_negativeSign.length : 1) + exponentDigits;
+        if ((size_t)(last - first) < length)
+        {
+            return result;
+        }
+
+        if (isNegative)
+        {
+            p = writeSymbol(p, m_negativeSign);
+        }
+
+        p = writeFixed(p, digits, count, 0, 1, m_fractionCount, false);
+        result.ptr = writeExponent(p, exponent, exponentDigits);
+        result.ec = 0;
+        return result;
+    }
+
+    if (m_kind == KIND_GENERAL)
+    {
+        while (count > 0 && digits[count - 1] == '0')
+        {
+            --count;
+        }
+
+        int threshold = m_precision;
+        if (m_mode == DTN_SHORTEST)
+        {
+            threshold = count > DOUBLEFORMAT_SHORTESTSCIENTIFICEXPONENT ? count : DOUBLEFORMAT_SHORTESTSCIENTIFICEXPONENT;
+        }
+
+        if (count > 0 && (dec < -4 || dec >= threshold))
+        {
+            int exponentDigits = exponentDigitCount(dec, 2);
+            size_t length = signLength + 1 + (count > 1 ? m_decimalSeparator.length + count - 1 : 0)
+                + 1 + (dec < 0 ? m_negativeSign.length : 1) + exponentDigits;
+            if ((size_t)(last - first) < length)
+            {
+                return result;
+            }
+
+            if (isNegative)
+            {
+                p = writeSymbol(p, m_negativeSign);
+            }
+
+            p = writeFixed(p, digits, count, 0, 1, count - 1, false);
+            result.ptr = writeExponent(p, dec, exponentDigits);
+            result.ec = 0;
+            return result;
+        }
+
+        // Zero is a single 0.
+        int integerCount = (count > 0 && dec >= 0) ? dec + 1 : 1;
+        int fractionCount = count > dec + 1 ? count - dec - 1 : 0;
+        if (count == 0)
+        {
+            dec = 0;
+            fractionCount = 0;
+        }
+
+        size_t length = signLength + integerCount + (fractionCount > 0 ? m_decimalSeparator.length + fractionCount : 0);
+        if ((size_t)(last - first) < length)
+        {
+            return result;
+        }
+
+        if (isNegative)
+        {
+            p = writeSymbol(p, m_negativeSign);
+        }
+
+        result.ptr = writeFixed(p, digits, count, dec, integerCount, fractionCount, false);
+        result.ec = 0;
+        return result;
+    }
+
+    // F, N, C and P. The digits of P are those of the value / 100.
+    if (m_kind == KIND_PERCENT)
+    {
+        dec += 2;
+    }
+
+    int integerCount = (count > 0 && dec >= 0) ? dec + 1 : 1;
+    bool hasGroups = m_kind != KIND_FIXED;
+    size_t length = integerCount + (m_fractionCount > 0 ? m_decimalSeparator.length + m_fractionCount : 0);
+    if (hasGroups)
+    {
+        length += (size_t)((integerCount - 1) / 3) * m_groupSeparator.length;
+    }
+
+    if (m_kind == KIND_CURRENCY)
+    {
+        length += m_currencySymbol.length + (isNegative ? 2 : 0);
+    }
+    else
+    {
+        length += signLength + (m_kind == KIND_PERCENT ? 1 + m_percentSymbol.length : 0);
+    }
+
+    if ((size_t)(last - first) < length)
+    {
+        return result;
+    }
+
+    if (m_kind == KIND_CURRENCY)
+    {
+        if (isNegative)
+        {
+            *p++ = '(';
+        }
+
+        p = writeSymbol(p, m_currencySymbol);
+    }
+    else if (isNegative)
+    {
+        p = writeSymbol(p, m_negativeSign);
+    }
+
+    p = writeFixed(p, digits, count, count > 0 ? dec : 0, integerCount, m_fractionCount, hasGroups);
+
+    if (m_kind == KIND_CURRENCY && isNegative)
+    {
+        *p++ = ')';
+    }
+    else if (m_kind == KIND_PERCENT)
+    {
+        *p++ = ' ';
+        p = writeSymbol(p, m_percentSymbol);
+    }
+
+    result.ptr = p;
+    result.ec = 0;
+    return result;
+}
+
+inline size_t DoubleFormat::computeMaxLength() const
+{
+    size_t specialLength = std::max(m_nanSymbol.length, std::max(m_positiveInfinitySymbol.length, m_negativeInfinitySymbol.length));
+    size_t exponentSignLength = std::max(m_negativeSign.length, (size_t)1);
+    size_t length = 0;
+
+    if (m_kind == KIND_SCIENTIFIC)
+    {
+        // The exponents of doubles have at most 3 digits.
+        length = m_negativeSign.length + 1 + (m_fractionCount > 0 ? m_decimalSeparator.length + m_fractionCount : 0)
+            + 1 + exponentSignLength + 3;
+    }
+    else if (m_kind == KIND_GENERAL)
+    {
+        // Scientific, an integer part of up to `threshold` digits followed by the rest of
+        // the digits, or 0. with up to 4 zeros before the digits.
+        size_t maxCount = m_mode == DTN_SHORTEST ? DOUBLE_SHORTEST_MAXDIGITS : (size_t)m_precision;
+        size_t maxThreshold = m_mode == DTN_SHORTEST ? std::max(maxCount, (size_t)DOUBLEFORMAT_SHORTESTSCIENTIFICEXPONENT) : maxCount;
+        size_t scientificLength = 1 + m_decimalSeparator.length + maxCount - 1 + 1 + exponentSignLength + 3;
+        size_t integerLength = maxThreshold + m_decimalSeparator.length + maxCount - 1;
+        size_t fractionLength = 1 + m_decimalSeparator.length + 4 + maxCount;
+        length = m_negativeSign.length + std::max(scientificLength, std::max(integerLength, fractionLength));
+    }
+    else
+    {
+        // The integer part of a double has up to 309 digits, 311 times 100.
+        size_t integerCount = m_kind == KIND_PERCENT ? 311 : 309;
+        length = integerCount + (m_fractionCount > 0 ? m_decimalSeparator.length + m_fractionCount : 0);
+        if (m_kind != KIND_FIXED)
+        {
+            length += (integerCount - 1) / 3 * m_groupSeparator.length;
+        }
+
+        if (m_kind == KIND_CURRENCY)
+        {
+            length += m_currencySymbol.length + 2;
+        }
+        else
+        {
+            length += m_negativeSign.length + (m_kind == KIND_PERCENT ? 1 + m_percentSymbol.length : 0);
+        }
+    }
+
+    return std::max(length, specialLength);
+}
+
+#endif // DOUBLEFORMAT_H
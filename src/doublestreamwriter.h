@@ -0,0 +1,279 @@
+#ifndef DOUBLESTREAMWRITER_H
+#define DOUBLESTREAMWRITER_H
+
+#include "doubletochars.h"
+#include <cerrno>
+#include <climits>
+#include <memory>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Buffered writer for large amounts of doubles in CSV or JSON text, flushed to a file
+// descriptor.
+//
+// Values are formatted with DoubleToChars straight into one large output buffer. Before
+// a run of values is formatted the writer makes sure that the worst case length of all
+// of them (DoubleStreamWriter::maxValueLength() plus a delimiter each) fits into the
+// buffer, flushing first if needed, so the per value work is only the conversion itself.
+// The buffer is written out with write() in big chunks when it is full, on flush() and
+// when the writer is destroyed.
+//
+// Non-finite values are written according to the DoubleStreamNonFinite policy. JSON has
+// no literal for them, so use DOUBLESTREAM_NONFINITE_NULL or DOUBLESTREAM_NONFINITE_QUOTED
+// there.
+
+#define DOUBLESTREAMWRITER_BUFFERSIZE (1024 * 1024)
+
+// The longest shortest round trip output: -1.2345678901234567e-308.
+#define DOUBLESTREAMWRITER_SHORTESTMAXLENGTH 24
+
+enum DoubleStreamNonFinite
+{
+    // nan, inf and -inf.
+    DOUBLESTREAM_NONFINITE_LITERAL = 0,
+
+    // null, as JSON.stringify does.
+    DOUBLESTREAM_NONFINITE_NULL = 1,
+
+    // "NaN", "Infinity" and "-Infinity" in double quotes.
+    DOUBLESTREAM_NONFINITE_QUOTED = 2,
+};
+
+class DoubleStreamWriter
+{
+public:
+    // bufferSize is raised to hold at least one value.
+    explicit DoubleStreamWriter(int fd, size_t bufferSize = DOUBLESTREAMWRITER_BUFFERSIZE);
+
+    // Flushes the buffer. Errors are lost, call flush() first to see them.
+    ~DoubleStreamWriter();
+
+    // 0 writes the shortest round trip digits (the default), 1 to NUMBER_MAXDIGITS writes
+    // that many significant digits like printf's %.*g. Returns EINVAL for anything else.
+    int setPrecision(int precision);
+    void setNonFinite(DoubleStreamNonFinite nonFinite);
+
+    // The most characters a single value can take with the current settings.
+    size_t maxValueLength() const;
+
+    void writeDouble(double value);
+    void writeChar(char c);
+    void writeString(const char* text, size_t length);
+
+    // One CSV record: the values separated by `delimiter`, followed by a newline.
+    void writeRow(const double* values, size_t count, char delimiter = ',');
+
+    // A JSON array of the values: [v0,v1,...].
+    void writeJsonArray(const double* values, size_t count);
+
+    // Writes the buffered text to the file descriptor. Returns 0, or the errno of the
+    // first failed write. After an error all further output is dropped.
+    int flush();
+
+    // The errno of the first failed write, or 0.
+    int error() const;
+
+private:
+    DoubleStreamWriter(const DoubleStreamWriter&);
+    DoubleStreamWriter& operator=(const DoubleStreamWriter&);
+
+    // Makes room for `length` characters, flushing if needed.
+    void reserve(size_t length);
+
+    // Writes values[0..count) with `delimiter` after each but the last. Room for as many
+    // values as possible is reserved at once, appendValue() itself checks nothing.
+    void appendValues(const double* values, size_t count, char delimiter);
+    void appendValue(double value);
+
+    int m_fd;
+    std::unique_ptr<char[]> m_buffer;
+    size_t m_bufferSize;
+    char* m_pCurrent;
+    char* m_pEnd;
+    int m_precision;
+    DoubleStreamNonFinite m_nonFinite;
+    int m_error;
+};
+
+inline DoubleStreamWriter::DoubleStreamWriter(int fd, size_t bufferSize)
+    :m_fd(fd),
+    m_bufferSize(std::max(bufferSize, (size_t)NUMBER_MAXDIGITS + 16)),
+    m_precision(0),
+    m_nonFinite(DOUBLESTREAM_NONFINITE_LITERAL),
+    m_error(0)
+{
+    m_buffer.reset(new char[m_bufferSize]);
+    m_pCurrent = m_buffer.get();
+    m_pEnd = m_pCurrent + m_bufferSize;
+}
+
+inline DoubleStreamWriter::~DoubleStreamWriter()
+{
+    flush();
+}
+
+inline int DoubleStreamWriter::setPrecision(int precision)
+{
+    if (precision < 0 || precision > NUMBER_MAXDIGITS)
+    {
+        return EINVAL;
+    }
+
+    m_precision = precision;
+    return 0;
+}
+
+inline void DoubleStreamWriter::setNonFinite(DoubleStreamNonFinite nonFinite)
+{
+    m_nonFinite = nonFinite;
+}
+
+inline size_t DoubleStreamWriter::maxValueLength() const
+{
+    // %.*g: -d.ddde-308 is 7 characters longer than the digits and longer than any fixed
+    // notation it chooses (at most -0.0000ddd). "-Infinity" in quotes takes 11.
+    size_t length = m_precision == 0 ? DOUBLESTREAMWRITER_SHORTESTMAXLENGTH : (size_t)m_precision + 7;
+    return std::max(length, (size_t)11);
+}
+
+inline void DoubleStreamWriter::writeDouble(double value)
+{
+    reserve(maxValueLength());
+    appendValue(value);
+}
+
+inline void DoubleStreamWriter::writeChar(char c)
+{
+    reserve(1);
+    *m_pCurrent++ = c;
+}
+
+inline void DoubleStreamWriter::writeString(const char* text, size_t length)
+{
+    while (length > 0)
+    {
+        reserve(1);
+
+        size_t chunk = std::min(length, (size_t)(m_pEnd - m_pCurrent));
+        memcpy(m_pCurrent, text, chunk);
+        m_pCurrent += chunk;
+        text += chunk;
+        length -= chunk;
+    }
+}
+
+inline void DoubleStreamWriter::writeRow(const double* values, size_t count, char delimiter)
+{
+    appendValues(values, count, delimiter);
+    writeChar('\n');
+}
+
+inline void DoubleStreamWriter::writeJsonArray(const double* values, size_t count)
+{
+    writeChar('[');
+    appendValues(values, count, ',');
+    writeChar(']');
+}
+
+inline int DoubleStreamWriter::flush()
+{
+    const char* pData = m_buffer.get();
+    size_t length = m_pCurrent - pData;
+    m_pCurrent = m_buffer.get();
+
+    while (length > 0 && m_error == 0)
+    {
+#ifdef _WIN32
+        int written = _write(m_fd, pData, (unsigned int)std::min(length, (size_t)INT_MAX));
+#else
+        ssize_t written = write(m_fd, pData, length);
+#endif
+        if (written < 0)
+        {
+            if (errno != EINTR)
+            {
+                m_error = errno;
+            }
+
+            continue;
+        }
+
+        pData += written;
+        length -= written;
+    }
+
+    return m_error;
+}
+
+inline int DoubleStreamWriter::error() const
+{
+    return m_error;
+}
+
+inline void DoubleStreamWriter::reserve(size_t length)
+{
+    if ((size_t)(m_pEnd - m_pCurrent) < length)
+    {
+        flush();
+    }
+}
+
+inline void DoubleStreamWriter::appendValues(const double* values, size_t count, char delimiter)
+{
+    size_t perValue = maxValueLength() + 1;
+    bool isEmpty = count == 0;
+    while (count > 0)
+    {
+        reserve(perValue);
+
+        // As many values as surely fit into the rest of the buffer.
+        size_t batchCount = std::min(count, (size_t)(m_pEnd - m_pCurrent) / perValue);
+        for (size_t i = 0; i < batchCount; ++i)
+        {
+            appendValue(values[i]);
+            *m_pCurrent++ = delimiter;
+        }
+
+        values += batchCount;
+        count -= batchCount;
+    }
+
+    // No delimiter after the last value. It was written right after the value, so it is
+    // still in the buffer.
+    if (!isEmpty)
+    {
+        --m_pCurrent;
+    }
+}
+
+inline void DoubleStreamWriter::appendValue(double value)
+{
+    const FPDOUBLE* pValue = (const FPDOUBLE*)&value;
+    if (pValue->exp == 0x7FF && m_nonFinite != DOUBLESTREAM_NONFINITE_LITERAL)
+    {
+        bool isNaN = pValue->mantLo || pValue->mantHi;
+        const char* text = "null";
+        if (m_nonFinite == DOUBLESTREAM_NONFINITE_QUOTED)
+        {
+            text = isNaN ? "\"NaN\"" : pValue->sign ? "\"-Infinity\"" : "\"Infinity\"";
+        }
+
+        size_t length = strlen(text);
+        memcpy(m_pCurrent, text, length);
+        m_pCurrent += length;
+        return;
+    }
+
+    // The whole rest of the buffer is passed so that the digits are generated in place.
+    DoubleToCharsResult<char> result = m_precision == 0
+        ? DoubleToChars(m_pCurrent, m_pEnd, value)
+        : DoubleToChars(m_pCurrent, m_pEnd, value, CHARS_FORMAT_GENERAL, m_precision);
+
+    m_pCurrent = result.ptr;
+}
+
+#endif // DOUBLESTREAMWRITER_H
@@ -0,0 +1,341 @@
+#ifndef DOUBLETOCHARS_H
+#define DOUBLETOCHARS_H
+
+#include "doubletonumber.h"
+#include <cstddef>
+#include <cstring>
+
+// std::to_chars style formatting of doubles straight into a caller supplied range of
+// characters, without going through NUMBER.
+//
+// The digit engines write their digits directly into the output range, where they are
+// laid out in place (the digits after the decimal point move up by one). Only when the
+// rest of the range is shorter than DOUBLETOCHARS_SCRATCHSIZE the digits are generated
+// into a buffer on the stack first, because the engines may need room for more digits
+// and a terminator than the formatted text takes. The buffer holds the digits of the
+// largest double, so only the general format with a precision above that and trailing
+// zeros which are removed afterwards can fail with ERANGE although the text would fit.
+//
+// The output is the same as printf with "%.*e", "%.*f" and "%.*g" in the "C" locale, or
+// with the shortest round trip digits when no precision is given. Nothing is null
+// terminated.
+
+// The integer part of a double has up to 309 digits.
+#define DOUBLETOCHARS_SCRATCHSIZE (309 + 1)
+
+enum CharsFormat
+{
+    CHARS_FORMAT_SCIENTIFIC = 1,
+    CHARS_FORMAT_FIXED = 2,
+    CHARS_FORMAT_GENERAL = CHARS_FORMAT_SCIENTIFIC | CHARS_FORMAT_FIXED,
+};
+
+template <typename TChar>
+struct DoubleToCharsResult
+{
+    // One past the last character written, or `last` on error.
+    TChar* ptr;
+
+    // 0 on success, ERANGE if the range is too small.
+    int ec;
+};
+
+// Writes `exponent` as e+dd, e-dd or e+ddd. Returns the end, or NULL if it does not fit.
+template <typename TChar>
+TChar* WriteCharsExponent(TChar* first, TChar* last, int exponent)
+{
+    int length = (exponent <= -100 || exponent >= 100) ? 5 : 4;
+    if (last - first < length)
+    {
+        return NULL;
+    }
+
+    first[0] = 'e';
+    first[1] = exponent < 0 ? '-' : '+';
+    if (exponent < 0)
+    {
+        exponent = -exponent;
+    }
+
+    TChar* pEnd = first + length;
+    for (TChar* pCurrent = pEnd - 1; pCurrent > first + 1; --pCurrent)
+    {
+        *pCurrent = (TChar)('0' + exponent % 10);
+        exponent /= 10;
+    }
+
+    return pEnd;
+}
+
+// Lays out `count` digits d0 d1 ... (value d0.d1... * 10^dec) found at pDigits as
+// d0.d1...e+dec with `fractionCount` digits after the decimal point, starting at first.
+// pDigits may be equal to first.
+template <typename TChar>
+TChar* WriteCharsScientific(TChar* first, TChar* last, const TChar* pDigits, int count, int dec, int fractionCount)
+{
+    ptrdiff_t length = 1 + (fractionCount > 0 ? 1 + fractionCount : 0);
+    if (last - first < length)
+    {
+        return NULL;
+    }
+
+    TChar firstDigit = pDigits[0];
+    if (fractionCount > 0)
+    {
+        memmove(first + 2, pDigits + 1, (count - 1) * sizeof(TChar));
+        first[1] = '.';
+
+        for (int i = count - 1; i < fractionCount; ++i)
+        {
+            first[2 + i] = '0';
+        }
+    }
+
+    first[0] = firstDigit;
+
+    return WriteCharsExponent(first + length, last, dec);
+}
+
+// Lays out `count` digits (value d0.d1... * 10^dec) found at pDigits as a plain decimal
+// number with `fractionCount` digits after the decimal point, starting at first. count
+// may be 0 for the value zero. pDigits may be equal to first.
+template <typename TChar>
+TChar* WriteCharsFixed(TChar* first, TChar* last, const TChar* pDigits, int count, int dec, int fractionCount)
+{
+    int integerCount = (count == 0 || dec < 0) ? 1 : dec + 1;
+    ptrdiff_t length = integerCount + (fractionCount > 0 ? 1 + fractionCount : 0);
+    if (last - first < length)
+    {
+        return NULL;
+    }
+
+    TChar* pFraction = first + integerCount + 1;
+    int fractionWritten = 0;
+    if (count == 0)
+    {
+        first[0] = '0';
+    }
+    else if (dec < 0)
+    {
+        // 0.000ddd
+        int leadingZeros = -dec - 1;
+        memmove(pFraction + leadingZeros, pDigits, count * sizeof(TChar));
+        first[0] = '0';
+
+        for (int i = 0; i < leadingZeros; ++i)
+        {
+            pFraction[i] = '0';
+        }
+
+        fractionWritten = leadingZeros + count;
+    }
+    else if (count > integerCount)
+    {
+        // ddd.ddd
+        memmove(pFraction, pDigits + integerCount, (count - integerCount) * sizeof(TChar));
+        memmove(first, pDigits, integerCount * sizeof(TChar));
+        fractionWritten = count - integerCount;
+    }
+    else
+    {
+        // ddd000
+        memmove(first, pDigits, count * sizeof(TChar));
+        for (int i = count; i < integerCount; ++i)
+        {
+            first[i] = '0';
+        }
+    }
+
+    if (fractionCount > 0)
+    {
+        pFraction[-1] = '.';
+        for (int i = fractionWritten; i < fractionCount; ++i)
+        {
+            pFraction[i] = '0';
+        }
+    }
+
+    return first + length;
+}
+
+// A format of 0 selects the shorter notation and is only valid with isShortest.
+template <typename TChar>
+DoubleToCharsResult<TChar> DoubleToCharsImpl(TChar* first, TChar* last, double value, CharsFormat format, int precision, bool isShortest)
+{
+    DoubleToCharsResult<TChar> result = { last, ERANGE };
+
+    FPDOUBLE* pValue = (FPDOUBLE*)&value;
+    if (pValue->sign)
+    {
+        if (first == last)
+        {
+            return result;
+        }
+
+        *first = '-';
+        ++first;
+    }
+
+    if (pValue->exp == 0x7FF)
+    {
+        const char* text = (pValue->mantLo || pValue->mantHi) ? "nan" : "inf";
+        if (last - first < 3)
+        {
+            return result;
+        }
+
+        for (int i = 0; i < 3; ++i)
+        {
+            first[i] = text[i];
+        }
+
+        result.ptr = first + 3;
+        result.ec = 0;
+        return result;
+    }
+
+    // Generate the digits in place unless the range is nearly full.
+    TChar scratch[DOUBLETOCHARS_SCRATCHSIZE];
+    TChar* pDigits = first;
+    size_t digitsSize = last - first;
+    if (digitsSize < DOUBLETOCHARS_SCRATCHSIZE)
+    {
+        pDigits = scratch;
+        digitsSize = DOUBLETOCHARS_SCRATCHSIZE;
+    }
+
+    bool isZero = pValue->exp == 0 && pValue->mantHi == 0 && pValue->mantLo == 0;
+    int count = 0;
+    int dec = 0;
+    int sign = 0;
+    int fractionCount = 0;
+    bool isScientific = format == CHARS_FORMAT_SCIENTIFIC;
+
+    if (isShortest)
+    {
+        if (_ecvt2_shortest_s(pDigits, digitsSize, value, &count, &dec, &sign) != 0)
+        {
+            return result;
+        }
+
+        if (format == CHARS_FORMAT_GENERAL)
+        {
+            // printf's %g style selection with its default precision of 6.
+            isScientific = dec < -4 || dec >= 6;
+        }
+        else if (format == 0)
+        {
+            // The shorter of the two, plain decimal on a tie.
+            int exponentLength = (dec <= -100 || dec >= 100) ? 5 : 4;
+            int scientificLength = count + (count > 1 ? 1 : 0) + exponentLength;
+            int fixedLength = dec < 0 ? 1 - dec + count : std::max(dec + 1, count) + (count > dec + 1 ? 1 : 0);
+            isScientific = scientificLength < fixedLength;
+        }
+
+        fractionCount = isScientific ? count - 1 : std::max(0, count - 1 - dec);
+
+        // Shortest digits followed by zeros only happen for integers. Like std::to_chars
+        // we print their exact digits instead, which are just as long.
+        if (!isScientific && count < dec + 1)
+        {
+            if (_fcvt2_s(pDigits, digitsSize, value, 0, &count, &dec, &sign) != 0 || count < dec + 1)
+            {
+                return result;
+            }
+        }
+    }
+    else if (format == CHARS_FORMAT_FIXED)
+    {
+        // Digits beyond 10^-DOUBLE_MAXFRACTIONDIGITS are always zero.
+        int fractionDigits = std::min(precision, DOUBLE_MAXFRACTIONDIGITS);
+        if (_fcvt2_s(pDigits, digitsSize, value, fractionDigits, &count, &dec, &sign) != 0)
+        {
+            return result;
+        }
+
+        // The engine stops at the end of the buffer.
+        if (count != 0 && count < dec + 1 + fractionDigits)
+        {
+            return result;
+        }
+
+        fractionCount = precision;
+    }
+    else
+    {
+        size_t requestedCount = format == CHARS_FORMAT_SCIENTIFIC ? (size_t)precision + 1 : (size_t)std::max(precision, 1);
+        if (requestedCount >= digitsSize)
+        {
+            return result;
+        }
+
+        int digitCount = (int)requestedCount;
+
+        if (isZero)
+        {
+            for (int i = 0; i < digitCount; ++i)
+            {
+                pDigits[i] = '0';
+            }
+        }
+        else
+        {
+            _ecvt2_s(pDigits, digitsSize, value, digitCount, &dec, &sign);
+        }
+
+        count = digitCount;
+        fractionCount = precision;
+
+        if (format == CHARS_FORMAT_GENERAL)
+        {
+            // printf's %g: scientific unless the exponent is in [-4, precision), and
+            // without trailing zeros.
+            isScientific = dec < -4 || dec >= digitCount;
+            while (count > 1 && pDigits[count - 1] == '0')
+            {
+                --count;
+            }
+
+            fractionCount = isScientific ? count - 1 : std::max(0, count - 1 - dec);
+        }
+    }
+
+    TChar* pEnd = isScientific
+        ? WriteCharsScientific(first, last, pDigits, count, dec, fractionCount)
+        : WriteCharsFixed(first, last, pDigits, count, dec, fractionCount);
+
+    if (pEnd != NULL)
+    {
+        result.ptr = pEnd;
+        result.ec = 0;
+    }
+
+    return result;
+}
+
+// Shortest round trip digits in the shorter of fixed and scientific notation, like
+// std::to_chars(first, last, value).
+template <typename TChar>
+DoubleToCharsResult<TChar> DoubleToChars(TChar* first, TChar* last, double value)
+{
+    return DoubleToCharsImpl(first, last, value, (CharsFormat)0, 0, true);
+}
+
+// Shortest round trip digits in the given notation, like
+// std::to_chars(first, last, value, format). CHARS_FORMAT_GENERAL chooses the notation
+// like printf's %g.
+template <typename TChar>
+DoubleToCharsResult<TChar> DoubleToChars(TChar* first, TChar* last, double value, CharsFormat format)
+{
+    return DoubleToCharsImpl(first, last, value, format, 0, true);
+}
+
+// Like std::to_chars(first, last, value, format, precision), i.e. printf's %.*e, %.*f
+// and %.*g. A negative precision means 6, like in printf.
+template <typename TChar>
+DoubleToCharsResult<TChar> DoubleToChars(TChar* first, TChar* last, double value, CharsFormat format, int precision)
+{
+    return DoubleToCharsImpl(first, last, value, format, precision < 0 ? 6 : precision, false);
+}
+
+#endif // DOUBLETOCHARS_H
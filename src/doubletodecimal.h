@@ -0,0 +1,426 @@
+#ifndef DOUBLETODECIMAL_H
+#define DOUBLETODECIMAL_H
+
+#include "doubletonumber.h"
+
+// Conversion of doubles into decimal types without a digit string in between.
+//
+// Storing a double into a decimal column used to mean DoubleToNumber and parsing the
+// digits back into an integer. Here Dragon4 appends every chunk of digits it divides out
+// of its numerator straight to a native integer coefficient, and integers below 2^64
+// only need to be rounded. The rounding is exactly that of the digit engines, so the
+// coefficient holds the same digits _fcvt2_s / _ecvt2_s generate, without the trailing
+// zeros.
+
+// A System.Decimal: (-1)^sign * coefficient / 10^scale with a 96 bit coefficient.
+#define DECIMAL96_MAXSCALE 28
+
+// 2^96 - 1 has 29 digits, so 29 digits fit for some coefficients and 28 for all.
+#define DECIMAL96_MAXDIGITS 29
+
+// An IEEE 754 decimal128 in the binary integer decimal (BID) encoding: 34 digits and
+// exponents from -6176 to 6111.
+#define DECIMAL128_MAXDIGITS 34
+#define DECIMAL128_EXPONENTBIAS 6176
+#define DECIMAL128_INF 0x7800000000000000ull
+#define DECIMAL128_NAN 0x7C00000000000000ull
+
+struct DECIMAL96
+{
+    // The coefficient, least significant word first.
+    uint32_t lo;
+    uint32_t mid;
+    uint32_t hi;
+
+    int scale;
+    int sign;
+};
+
+struct DECIMAL128
+{
+    uint64_t low;
+    uint64_t high;
+};
+
+// An unsigned integer of up to 128 bits in 32 bit words, least significant first, the
+// way DECIMAL96 stores its coefficient. Nothing checks for overflow.
+class DecimalCoefficient
+{
+public:
+    DecimalCoefficient();
+
+    bool isZero() const;
+    bool isOdd() const;
+    uint32_t word(int index) const;
+
+    void setUInt64(uint64_t value);
+    void increment();
+
+    // this = this * factor + addend.
+    void multiplyAdd(uint32_t factor, uint32_t addend);
+
+    // Divides by `divisor` and returns the remainder.
+    uint32_t divide(uint32_t divisor);
+
+private:
+    static const int WORDCOUNT = 4;
+
+    uint32_t m_words[WORDCOUNT];
+};
+
+inline DecimalCoefficient::DecimalCoefficient()
+{
+    setUInt64(0);
+}
+
+inline bool DecimalCoefficient::isZero() const
+{
+    return (m_words[0] | m_words[1] | m_words[2] | m_words[3]) == 0;
+}
+
+inline bool DecimalCoefficient::isOdd() const
+{
+    return (m_words[0] & 1) != 0;
+}
+
+inline uint32_t DecimalCoefficient::word(int index) const
+{
+    return m_words[index];
+}
+
+inline void DecimalCoefficient::setUInt64(uint64_t value)
+{
+    m_words[0] = (uint32_t)value;
+    m_words[1] = (uint32_t)(value >> 32);
+    m_words[2] = 0;
+    m_words[3] = 0;
+}
+
+inline void DecimalCoefficient::increment()
+{
+    for (int i = 0; i < WORDCOUNT && ++m_words[i] == 0; ++i)
+    {
+    }
+}
+
+inline void DecimalCoefficient::multiplyAdd(uint32_t factor, uint32_t addend)
+{
+    uint64_t carry = addend;
+    for (int i = 0; i < WORDCOUNT; ++i)
+    {
+        uint64_t product = (uint64_t)m_words[i] * factor + carry;
+        m_words[i] = (uint32_t)product;
+        carry = product >> 32;
+    }
+}
+
+inline uint32_t DecimalCoefficient::divide(uint32_t divisor)
+{
+    uint64_t remainder = 0;
+    for (int i = WORDCOUNT - 1; i >= 0; --i)
+    {
+        uint64_t dividend = (remainder << 32) | m_words[i];
+        m_words[i] = (uint32_t)(dividend / divisor);
+        remainder = dividend % divisor;
+    }
+
+    return (uint32_t)remainder;
+}
+
+// Dragon4Cutoff for the value mantissa * 2^exponent, whose highest set bit is
+// mantissaHighBitIdx, with the digits appended to *pCoefficient instead of written out.
+// *pExponent10 receives the exponent of the last digit, so the rounded value is
+// coefficient * 10^exponent10. Digits which are zero because the numerator ran out are
+// not appended, and a carry out of all nines leaves 10^count, which is the same value
+// as the 1 at the next exponent Dragon4Cutoff writes.
+template <typename TBigNum>
+void Dragon4Coefficient(uint64_t mantissa, int exponent, uint32_t mantissaHighBitIdx, Dragon4CutoffMode cutoffMode, int cutoffNumber, int maxCount, DecimalCoefficient* pCoefficient, int* pExponent10)
+{
+    CONVERSIONSTATS_PHASESTART(phaseStart);
+
+    // Steps 2 and 3: numerator / denominator = value / 10^firstDigitExponent, which is in
+    // [0.1, 1) once the estimate is fixed up. See Dragon4Cutoff.
+    int firstDigitExponent = (int)(ceil(double((int)mantissaHighBitIdx + exponent) * 0.30102999566398119521373889472449 - 0.69));
+
+    TBigNum numerator;
+    TBigNum denominator;
+    numerator.setUInt64(mantissa);
+    if (exponent > 0)
+    {
+        TBigNum::shiftLeft(&numerator, exponent);
+        denominator.setUInt64(1);
+    }
+    else
+    {
+        TBigNum::shiftLeft(1, -exponent, denominator);
+    }
+
+    if (firstDigitExponent > 0)
+    {
+        denominator.multiplyPow10(firstDigitExponent);
+    }
+    else if (firstDigitExponent < 0)
+    {
+        numerator.multiplyPow10(-firstDigitExponent);
+    }
+
+    if (TBigNum::compare(numerator, denominator) >= 0)
+    {
+        firstDigitExponent += 1;
+        denominator.multiply(10);
+        CONVERSIONSTATS_COUNT(exponentFixups);
+    }
+
+    CONVERSIONSTATS_PHASEEND(CONVERSIONPHASE_SCALE, phaseStart);
+
+    pCoefficient->setUInt64(0);
+
+    int count = cutoffNumber;
+    if (cutoffMode == DRAGON4_CUTOFF_FRACTIONLENGTH)
+    {
+        count = firstDigitExponent + cutoffNumber;
+        if (count <= 0)
+        {
+            // Zero or one unit at the cutoff, a tie goes to zero.
+            numerator.multiply(2);
+            if (count == 0 && TBigNum::compare(numerator, denominator) > 0)
+            {
+                pCoefficient->setUInt64(1);
+            }
+
+            *pExponent10 = -cutoffNumber;
+            return;
+        }
+    }
+
+    count = std::min(count, maxCount);
+
+    TBigNum::prepareChunkDivide(&numerator, &denominator);
+
+    // Step 4:
+    // Divide out up to DIGITCHUNKCOUNT digits at a time and append them to the coefficient.
+    int digitsNum = 0;
+    while (digitsNum < count && !numerator.isZero())
+    {
+        int chunkCount = std::min(count - digitsNum, (int)TBigNum::DIGITCHUNKCOUNT);
+        numerator.multiply((uint32_t)UINT64_POWERSOFTEN[chunkCount]);
+        uint32_t chunk = TBigNum::heuristicDivide(&numerator, denominator);
+        pCoefficient->multiplyAdd((uint32_t)UINT64_POWERSOFTEN[chunkCount], chunk);
+        digitsNum += chunkCount;
+    }
+
+    CONVERSIONSTATS_PHASEEND(CONVERSIONPHASE_DIGITS, phaseStart);
+
+    // Step 5:
+    // Round half to even, like the last digit of Dragon4Cutoff.
+    if (!numerator.isZero())
+    {
+        numerator.multiply(2);
+        int compareResult = TBigNum::compare(numerator, denominator);
+        if (compareResult > 0 || (compareResult == 0 && pCoefficient->isOdd()))
+        {
+            pCoefficient->increment();
+        }
+    }
+
+    *pExponent10 = firstDigitExponent - digitsNum;
+
+    CONVERSIONSTATS_PHASEEND(CONVERSIONPHASE_ROUND, phaseStart);
+}
+
+// Dragon4Coefficient on the narrowest integer the numerator and denominator fit into,
+// like Dragon4CutoffTiered.
+template <typename TBigNum>
+void Dragon4CoefficientTiered(uint64_t mantissa, int exponent, uint32_t mantissaHighBitIdx, Dragon4CutoffMode cutoffMode, int cutoffNumber, int maxCount, DecimalCoefficient* pCoefficient, int* pExponent10)
+{
+    uint32_t zeroBits = TrailingZeroBits(mantissa);
+    mantissa >>= zeroBits;
+    exponent += (int)zeroBits;
+    mantissaHighBitIdx -= zeroBits;
+
+    int denominatorBits = Dragon4DenominatorBits(exponent, mantissaHighBitIdx);
+    if (denominatorBits <= NativeNum64::MAXDENOMINATORBITS)
+    {
+        CONVERSIONSTATS_ENGINE(CONVERSIONENGINE_NATIVE64);
+        Dragon4Coefficient<NativeNum64>(mantissa, exponent, mantissaHighBitIdx, cutoffMode, cutoffNumber, maxCount, pCoefficient, pExponent10);
+        return;
+    }
+
+#if defined(__SIZEOF_INT128__)
+    if (denominatorBits <= NativeNum128::MAXDENOMINATORBITS)
+    {
+        CONVERSIONSTATS_ENGINE(CONVERSIONENGINE_NATIVE128);
+        Dragon4Coefficient<NativeNum128>(mantissa, exponent, mantissaHighBitIdx, cutoffMode, cutoffNumber, maxCount, pCoefficient, pExponent10);
+        return;
+    }
+#endif
+
+    CONVERSIONSTATS_ENGINE(CONVERSIONENGINE_BIGNUM);
+    Dragon4Coefficient<TBigNum>(mantissa, exponent, mantissaHighBitIdx, cutoffMode, cutoffNumber, maxCount, pCoefficient, pExponent10);
+}
+
+// The absolute value of a finite double rounded like Dragon4Cutoff (maxCount <= 38) as
+// coefficient * 10^exponent10, with the trailing zeros of the coefficient removed.
+// Zero gives a zero coefficient and exponent10 0.
+inline void DoubleToCoefficient(double value, Dragon4CutoffMode cutoffMode, int cutoffNumber, int maxCount, DecimalCoefficient* pCoefficient, int* pExponent10)
+{
+    pCoefficient->setUInt64(0);
+    *pExponent10 = 0;
+
+    // Step 1: extract the mantissa and exponent.
+    const FPDOUBLE* pValue = (const FPDOUBLE*)&value;
+    uint64_t mantissa = ((uint64_t)pValue->mantHi << 32) | pValue->mantLo;
+    if (pValue->exp == 0 && mantissa == 0)
+    {
+        return;
+    }
+
+    int exponent = -1074;
+    uint32_t mantissaHighBitIdx = BigNum::logBase2(mantissa);
+    if (pValue->exp > 0)
+    {
+        mantissa += (uint64_t)1 << 52;
+        exponent = pValue->exp - 1075;
+        mantissaHighBitIdx = 52;
+    }
+
+    CONVERSIONSTATS_CALL(mantissa, exponent);
+
+    // Step 2: an integer below 2^64 is its own coefficient, unless it has more digits
+    // than requested. Then they are dropped with half to even rounding like
+    // UInt64ToDigits, a carry into a new digit is just a larger coefficient here.
+    uint64_t integer = 0;
+    if (TryGetUInt64(mantissa, exponent, mantissaHighBitIdx, 64, &integer))
+    {
+        CONVERSIONSTATS_ENGINE(CONVERSIONENGINE_UINT64);
+        int length = UInt64DigitCount(integer);
+        int count = std::min(cutoffMode == DRAGON4_CUTOFF_FRACTIONLENGTH ? length + cutoffNumber : cutoffNumber, maxCount);
+        if (length > count)
+        {
+            uint64_t divisor = UINT64_POWERSOFTEN[length - count];
+            uint64_t remainder = integer % divisor;
+            integer /= divisor;
+
+            uint64_t half = divisor / 2;
+            if (remainder > half || (remainder == half && (integer & 1) != 0))
+            {
+                ++integer;
+            }
+
+            *pExponent10 = length - count;
+        }
+
+        pCoefficient->setUInt64(integer);
+    }
+    else
+    {
+        // Below 10^-(cutoffNumber + 1) the value rounds to zero, see GenerateFixedDigits.
+        int estimatedExponent = (int)(ceil(double((int)mantissaHighBitIdx + exponent) * 0.30102999566398119521373889472449 - 0.69));
+        if (cutoffMode == DRAGON4_CUTOFF_FRACTIONLENGTH && estimatedExponent + cutoffNumber < -1)
+        {
+            return;
+        }
+
+        Dragon4CoefficientTiered<BigNum>(mantissa, exponent, mantissaHighBitIdx, cutoffMode, cutoffNumber, maxCount, pCoefficient, pExponent10);
+    }
+
+    // Step 3: remove the trailing zeros.
+    if (pCoefficient->isZero())
+    {
+        *pExponent10 = 0;
+        return;
+    }
+
+    for (;;)
+    {
+        DecimalCoefficient quotient = *pCoefficient;
+        if (quotient.divide(10) != 0)
+        {
+            break;
+        }
+
+        *pCoefficient = quotient;
+        *pExponent10 += 1;
+    }
+}
+
+// Converts a double to a System.Decimal with at most `precision` (1 <= precision <=
+// DECIMAL96_MAXDIGITS) significant digits and at most DECIMAL96_MAXSCALE digits after
+// the decimal point: the digits _fcvt2_s(buffer, precision + 1, value, DECIMAL96_MAXSCALE,
+// ...) generates, without trailing zeros after the decimal point. The sign is that of
+// the double, also when the value rounds to zero. Returns 0 on success, EINVAL for
+// invalid arguments and NaN, and ERANGE for infinity and values whose coefficient needs
+// more than 96 bits.
+inline int DoubleToDecimal(double value, int precision, DECIMAL96* decimal)
+{
+    if (decimal == NULL || precision < 1 || precision > DECIMAL96_MAXDIGITS)
+    {
+        return EINVAL;
+    }
+
+    const FPDOUBLE* pValue = (const FPDOUBLE*)&value;
+    if (pValue->exp == 0x7FF)
+    {
+        return (pValue->mantLo || pValue->mantHi) ? EINVAL : ERANGE;
+    }
+
+    DecimalCoefficient coefficient;
+    int exponent10 = 0;
+    DoubleToCoefficient(value, DRAGON4_CUTOFF_FRACTIONLENGTH, DECIMAL96_MAXSCALE, precision, &coefficient, &exponent10);
+
+    // A scale can not be negative, so whole numbers get their zeros back. The
+    // coefficient is below 2^96 before every multiplication, which leaves room for it.
+    for (; exponent10 > 0 && coefficient.word(3) == 0; --exponent10)
+    {
+        coefficient.multiplyAdd(10, 0);
+    }
+
+    if (coefficient.word(3) != 0)
+    {
+        return ERANGE;
+    }
+
+    decimal->lo = coefficient.word(0);
+    decimal->mid = coefficient.word(1);
+    decimal->hi = coefficient.word(2);
+    decimal->scale = -exponent10;
+    decimal->sign = pValue->sign;
+
+    return 0;
+}
+
+// Converts a double to a decimal128 in the BID encoding with at most `precision` (1 <=
+// precision <= DECIMAL128_MAXDIGITS) significant digits: the digits _ecvt2_s generates,
+// without the trailing zeros. Every double fits, NaN and infinity are encoded as quiet
+// NaN and infinity with the sign of the double. Returns 0 on success and EINVAL for
+// invalid arguments.
+inline int DoubleToDecimal128(double value, int precision, DECIMAL128* decimal)
+{
+    if (decimal == NULL || precision < 1 || precision > DECIMAL128_MAXDIGITS)
+    {
+        return EINVAL;
+    }
+
+    const FPDOUBLE* pValue = (const FPDOUBLE*)&value;
+    uint64_t signBit = (uint64_t)pValue->sign << 63;
+    if (pValue->exp == 0x7FF)
+    {
+        decimal->low = 0;
+        decimal->high = signBit | ((pValue->mantLo || pValue->mantHi) ? DECIMAL128_NAN : DECIMAL128_INF);
+        return 0;
+    }
+
+    DecimalCoefficient coefficient;
+    int exponent10 = 0;
+    DoubleToCoefficient(value, DRAGON4_CUTOFF_TOTALLENGTH, precision, precision, &coefficient, &exponent10);
+
+    // A coefficient below 10^34 < 2^113 takes the form with the exponent in bits 49 to
+    // 62 and the upper 49 bits of the coefficient below it.
+    decimal->low = ((uint64_t)coefficient.word(1) << 32) | coefficient.word(0);
+    decimal->high = signBit | ((uint64_t)(exponent10 + DECIMAL128_EXPONENTBIAS) << 49)
+        | ((uint64_t)coefficient.word(3) << 32) | coefficient.word(2);
+
+    return 0;
+}
+
+#endif // DOUBLETODECIMAL_H
@@ -0,0 +1,241 @@
+#include "doubletonumber.h"
+#include "floatdigits.h"
+#include <cstdlib>
+
+char * __cdecl
+_ecvt2(double value, int count, int * dec, int * sign)
+{
+    if (count < 1)
+    {
+        count = 1;
+    }
+
+    char* digits = (char *)malloc(count + 1);
+    if (digits != NULL)
+    {
+        _ecvt2_s(digits, count + 1, value, count, dec, sign);
+    }
+
+    return digits;
+}
+
+void DoubleToNumber(double value, int precision, DoubleToNumberMode mode, NUMBER* number)
+{
+    number->precision = precision;
+    if (((FPDOUBLE*)&value)->exp == 0x7FF)
+    {
+        number->scale = (((FPDOUBLE*)&value)->mantLo || ((FPDOUBLE*)&value)->mantHi) ? SCALE_NAN : SCALE_INF;
+        number->sign = ((FPDOUBLE*)&value)->sign;
+        number->digits[0] = 0;
+        return;
+    }
+
+    int result = 0;
+    if (mode == DTN_SHORTEST)
+    {
+        result = _ecvt2_shortest_s(number->digits, NUMBER_MAXDIGITS + 1, value, &number->precision, &number->scale, &number->sign);
+    }
+    else if (mode == DTN_FIXED)
+    {
+        result = _fcvt2_s(number->digits, NUMBER_MAXDIGITS + 1, value, precision, &number->precision, &number->scale, &number->sign);
+    }
+    else
+    {
+        result = _ecvt2_s(number->digits, NUMBER_MAXDIGITS + 1, value, precision, &number->scale, &number->sign);
+    }
+
+    // Zero has no significant digits.
+    if (result == 0 && number->digits[0] == '0')
+    {
+        number->digits[0] = 0;
+    }
+}
+
+void DoubleToNumber(double value, int precision, NUMBER* number)
+{
+    DoubleToNumber(value, precision, DTN_PRECISION, number);
+}
+
+void FloatToNumber(float value, int precision, DoubleToNumberMode mode, NUMBER* number)
+{
+    // Step 1:
+    // Extract meta data from the input float value.
+    //
+    // Refer to IEEE single precision floating point format.
+    FPSINGLE* pValue = (FPSINGLE*)&value;
+    uint64_t realMantissa = pValue->mant;
+    int realExponent = -149;
+    uint32_t mantissaHighBitIdx = 23;
+    bool hasUnequalMargins = false;
+    if (pValue->exp > 0)
+    {
+        hasUnequalMargins = realMantissa == 0 && pValue->exp > 1;
+        realMantissa += (uint64_t)1 << 23;
+        realExponent = pValue->exp - 150;
+    }
+    else
+    {
+        mantissaHighBitIdx = BigNum::logBase2(realMantissa);
+    }
+
+    // NaN, infinity, zero and invalid arguments are left to the double version, which
+    // produces the same result for them.
+    bool isValid = mode == DTN_SHORTEST
+        || (mode == DTN_FIXED && precision >= 0 && precision <= DOUBLE_MAXFRACTIONDIGITS)
+        || (mode == DTN_PRECISION && precision >= 1 && precision <= NUMBER_MAXDIGITS);
+    if (pValue->exp == 0xFF || realMantissa == 0 || !isValid)
+    {
+        DoubleToNumber((double)value, precision, mode, number);
+        return;
+    }
+
+    number->precision = precision;
+    number->sign = pValue->sign;
+
+    // Step 2:
+    // Generate the digits. FloatDigits takes them out of one product with a 64 bit
+    // approximation of a power of ten. What it can not decide, a handful of ties and
+    // near ties and in fixed mode the integer parts beyond 2^58, goes through the tiers of
+    // the double version.
+    if (mode == DTN_SHORTEST)
+    {
+        if (!FloatDigits::tryRunShortest((uint32_t)realMantissa, realExponent, hasUnequalMargins, number->digits, &number->precision, &number->scale))
+        {
+            number->precision = GenerateShortestDigits<BigNum>(realMantissa, realExponent, mantissaHighBitIdx, hasUnequalMargins, FLOAT_SHORTEST_MAXDIGITS, number->digits, &number->scale);
+        }
+    }
+    else if (mode == DTN_FIXED)
+    {
+        if (!FloatDigits::tryRunFixed((uint32_t)realMantissa, realExponent, precision, NUMBER_MAXDIGITS, number->digits, &number->precision, &number->scale))
+        {
+            number->precision = GenerateFixedDigits<BigNum>(realMantissa, realExponent, mantissaHighBitIdx, precision, NUMBER_MAXDIGITS, number->digits, &number->scale);
+        }
+    }
+    else if (!FloatDigits::tryRunCounted((uint32_t)realMantissa, realExponent, mantissaHighBitIdx, precision, number->digits, &number->scale))
+    {
+        GenerateCountedDigits<BigNum>(realMantissa, realExponent, mantissaHighBitIdx, precision, number->digits, &number->scale);
+    }
+}
+
+void FloatToNumber(float value, int precision, NUMBER* number)
+{
+    FloatToNumber(value, precision, DTN_PRECISION, number);
+}
+
+// Steps 2 and 3 of LongDoubleToNumber and Float128ToNumber. Fills `number` for NaN,
+// infinity, zero and invalid arguments the same way as DoubleToNumber, otherwise generates
+// the digits of the finite value realMantissa * 2^realExponent with LongBigNum.
+template <typename TMantissa>
+static void WideFloatToNumber(TMantissa realMantissa, int realExponent, bool isSpecial, bool hasUnequalMargins, int sign, int shortestMaxCount, int precision, DoubleToNumberMode mode, NUMBER* number)
+{
+    number->precision = precision;
+    number->sign = sign;
+    number->digits[0] = 0;
+
+    if (isSpecial)
+    {
+        number->scale = realMantissa != 0 ? SCALE_NAN : SCALE_INF;
+        return;
+    }
+
+    bool isValid = mode == DTN_SHORTEST
+        || (mode == DTN_FIXED && precision >= 0 && precision <= FLOAT128_MAXFRACTIONDIGITS)
+        || (mode == DTN_PRECISION && precision >= 1 && precision <= NUMBER_MAXDIGITS);
+    if (!isValid)
+    {
+        return;
+    }
+
+    if (realMantissa == 0)
+    {
+        DoubleToNumber(sign ? -0.0 : 0.0, precision, mode, number);
+        return;
+    }
+
+    uint64_t mantissaHigh = (uint64_t)(realMantissa >> 32 >> 32);
+    uint32_t mantissaHighBitIdx = mantissaHigh != 0 ? 64 + BigNum::logBase2(mantissaHigh) : BigNum::logBase2((uint64_t)realMantissa);
+
+    // Values in the range of doubles with a mantissa of up to 64 bits still go through
+    // the Grisu fast path first.
+    if (mode == DTN_SHORTEST)
+    {
+        number->precision = GenerateShortestDigits<LongBigNum>(realMantissa, realExponent, mantissaHighBitIdx, hasUnequalMargins, shortestMaxCount, number->digits, &number->scale);
+    }
+    else if (mode == DTN_FIXED)
+    {
+        number->precision = GenerateFixedDigits<LongBigNum>(realMantissa, realExponent, mantissaHighBitIdx, precision, NUMBER_MAXDIGITS, number->digits, &number->scale);
+    }
+    else
+    {
+        GenerateCountedDigits<LongBigNum>(realMantissa, realExponent, mantissaHighBitIdx, precision, number->digits, &number->scale);
+    }
+}
+
+#if defined(__SIZEOF_INT128__)
+// The binary128 version of DoubleToNumber, for the bits of a __float128 or of a long
+// double with 113 bit mantissa.
+static void QuadToNumber(const FPQUAD* pValue, int precision, DoubleToNumberMode mode, NUMBER* number)
+{
+    // Step 1:
+    // Extract meta data from the input value.
+    //
+    // Refer to IEEE quadruple precision floating point format.
+    BigNumBase::UInt128 realMantissa = ((BigNumBase::UInt128)(((uint64_t)pValue->mant3 << 32) | pValue->mant2) << 64)
+        | ((uint64_t)pValue->mant1 << 32) | pValue->mant0;
+    int realExponent = -16494;
+    bool hasUnequalMargins = false;
+    if (pValue->exp > 0 && pValue->exp < 0x7FFF)
+    {
+        hasUnequalMargins = realMantissa == 0 && pValue->exp > 1;
+        realMantissa += (BigNumBase::UInt128)1 << 112;
+        realExponent = pValue->exp - 16495;
+    }
+
+    WideFloatToNumber(realMantissa, realExponent, pValue->exp == 0x7FFF, hasUnequalMargins, pValue->sign, FLOAT128_SHORTEST_MAXDIGITS, precision, mode, number);
+}
+#endif
+
+void LongDoubleToNumber(long double value, int precision, DoubleToNumberMode mode, NUMBER* number)
+{
+#if LDBL_MANT_DIG == 64
+    // Step 1:
+    // Extract meta data from the input value.
+    //
+    // The integer bit is part of the mantissa, so normal and subnormal values only
+    // differ in the exponent.
+    FPEXTENDED* pValue = (FPEXTENDED*)&value;
+    uint64_t realMantissa = ((uint64_t)pValue->mantHi << 32) | pValue->mantLo;
+    int realExponent = pValue->exp > 0 ? pValue->exp - 16446 : -16445;
+    bool hasUnequalMargins = realMantissa == ((uint64_t)1 << 63) && pValue->exp > 1;
+
+    // The integer bit does not count for NaN and infinity.
+    bool isSpecial = pValue->exp == 0x7FFF;
+    if (isSpecial)
+    {
+        realMantissa <<= 1;
+    }
+
+    WideFloatToNumber(realMantissa, realExponent, isSpecial, hasUnequalMargins, pValue->sign, LONGDOUBLE_SHORTEST_MAXDIGITS, precision, mode, number);
+#elif LDBL_MANT_DIG == 113 && defined(__SIZEOF_INT128__)
+    QuadToNumber((const FPQUAD*)&value, precision, mode, number);
+#else
+    DoubleToNumber((double)value, precision, mode, number);
+#endif
+}
+
+void LongDoubleToNumber(long double value, int precision, NUMBER* number)
+{
+    LongDoubleToNumber(value, precision, DTN_PRECISION, number);
+}
+
+#if defined(__SIZEOF_FLOAT128__) && defined(__SIZEOF_INT128__)
+void Float128ToNumber(__float128 value, int precision, DoubleToNumberMode mode, NUMBER* number)
+{
+    QuadToNumber((const FPQUAD*)&value, precision, mode, number);
+}
+
+void Float128ToNumber(__float128 value, int precision, NUMBER* number)
+{
+    Float128ToNumber(value, precision, DTN_PRECISION, number);
+}
+#endif
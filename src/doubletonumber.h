@@ -1,12 +1,38 @@
-#ifndef DOUBLETONUMER_H
+#ifndef DOUBLETONUMBER_H
 #define DOUBLETONUMBER_H
 
 #include "bignum.h"
+#include "grisu.h"
+#include <cerrno>
+#include <cfloat>
+
+// The CRT style functions are declared __cdecl like their MSVC counterparts, which
+// means nothing to other compilers.
+#if !defined(_MSC_VER) && !defined(__cdecl)
+#define __cdecl
+#endif
 
 #define SCALE_NAN 0x80000000
-#define SCALE_INF 0x7FFFFFFF
+#define SCALE_INF 0x7FFFFFFF
 #define NUMBER_MAXDIGITS 50
 
+// 17 significant digits are always enough to tell two doubles apart.
+#define DOUBLE_SHORTEST_MAXDIGITS 17
+
+// 9 significant digits are always enough to tell two floats apart.
+#define FLOAT_SHORTEST_MAXDIGITS 9
+
+// 21 significant digits for an x87 80 bit long double and 36 for a binary128.
+#define LONGDOUBLE_SHORTEST_MAXDIGITS 21
+#define FLOAT128_SHORTEST_MAXDIGITS 36
+
+// The smallest double, 2^-1074, has 1074 digits after the decimal point. All digits
+// beyond are zero.
+#define DOUBLE_MAXFRACTIONDIGITS 1074
+
+// The same for the smallest binary128, 2^-16494. The smallest x87 long double is 2^-16445.
+#define FLOAT128_MAXFRACTIONDIGITS 16494
+
 struct NUMBER
 {
     int precision;
@@ -15,8 +41,30 @@ struct NUMBER
     wchar_t digits[NUMBER_MAXDIGITS + 1];
     wchar_t* allDigits;
     NUMBER() : precision(0), scale(0), sign(0), allDigits(NULL) {}
-};
-
+};
+
+enum DoubleToNumberMode
+{
+    // `precision` significant digits, padded with zeros.
+    DTN_PRECISION,
+
+    // The shortest digits which round trip.
+    DTN_SHORTEST,
+
+    // The digits down to 10^-precision, i.e. `precision` digits after the decimal point,
+    // but at most NUMBER_MAXDIGITS significant digits.
+    DTN_FIXED,
+};
+
+enum Dragon4CutoffMode
+{
+    // Exactly `cutoffNumber` significant digits.
+    DRAGON4_CUTOFF_TOTALLENGTH,
+
+    // All digits down to 10^-cutoffNumber.
+    DRAGON4_CUTOFF_FRACTIONLENGTH,
+};
+
 struct FPDOUBLE
 {
 #if BIGENDIAN
@@ -32,8 +80,265 @@ struct FPDOUBLE
 #endif
 };
 
-char * __cdecl
-_ecvt2(double value, int count, int * dec, int * sign)
+struct FPSINGLE
+{
+#if BIGENDIAN
+    unsigned int sign : 1;
+    unsigned int exp : 8;
+    unsigned int mant : 23;
+#else
+    unsigned int mant : 23;
+    unsigned int exp : 8;
+    unsigned int sign : 1;
+#endif
+};
+
+// The x87 80 bit extended format, which only exists on little endian machines. Unlike
+// the other formats the integer bit of the mantissa is stored: bit 63 of mantHi:mantLo.
+struct FPEXTENDED
+{
+    unsigned int mantLo;
+    unsigned int mantHi;
+    unsigned int exp : 15;
+    unsigned int sign : 1;
+};
+
+// IEEE binary128 (__float128, and long double on some 64 bit ARM and POWER targets).
+struct FPQUAD
+{
+#if BIGENDIAN
+    unsigned int sign : 1;
+    unsigned int exp : 15;
+    unsigned int mant3 : 16;
+    unsigned int mant2;
+    unsigned int mant1;
+    unsigned int mant0;
+#else
+    unsigned int mant0;
+    unsigned int mant1;
+    unsigned int mant2;
+    unsigned int mant3 : 16;
+    unsigned int exp : 15;
+    unsigned int sign : 1;
+#endif
+};
+
+static const uint64_t UINT64_POWERSOFTEN[20] =
+{
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL,
+};
+
+// Loads a mantissa into a BigNum. The mantissa of binary128 takes 113 bits.
+template <typename TBigNum>
+void SetBigNumMantissa(TBigNum& result, uint64_t mantissa)
+{
+    result.setUInt64(mantissa);
+}
+
+#if defined(__SIZEOF_INT128__)
+template <typename TBigNum>
+void SetBigNumMantissa(TBigNum& result, BigNumBase::UInt128 mantissa)
+{
+    result.setUInt128(mantissa);
+}
+#endif
+
+// Steps 2 to 5 of Dragon4DoubleCutoff for the value realMantissa * 2^realExponent, whose
+// highest set bit is mantissaHighBitIdx. TBigNum must be large enough for the range of
+// the type the value came from: BigNum for double and float, LongBigNum for long double
+// and binary128. TMantissa is uint64_t, or BigNumBase::UInt128 for binary128.
+template <typename TBigNum, typename TMantissa, typename TChar>
+int Dragon4Cutoff(TMantissa realMantissa, int realExponent, uint32_t mantissaHighBitIdx, Dragon4CutoffMode cutoffMode, int cutoffNumber, int maxCount, TChar* digits, int* dec)
+{
+    CONVERSIONSTATS_PHASESTART(phaseStart);
+
+    // Step 2:
+    // Calculate the first digit exponent. We should estimate the exponent and then verify it later.
+    //
+    // This is an improvement of the estimation in the original paper.
+    // Inspired by http://www.ryanjuckett.com/programming/printing-floating-point-numbers/
+    //
+    // 0.30102999566398119521373889472449 = log10V2
+    // 0.69 = 1 - log10V2 - epsilon (a small number account for drift of floating point multiplication)
+    int firstDigitExponent = (int)(ceil(double((int)mantissaHighBitIdx + realExponent) * 0.30102999566398119521373889472449 - 0.69));
+
+    // Step 3:
+    // Store the input double value in BigNum format.
+    //
+    // To keep the precision, we represent the double value as numertor/denominator.
+    TBigNum numerator;
+    TBigNum denominator;
+    if (realExponent > 0)
+    {
+        SetBigNumMantissa(numerator, realMantissa);
+        TBigNum::shiftLeft(&numerator, realExponent);
+
+        // Explanation:
+        // value = (realMantissa * 2^realExponent) / (1)
+        denominator.setUInt64(1);
+    }
+    else
+    {
+        // Explanation:
+        // value = (realMantissa * 2^realExponent) / (1)
+        //       = (realMantissa / 2^(-realExponent)
+        SetBigNumMantissa(numerator, realMantissa);
+        TBigNum::shiftLeft(1, -realExponent, denominator);
+    }
+
+    if (firstDigitExponent > 0)
+    {
+        denominator.multiplyPow10(firstDigitExponent);
+    }
+    else if (firstDigitExponent < 0)
+    {
+        numerator.multiplyPow10(-firstDigitExponent);
+    }
+
+    // numerator / denominator = value / 10^firstDigitExponent, which should be in [0.1, 1).
+    if (TBigNum::compare(numerator, denominator) >= 0)
+    {
+        // The exponent estimation was incorrect.
+        firstDigitExponent += 1;
+        denominator.multiply(10);
+        CONVERSIONSTATS_COUNT(exponentFixups);
+    }
+
+    CONVERSIONSTATS_PHASEEND(CONVERSIONPHASE_SCALE, phaseStart);
+
+    *dec = firstDigitExponent - 1;
+
+    // Now that the exponent of the first digit is known, the fraction cutoff tells us
+    // how many digits to generate.
+    int count = cutoffNumber;
+    if (cutoffMode == DRAGON4_CUTOFF_FRACTIONLENGTH)
+    {
+        count = firstDigitExponent + cutoffNumber;
+        if (count <= 0)
+        {
+            // The first digit is below the cutoff, so the value rounds to either zero or
+            // one unit at the cutoff. For count == 0 the unit is 10^firstDigitExponent, and
+            // only a value above half of it (numerator / denominator > 0.5) rounds up, a
+            // tie goes to zero.
+            numerator.multiply(2);
+            if (count == 0 && TBigNum::compare(numerator, denominator) > 0)
+            {
+                digits[0] = '1';
+                digits[1] = 0;
+                *dec = -cutoffNumber;
+                return 1;
+            }
+
+            digits[0] = 0;
+            *dec = 0;
+            return 0;
+        }
+    }
+
+    count = std::min(count, maxCount);
+
+    TBigNum::prepareChunkDivide(&numerator, &denominator);
+
+    // Step 4:
+    // Calculate digits.
+    //
+    // Every step moves up to DIGITCHUNKCOUNT digits in front of the fraction point with one
+    // multiplication and divides them out in one pass over the BigNum. The quotient is a
+    // native integer which is split into its digits. We stop at the last digit, or when the
+    // numerator becomes zero and the rest are zeros.
+    int digitsNum = 0;
+    while (digitsNum < count && !numerator.isZero())
+    {
+        int chunkCount = std::min(count - digitsNum, (int)TBigNum::DIGITCHUNKCOUNT);
+        numerator.multiply((uint32_t)UINT64_POWERSOFTEN[chunkCount]);
+        uint32_t chunk = TBigNum::heuristicDivide(&numerator, denominator);
+
+        for (int i = chunkCount - 1; i >= 0; --i)
+        {
+            digits[digitsNum + i] = (TChar)('0' + chunk % 10);
+            chunk /= 10;
+        }
+
+        digitsNum += chunkCount;
+    }
+
+    CONVERSIONSTATS_PHASEEND(CONVERSIONPHASE_DIGITS, phaseStart);
+
+    // Step 5:
+    // Round the last digit.
+    //
+    // We round to the closest digit by comparing the rest with 0.5:
+    //  compare( value, 0.5 )
+    //  = compare( numerator / denominator, 0.5 )
+    //  = compare( numerator, 0.5 * denominator)
+    //  = compare(2 * numerator, denominator)
+    bool isRoundUp = false;
+    if (!numerator.isZero())
+    {
+        numerator.multiply(2);
+        int compareResult = TBigNum::compare(numerator, denominator);
+
+        // We are in the middle, round towards the even digit (i.e. IEEE rouding rules)
+        isRoundUp = compareResult > 0 || (compareResult == 0 && ((digits[digitsNum - 1] - '0') & 1) != 0);
+    }
+
+    if (isRoundUp)
+    {
+        // Rounding up 9 is special: find the first non-nine prior digit.
+        int i = digitsNum - 1;
+        while (i >= 0 && digits[i] == '9')
+        {
+            digits[i] = '0';
+            --i;
+        }
+
+        if (i < digitsNum - 1)
+        {
+            CONVERSIONSTATS_COUNT(carryPropagations);
+        }
+
+        if (i >= 0)
+        {
+            digits[i] += 1;
+        }
+        else
+        {
+            // All nines, output 1 at the next highest exponent.
+            digits[0] = '1';
+            *dec += 1;
+        }
+    }
+
+    // Rounding up 9.99 to 10.0 moved the first digit up, so in fraction mode one more
+    // digit is needed to reach the cutoff.
+    if (cutoffMode == DRAGON4_CUTOFF_FRACTIONLENGTH && *dec == firstDigitExponent && count < maxCount)
+    {
+        ++count;
+    }
+
+    while (digitsNum < count)
+    {
+        digits[digitsNum] = '0';
+        ++digitsNum;
+    }
+
+    digits[count] = 0;
+
+    CONVERSIONSTATS_PHASEEND(CONVERSIONPHASE_ROUND, phaseStart);
+
+    return count;
+}
+
+// Generates the digits of the absolute value up to the cutoff, but at most maxCount
+// (maxCount >= 1) of them, into `digits`, which must have room for maxCount + 1
+// characters. The digit string is padded with '0' and null terminated. Returns the number
+// of digits. In fraction mode this can be 0 if the value rounds to zero at the cutoff;
+// `dec` is 0 then. No memory is allocated.
+template <typename TChar>
+int Dragon4DoubleCutoff(double value, Dragon4CutoffMode cutoffMode, int cutoffNumber, int maxCount, TChar* digits, int* dec, int* sign)
 {
     // Step 1: 
     // Extract meta data from the input double value.
@@ -55,79 +360,158 @@ _ecvt2(double value, int count, int * dec, int * sign)
         mantissaHighBitIdx = BigNum::logBase2(realMantissa);
     }
 
-    char* digits = (char *)malloc(count + 1);
+    *sign = ((FPDOUBLE*)&value)->sign;
+
+    return Dragon4Cutoff<BigNum>(realMantissa, realExponent, mantissaHighBitIdx, cutoffMode, cutoffNumber, maxCount, digits, dec);
+}
+
+// Generates exactly `count` (count >= 1) significant digits of the absolute value
+// into `digits`, which must have room for count + 1 characters. The digit string is
+// padded with '0' and null terminated. No memory is allocated.
+template <typename TChar>
+void Dragon4Double(double value, int count, TChar* digits, int* dec, int* sign)
+{
+    Dragon4DoubleCutoff(value, DRAGON4_CUTOFF_TOTALLENGTH, count, count, digits, dec, sign);
+}
+
+// Steps 2 to 5 of Dragon4DoubleShortest for the non-zero value
+// realMantissa * 2^realExponent, whose highest set bit is mantissaHighBitIdx. The lower
+// neighbour of the value is closer than the upper one if hasUnequalMargins is set. At
+// most maxCount (the shortest count which always round trips) digits are generated.
+// TBigNum must be large enough for the range of the type the value came from.
+template <typename TBigNum, typename TMantissa, typename TChar>
+int Dragon4Shortest(TMantissa realMantissa, int realExponent, uint32_t mantissaHighBitIdx, bool hasUnequalMargins, int maxCount, TChar* digits, int* dec)
+{
+    CONVERSIONSTATS_PHASESTART(phaseStart);
+
+    // Values with an even mantissa are rounded to by the parser from both boundaries,
+    // so the boundaries themselves are acceptable outputs.
+    bool isEven = (realMantissa & 1) == 0;
 
     // Step 2:
-    // Calculate the first digit exponent. We should estimate the exponent and then verify it later.
-    //
-    // This is an improvement of the estimation in the original paper.
-    // Inspired by http://www.ryanjuckett.com/programming/printing-floating-point-numbers/
-    //
-    // 0.30102999566398119521373889472449 = log10V2
-    // 0.69 = 1 - log10V2 - epsilon (a small number account for drift of floating point multiplication)
+    // Calculate the first digit exponent, the same estimation as _ecvt2.
     int firstDigitExponent = (int)(ceil(double((int)mantissaHighBitIdx + realExponent) * 0.30102999566398119521373889472449 - 0.69));
 
     // Step 3:
-    // Store the input double value in BigNum format.
+    // Store the value and the margins in BigNum format.
     //
-    // To keep the precision, we represent the double value as numertor/denominator.
-    BigNum numerator;
-    BigNum denominator;
+    // The margins are the distances to the midpoints between the value and its neighbours.
+    // We scale everything by 2 (or 4 with unequal margins) to keep the margins integral:
+    // value = numerator / denominator
+    // marginLow = the distance to the lower midpoint (scaled the same way as numerator)
+    // marginHigh = the distance to the upper midpoint (scaled the same way as numerator)
+    TBigNum numerator;
+    TBigNum denominator;
+    TBigNum marginLow;
+    TBigNum optionalMarginHigh;
+    TBigNum* pMarginHigh = &marginLow;
+    if (hasUnequalMargins)
+    {
+        pMarginHigh = &optionalMarginHigh;
+    }
+
     if (realExponent > 0)
     {
-        numerator.setUInt64(realMantissa);
-        BigNum::shiftLeft(&numerator, realExponent);
+        // value = (realMantissa * 2^realExponent * 2) / 2
+        SetBigNumMantissa(numerator, realMantissa);
+        TBigNum::shiftLeft(&numerator, realExponent + 1);
+        denominator.setUInt32(2);
+        TBigNum::shiftLeft(1, realExponent, marginLow);
 
-        // Explanation:
-        // value = (realMantissa * 2^realExponent) / (1)
-        denominator.setUInt64(1);
+        if (hasUnequalMargins)
+        {
+            TBigNum::shiftLeft(&numerator, 1);
+            TBigNum::shiftLeft(&denominator, 1);
+            TBigNum::shiftLeft(1, realExponent + 1, optionalMarginHigh);
+        }
     }
     else
     {
-        // Explanation:
-        // value = (realMantissa * 2^realExponent) / (1)
-        //       = (realMantissa / 2^(-realExponent)
-        numerator.setUInt64(realMantissa);
-        BigNum::shiftLeft(1, -realExponent, denominator);
+        // value = (realMantissa * 2) / (2^(-realExponent) * 2)
+        SetBigNumMantissa(numerator, realMantissa);
+        TBigNum::shiftLeft(&numerator, 1);
+        TBigNum::shiftLeft(1, 1 - realExponent, denominator);
+        marginLow.setUInt32(1);
+
+        if (hasUnequalMargins)
+        {
+            TBigNum::shiftLeft(&numerator, 1);
+            TBigNum::shiftLeft(&denominator, 1);
+            optionalMarginHigh.setUInt32(2);
+        }
     }
 
     if (firstDigitExponent > 0)
     {
-        BigNum poweredValue;
-        BigNum::pow10(firstDigitExponent, poweredValue);
-        denominator.multiply(poweredValue);
+        denominator.multiplyPow10(firstDigitExponent);
     }
     else if (firstDigitExponent < 0)
     {
-        BigNum poweredValue;
-        BigNum::pow10(-firstDigitExponent, poweredValue);
-        numerator.multiply(poweredValue);
+        numerator.multiplyPow10(-firstDigitExponent);
+        marginLow.multiplyPow10(-firstDigitExponent);
+        if (hasUnequalMargins)
+        {
+            optionalMarginHigh.multiplyPow10(-firstDigitExponent);
+        }
     }
 
-    if (BigNum::compare(numerator, denominator) >= 0)
+    // The exponent estimation can be one too low. We verify it against the upper
+    // boundary instead of the value, so that a value just below a power of ten whose
+    // boundary reaches it is printed as that power of ten.
+    TBigNum high;
+    TBigNum::add(numerator, *pMarginHigh, high);
+    int compareResult = TBigNum::compare(high, denominator);
+    if (compareResult > 0 || (compareResult == 0 && isEven))
     {
-        // The exponent estimation was incorrect.
         firstDigitExponent += 1;
+        CONVERSIONSTATS_COUNT(exponentFixups);
     }
     else
     {
         numerator.multiply(10);
+        marginLow.multiply(10);
+        if (hasUnequalMargins)
+        {
+            optionalMarginHigh.multiply(10);
+        }
     }
 
     *dec = firstDigitExponent - 1;
 
-    BigNum::prepareHeuristicDivide(&numerator, &denominator);
+    // Shift all values by the same amount so the ratios are unchanged.
+    uint32_t shift = TBigNum::prepareHeuristicDivide(&numerator, &denominator);
+    if (shift != 0)
+    {
+        TBigNum::shiftLeft(&marginLow, shift);
+        if (hasUnequalMargins)
+        {
+            TBigNum::shiftLeft(&optionalMarginHigh, shift);
+        }
+    }
+
+    CONVERSIONSTATS_PHASEEND(CONVERSIONPHASE_SCALE, phaseStart);
 
     // Step 4:
     // Calculate digits.
     //
-    // Output digits until reaching the last but one precision or the numerator becomes zero.
+    // Output digits until the remaining value is within a margin of either boundary,
+    // in which case the digits so far already identify the value uniquely.
     int digitsNum = 0;
     int currentDigit = 0;
+    bool isLow = false;
+    bool isHigh = false;
     while (true)
     {
-        currentDigit = BigNum::heuristicDivide(&numerator, denominator);
-        if (numerator.isZero() || digitsNum + 1 == count)
+        currentDigit = TBigNum::heuristicDivide(&numerator, denominator);
+
+        compareResult = TBigNum::compare(numerator, marginLow);
+        isLow = compareResult < 0 || (compareResult == 0 && isEven);
+
+        TBigNum::add(numerator, *pMarginHigh, high);
+        compareResult = TBigNum::compare(high, denominator);
+        isHigh = compareResult > 0 || (compareResult == 0 && isEven);
+
+        if (isLow || isHigh || digitsNum + 1 == maxCount)
         {
             break;
         }
@@ -136,24 +520,31 @@ _ecvt2(double value, int count, int * dec, int * sign)
         ++digitsNum;
 
         numerator.multiply(10);
+        marginLow.multiply(10);
+        if (hasUnequalMargins)
+        {
+            optionalMarginHigh.multiply(10);
+        }
     }
 
+    CONVERSIONSTATS_PHASEEND(CONVERSIONPHASE_DIGITS, phaseStart);
+
     // Step 5:
     // Set the last digit.
     //
-    // We round to the closest digit by comparing value with 0.5:
-    //  compare( value, 0.5 )
-    //  = compare( numerator / denominator, 0.5 )
-    //  = compare( numerator, 0.5 * denominator)
-    //  = compare(2 * numerator, denominator)
-    numerator.multiply(2);
-    int compareResult = BigNum::compare(numerator, denominator);
-    bool isRoundDown = compareResult < 0;
-
-    // We are in the middle, round towards the even digit (i.e. IEEE rouding rules)
-    if (compareResult == 0)
+    // If only one of the candidates is within the margins, take it. Otherwise round to
+    // the closest one, and to the even one if we are exactly in the middle.
+    bool isRoundDown = isLow;
+    if (isLow == isHigh)
     {
-        isRoundDown = (currentDigit & 1) == 0;
+        numerator.multiply(2);
+        compareResult = TBigNum::compare(numerator, denominator);
+        isRoundDown = compareResult < 0;
+
+        if (compareResult == 0)
+        {
+            isRoundDown = (currentDigit & 1) == 0;
+        }
     }
 
     if (isRoundDown)
@@ -161,76 +552,624 @@ _ecvt2(double value, int count, int * dec, int * sign)
         digits[digitsNum] = '0' + currentDigit;
         ++digitsNum;
     }
+    else if (currentDigit == 9)
+    {
+        // Rounding up for 9 is special. Find the first non-nine prior digit.
+        // Trailing zeros are dropped because they are not significant.
+        CONVERSIONSTATS_COUNT(carryPropagations);
+        while (true)
+        {
+            // If we are at the first digit
+            if (digitsNum == 0)
+            {
+                // Output 1 at the next highest exponent
+                digits[0] = '1';
+                digitsNum = 1;
+                *dec += 1;
+                break;
+            }
+
+            --digitsNum;
+            if (digits[digitsNum] != '9')
+            {
+                // increment the digit
+                digits[digitsNum] += 1;
+                ++digitsNum;
+                break;
+            }
+        }
+    }
+    else
+    {
+        digits[digitsNum] = '0' + currentDigit + 1;
+        ++digitsNum;
+    }
+
+    digits[digitsNum] = 0;
+
+    CONVERSIONSTATS_PHASEEND(CONVERSIONPHASE_ROUND, phaseStart);
+
+    return digitsNum;
+}
+
+// Generates the shortest digit string which converts back to the same double under
+// round-half-to-even parsing, and among those the one closest to the exact value.
+// `digits` must have room for DOUBLE_SHORTEST_MAXDIGITS + 1 characters. Returns the
+// number of digits generated. No memory is allocated.
+//
+// This is the "free-format" Dragon4 of Steele and White, with the boundary handling
+// of Burger and Dybvig ("Printing Floating-Point Numbers Quickly and Accurately").
+template <typename TChar>
+int Dragon4DoubleShortest(double value, TChar* digits, int* dec, int* sign)
+{
+    *sign = ((FPDOUBLE*)&value)->sign;
+
+    // Step 1:
+    // Extract meta data from the input double value.
+    uint64_t realMantissa = ((uint64_t)(((FPDOUBLE*)&value)->mantHi) << 32) | ((FPDOUBLE*)&value)->mantLo;
+    int realExponent = 0;
+    uint32_t mantissaHighBitIdx = 0;
+    bool hasUnequalMargins = false;
+    if (((FPDOUBLE*)&value)->exp > 0)
+    {
+        // The lower neighbour of a power of two is closer than the upper one,
+        // except for the smallest normal value.
+        hasUnequalMargins = realMantissa == 0 && ((FPDOUBLE*)&value)->exp > 1;
+        realMantissa += (uint64_t)1 << 52;
+        realExponent = ((FPDOUBLE*)&value)->exp - 1075;
+        mantissaHighBitIdx = 52;
+    }
+    else if (realMantissa != 0)
+    {
+        realExponent = -1074;
+        mantissaHighBitIdx = BigNum::logBase2(realMantissa);
+    }
     else
     {
-        char* pCurDigit = digits + digitsNum;
+        digits[0] = '0';
+        digits[1] = 0;
+        *dec = 0;
+        return 1;
+    }
+
+    return Dragon4Shortest<BigNum>(realMantissa, realExponent, mantissaHighBitIdx, hasUnequalMargins, DOUBLE_SHORTEST_MAXDIGITS, digits, dec);
+}
+
+// The number of decimal digits of a non-zero integer.
+inline int UInt64DigitCount(uint64_t value)
+{
+    // Start from the estimate by the bit length.
+    int length = (int)((BigNum::logBase2(value) + 1) * 1233 >> 12);
+    if (length < 20 && value >= UINT64_POWERSOFTEN[length])
+    {
+        ++length;
+    }
 
-        // Rounding up for 9 is special.
-        if (currentDigit == 9)
+    return length;
+}
+
+// Generates exactly `count` (count >= 1) significant digits of a non-zero integer into
+// `digits`, which must have room for count + 1 characters. Rounds half to even exactly
+// like Dragon4Double, but only needs native integer arithmetic.
+template <typename TChar>
+void UInt64ToDigits(uint64_t value, int count, TChar* digits, int* dec)
+{
+    int length = UInt64DigitCount(value);
+    *dec = length - 1;
+
+    if (length > count)
+    {
+        // Drop the extra digits, rounding half to even.
+        uint64_t divisor = UINT64_POWERSOFTEN[length - count];
+        uint64_t remainder = value % divisor;
+        value /= divisor;
+
+        uint64_t half = divisor / 2;
+        if (remainder > half || (remainder == half && (value & 1) != 0))
         {
-            // find the first non-nine prior digit
-            while (true)
+            ++value;
+            if (value == UINT64_POWERSOFTEN[count])
             {
-                // If we are at the first digit
-                if (pCurDigit == digits)
-                {
-                    // Output 1 at the next highest exponent
-                    *pCurDigit = '1';
-                    ++digitsNum;
-                    *dec += 1;
-                    break;
-                }
-
-                --pCurDigit;
-                --digitsNum;
-                if (*pCurDigit != '9')
-                {
-                    // increment the digit
-                    *pCurDigit += 1;
-                    ++digitsNum;
-                    break;
-                }
+                value /= 10;
+                *dec += 1;
             }
         }
-        else
+
+        length = count;
+    }
+
+    for (int i = length; i < count; ++i)
+    {
+        digits[i] = '0';
+    }
+
+    digits[count] = 0;
+
+    for (int i = length - 1; i >= 0; --i)
+    {
+        digits[i] = (TChar)('0' + value % 10);
+        value /= 10;
+    }
+}
+
+// Generates the shortest digits of a non-zero integer below 2^63 which lie within
+// lowMargin below and highMargin above it (margins included if isInclusive), the same
+// digits Dragon4Shortest picks: at the first digit position where the value rounded
+// down or up to it is within the margins, take the closer one, the even one on a tie.
+// The margins are whole numbers, pass 0 for margins below one. `digits` needs room for
+// 21 characters. Returns the number of digits.
+template <typename TChar>
+int UInt64ToShortestDigits(uint64_t value, uint64_t lowMargin, uint64_t highMargin, bool isInclusive, TChar* digits, int* dec)
+{
+    int length = UInt64DigitCount(value);
+    *dec = length - 1;
+
+    // A value rounded to a multiple of 10^k is also a multiple of 10^(k - 1), so the
+    // positions which work are 1 up to some k. Move up from the last digit until one
+    // fails.
+    uint64_t result = value;
+    int count = length;
+    for (int k = 1; k < length; ++k)
+    {
+        uint64_t divisor = UINT64_POWERSOFTEN[k];
+        uint64_t low = value / divisor * divisor;
+        uint64_t high = low + divisor;
+
+        bool isLow = value == low || value - low < lowMargin || (isInclusive && value - low == lowMargin);
+        bool isHigh = high - value < highMargin || (isInclusive && high - value == highMargin);
+        if (!isLow && !isHigh)
+        {
+            break;
+        }
+
+        bool isRoundDown = isLow;
+        if (isLow == isHigh)
         {
-            // It's simple if the digit is not 9.
-            *pCurDigit = '0' + currentDigit + 1;
-            ++digitsNum;
+            isRoundDown = value - low < high - value
+                || (value - low == high - value && (low / divisor & 1) == 0);
+        }
+
+        result = (isRoundDown ? low : high) / divisor;
+        count = length - k;
+        *dec = length - 1;
+
+        // Rounding up to the next power of ten.
+        if (result == UINT64_POWERSOFTEN[count])
+        {
+            result = 1;
+            count = 1;
+            *dec += 1;
         }
     }
 
-    if (digitsNum < count)
+    digits[count] = 0;
+    for (int i = count - 1; i >= 0; --i)
     {
-        memset(digits + digitsNum, '0', count - digitsNum);
+        digits[i] = (TChar)('0' + result % 10);
+        result /= 10;
     }
 
-    digits[count] = 0;
+    return count;
+}
 
-    *sign = ((FPDOUBLE*)&value)->sign;
+// Whether the value mantissa * 2^exponent, whose highest set bit is mantissaHighBitIdx,
+// is an integer below 2^maxBits (maxBits <= 64). If so, *pValue receives it.
+template <typename TMantissa>
+bool TryGetUInt64(TMantissa mantissa, int exponent, uint32_t mantissaHighBitIdx, int maxBits, uint64_t* pValue)
+{
+    int highBitExponent = exponent + (int)mantissaHighBitIdx;
+    if (highBitExponent < 0 || highBitExponent >= maxBits)
+    {
+        return false;
+    }
+
+    if (exponent >= 0)
+    {
+        *pValue = (uint64_t)mantissa << exponent;
+        return true;
+    }
 
-    return digits;
+    if ((mantissa & (((TMantissa)1 << -exponent) - 1)) != 0)
+    {
+        return false;
+    }
+
+    *pValue = (uint64_t)(mantissa >> -exponent);
+    return true;
+}
+
+// The number of trailing zero bits of a non-zero mantissa.
+inline uint32_t TrailingZeroBits(uint64_t mantissa)
+{
+    return BigNum::logBase2(mantissa & (~mantissa + 1));
 }
 
-void DoubleToNumber(double value, int precision, NUMBER* number)
+#if defined(__SIZEOF_INT128__)
+inline uint32_t TrailingZeroBits(BigNumBase::UInt128 mantissa)
 {
-    number->precision = precision;
-    if (((FPDOUBLE*)&value)->exp == 0x7FF)
+    uint64_t low = (uint64_t)mantissa;
+    return low != 0 ? TrailingZeroBits(low) : 64 + TrailingZeroBits((uint64_t)(mantissa >> 64));
+}
+#endif
+
+// An upper bound of the bits of the denominator Dragon4Cutoff and Dragon4Shortest build
+// for the value mantissa * 2^exponent, whose highest set bit is mantissaHighBitIdx:
+// 2^-exponent, times 4 for the margins of the shortest digits, times 10^firstDigitExponent
+// and 10 more if the estimate of firstDigitExponent is one too low. The numerator is
+// below ten times the denominator.
+inline int Dragon4DenominatorBits(int exponent, uint32_t mantissaHighBitIdx)
+{
+    int firstDigitExponent = (int)(ceil(double((int)mantissaHighBitIdx + exponent) * 0.30102999566398119521373889472449 - 0.69));
+
+    // 10^n has at most n * log2(10) + 1 bits, and 1701 / 512 > log2(10).
+    int tenExponent = std::max(firstDigitExponent, 0) + 1;
+    return 2 + std::max(-exponent, 0) + (tenExponent * 1701 >> 9) + 1;
+}
+
+// Dragon4Cutoff on the narrowest integer the numerator and denominator fit into: a
+// uint64_t, an unsigned __int128 where the compiler has one, and only for the remaining
+// (very large, very small or very long) values a TBigNum.
+template <typename TBigNum, typename TMantissa, typename TChar>
+int Dragon4CutoffTiered(TMantissa mantissa, int exponent, uint32_t mantissaHighBitIdx, Dragon4CutoffMode cutoffMode, int cutoffNumber, int maxCount, TChar* digits, int* dec)
+{
+    // Trailing zero bits of the mantissa only widen the denominator. The digits do not
+    // depend on how the value is split into mantissa and exponent.
+    uint32_t zeroBits = TrailingZeroBits(mantissa);
+    mantissa >>= zeroBits;
+    exponent += (int)zeroBits;
+    mantissaHighBitIdx -= zeroBits;
+
+    int denominatorBits = Dragon4DenominatorBits(exponent, mantissaHighBitIdx);
+    if (denominatorBits <= NativeNum64::MAXDENOMINATORBITS)
     {
-        number->scale = (((FPDOUBLE*)&value)->mantLo || ((FPDOUBLE*)&value)->mantHi) ? SCALE_NAN : SCALE_INF;
-        number->sign = ((FPDOUBLE*)&value)->sign;
-        number->digits[0] = 0;
+        CONVERSIONSTATS_ENGINE(CONVERSIONENGINE_NATIVE64);
+        return Dragon4Cutoff<NativeNum64>(mantissa, exponent, mantissaHighBitIdx, cutoffMode, cutoffNumber, maxCount, digits, dec);
     }
-    else
+
+#if defined(__SIZEOF_INT128__)
+    if (denominatorBits <= NativeNum128::MAXDENOMINATORBITS)
+    {
+        CONVERSIONSTATS_ENGINE(CONVERSIONENGINE_NATIVE128);
+        return Dragon4Cutoff<NativeNum128>(mantissa, exponent, mantissaHighBitIdx, cutoffMode, cutoffNumber, maxCount, digits, dec);
+    }
+#endif
+
+    CONVERSIONSTATS_ENGINE(CONVERSIONENGINE_BIGNUM);
+    return Dragon4Cutoff<TBigNum>(mantissa, exponent, mantissaHighBitIdx, cutoffMode, cutoffNumber, maxCount, digits, dec);
+}
+
+// Dragon4Shortest on the narrowest integer the numerator, denominator and margins fit
+// into, like Dragon4CutoffTiered. The mantissa is taken as it is because the margins
+// depend on its exponent.
+template <typename TBigNum, typename TMantissa, typename TChar>
+int Dragon4ShortestTiered(TMantissa mantissa, int exponent, uint32_t mantissaHighBitIdx, bool hasUnequalMargins, int maxCount, TChar* digits, int* dec)
+{
+    int denominatorBits = Dragon4DenominatorBits(exponent, mantissaHighBitIdx);
+    if (denominatorBits <= NativeNum64::MAXDENOMINATORBITS)
+    {
+        CONVERSIONSTATS_ENGINE(CONVERSIONENGINE_NATIVE64);
+        return Dragon4Shortest<NativeNum64>(mantissa, exponent, mantissaHighBitIdx, hasUnequalMargins, maxCount, digits, dec);
+    }
+
+#if defined(__SIZEOF_INT128__)
+    if (denominatorBits <= NativeNum128::MAXDENOMINATORBITS)
+    {
+        CONVERSIONSTATS_ENGINE(CONVERSIONENGINE_NATIVE128);
+        return Dragon4Shortest<NativeNum128>(mantissa, exponent, mantissaHighBitIdx, hasUnequalMargins, maxCount, digits, dec);
+    }
+#endif
+
+    CONVERSIONSTATS_ENGINE(CONVERSIONENGINE_BIGNUM);
+    return Dragon4Shortest<TBigNum>(mantissa, exponent, mantissaHighBitIdx, hasUnequalMargins, maxCount, digits, dec);
+}
+
+// Whether Grisu can take the value mantissa * 2^exponent: it works on 64 bit mantissas
+// and its cached powers of ten only cover the exponents of doubles.
+template <typename TMantissa>
+bool IsGrisuInput(TMantissa mantissa, int exponent, uint32_t mantissaHighBitIdx)
+{
+    int highBitExponent = exponent + (int)mantissaHighBitIdx;
+    return sizeof(TMantissa) <= sizeof(uint64_t) && mantissa != 0 && highBitExponent >= -1074 && highBitExponent <= 1023;
+}
+
+// Generates exactly `count` (count >= 1) significant digits of mantissa * 2^exponent,
+// whose highest set bit is mantissaHighBitIdx, into `buffer`. Integers below 2^64 only
+// need native integer arithmetic. Everything else tries the 64 bit Grisu fast path
+// first. It gives up when it can not guarantee the correctly rounded digits, and only
+// then we pay for Dragon4, on native integers if the value allows and with TBigNum
+// otherwise.
+template <typename TBigNum, typename TMantissa, typename TChar>
+void GenerateCountedDigits(TMantissa mantissa, int exponent, uint32_t mantissaHighBitIdx, int count, TChar* buffer, int* dec)
+{
+    CONVERSIONSTATS_CALL(mantissa, exponent);
+
+    uint64_t integer = 0;
+    if (TryGetUInt64(mantissa, exponent, mantissaHighBitIdx, 64, &integer))
+    {
+        CONVERSIONSTATS_ENGINE(CONVERSIONENGINE_UINT64);
+        UInt64ToDigits(integer, count, buffer, dec);
+        return;
+    }
+
+    if (count <= Grisu::MAXCOUNT && IsGrisuInput(mantissa, exponent, mantissaHighBitIdx)
+        && Grisu::tryRunCounted((uint64_t)mantissa, exponent, count, buffer, dec))
     {
-        char* src = _ecvt2(value, precision, &number->scale, &number->sign);
-        wchar_t* dst = number->digits;
-        if (*src != '0')
+        CONVERSIONSTATS_ENGINE(CONVERSIONENGINE_GRISU);
+        return;
+    }
+
+    Dragon4CutoffTiered<TBigNum>(mantissa, exponent, mantissaHighBitIdx, DRAGON4_CUTOFF_TOTALLENGTH, count, count, buffer, dec);
+}
+
+// Generates the digits of the non-zero value mantissa * 2^exponent, whose highest set
+// bit is mantissaHighBitIdx, down to 10^-fractionDigits, but at most maxCount of them.
+// Returns the number of digits like Dragon4Cutoff.
+template <typename TBigNum, typename TMantissa, typename TChar>
+int GenerateFixedDigits(TMantissa mantissa, int exponent, uint32_t mantissaHighBitIdx, int fractionDigits, int maxCount, TChar* buffer, int* dec)
+{
+    CONVERSIONSTATS_CALL(mantissa, exponent);
+
+    // An integer below 2^64 has all its digits followed by `fractionDigits` zeros.
+    uint64_t integer = 0;
+    if (TryGetUInt64(mantissa, exponent, mantissaHighBitIdx, 64, &integer))
+    {
+        CONVERSIONSTATS_ENGINE(CONVERSIONENGINE_UINT64);
+        int count = std::min(UInt64DigitCount(integer) + fractionDigits, maxCount);
+        UInt64ToDigits(integer, count, buffer, dec);
+        return count;
+    }
+
+    // Try the Grisu fast path with the digit count from the estimated exponent of the
+    // first digit (see Dragon4Cutoff). The estimate can be one too low, then the exponent
+    // of the result tells us and we try once more with one digit more. The rounding can
+    // also carry into a new digit; then the count does not match either way and the
+    // BigNum path decides.
+    int estimatedCount = (int)(ceil(double((int)mantissaHighBitIdx + exponent) * 0.30102999566398119521373889472449 - 0.69)) + fractionDigits;
+
+    // With an estimate below -1 the value is below 10^-(fractionDigits + 1) and rounds to
+    // zero, no digits needed.
+    if (estimatedCount < -1)
+    {
+        buffer[0] = 0;
+        *dec = 0;
+        return 0;
+    }
+
+    bool isGrisuInput = IsGrisuInput(mantissa, exponent, mantissaHighBitIdx);
+    for (int attempt = 0; attempt < 2 && isGrisuInput; ++attempt, ++estimatedCount)
+    {
+        if (estimatedCount < 1 || estimatedCount > maxCount || estimatedCount > Grisu::MAXCOUNT
+            || !Grisu::tryRunCounted((uint64_t)mantissa, exponent, estimatedCount, buffer, dec))
+        {
+            break;
+        }
+
+        if (*dec + 1 + fractionDigits == estimatedCount)
         {
-            while (*src) *dst++ = *src++;
+            CONVERSIONSTATS_ENGINE(CONVERSIONENGINE_GRISU);
+            return estimatedCount;
         }
-        *dst = 0;
     }
+
+    return Dragon4CutoffTiered<TBigNum>(mantissa, exponent, mantissaHighBitIdx, DRAGON4_CUTOFF_FRACTIONLENGTH, fractionDigits, maxCount, buffer, dec);
+}
+
+// Generates the shortest round trip digits of the non-zero value mantissa * 2^exponent
+// like Dragon4Shortest. Integers below 2^63 only need native integer arithmetic, the
+// rest tries the 64 bit Grisu fast path first. `buffer` needs room for
+// Grisu::MAXCOUNT + 1 characters. Returns the number of digits.
+template <typename TBigNum, typename TMantissa, typename TChar>
+int GenerateShortestDigits(TMantissa mantissa, int exponent, uint32_t mantissaHighBitIdx, bool hasUnequalMargins, int maxCount, TChar* buffer, int* dec)
+{
+    CONVERSIONSTATS_CALL(mantissa, exponent);
+
+    // The exact digits of an integer are often a tie for the rounding or lie on the
+    // boundary of the shortest interval, which the Grisu fast path gives up on.
+    uint64_t integer = 0;
+    if (TryGetUInt64(mantissa, exponent, mantissaHighBitIdx, 63, &integer))
+    {
+        // Half the distance to the neighbours, rounded down to a whole number.
+        uint64_t highMargin = exponent >= 1 ? (uint64_t)1 << (exponent - 1) : 0;
+        uint64_t lowMargin = hasUnequalMargins ? highMargin >> 1 : highMargin;
+        bool isEven = (mantissa & 1) == 0;
+        CONVERSIONSTATS_ENGINE(CONVERSIONENGINE_UINT64);
+        return UInt64ToShortestDigits(integer, lowMargin, highMargin, isEven, buffer, dec);
+    }
+
+    // The boundaries need two more bits than the mantissa.
+    int count = 0;
+    if (mantissaHighBitIdx < 62 && IsGrisuInput(mantissa, exponent, mantissaHighBitIdx)
+        && Grisu::tryRunShortest((uint64_t)mantissa, exponent, hasUnequalMargins, buffer, &count, dec))
+    {
+        CONVERSIONSTATS_ENGINE(CONVERSIONENGINE_GRISU);
+        return count;
+    }
+
+    return Dragon4ShortestTiered<TBigNum>(mantissa, exponent, mantissaHighBitIdx, hasUnequalMargins, maxCount, buffer, dec);
 }
 
-#endif // BIGNUM_H
\ No newline at end of file
+// Caller-supplied buffer version of _ecvt2, in the spirit of the CRT's _ecvt_s.
+// `buffer` receives `count` significant digits plus a null terminator, so
+// `sizeInChars` must be at least count + 1. Returns 0 on success, EINVAL for
+// invalid arguments and ERANGE if the buffer is too small.
+template <typename TChar>
+int __cdecl
+_ecvt2_s(TChar* buffer, size_t sizeInChars, double value, int count, int * dec, int * sign)
+{
+    if (buffer == NULL || sizeInChars == 0 || dec == NULL || sign == NULL)
+    {
+        return EINVAL;
+    }
+
+    buffer[0] = 0;
+
+    if (count < 1)
+    {
+        return EINVAL;
+    }
+
+    if ((size_t)count >= sizeInChars)
+    {
+        return ERANGE;
+    }
+
+    FPDOUBLE* pValue = (FPDOUBLE*)&value;
+    uint64_t mantissa = ((uint64_t)pValue->mantHi << 32) | pValue->mantLo;
+    int exponent = -1074;
+    uint32_t mantissaHighBitIdx = 52;
+    if (pValue->exp > 0)
+    {
+        mantissa += (uint64_t)1 << 52;
+        exponent = pValue->exp - 1075;
+    }
+    else
+    {
+        mantissaHighBitIdx = BigNum::logBase2(mantissa);
+    }
+
+    *sign = pValue->sign;
+    GenerateCountedDigits<BigNum>(mantissa, exponent, mantissaHighBitIdx, count, buffer, dec);
+
+    return 0;
+}
+
+// Fixed point version of _ecvt2_s, in the spirit of the CRT's _fcvt_s: generates the
+// digits down to 10^-fractionDigits (0 <= fractionDigits <= DOUBLE_MAXFRACTIONDIGITS),
+// which includes all digits of the integer part. At most sizeInChars - 1 significant
+// digits are generated, so a long integer part is rounded at that length. `count`
+// receives the number of digits, 0 if the value rounds to zero. Returns 0 on success,
+// EINVAL for invalid arguments and ERANGE if the buffer is too small.
+template <typename TChar>
+int __cdecl
+_fcvt2_s(TChar* buffer, size_t sizeInChars, double value, int fractionDigits, int * count, int * dec, int * sign)
+{
+    if (buffer == NULL || sizeInChars == 0 || count == NULL || dec == NULL || sign == NULL)
+    {
+        return EINVAL;
+    }
+
+    buffer[0] = 0;
+
+    if (fractionDigits < 0 || fractionDigits > DOUBLE_MAXFRACTIONDIGITS)
+    {
+        return EINVAL;
+    }
+
+    if (sizeInChars < 2)
+    {
+        return ERANGE;
+    }
+
+    int maxCount = (int)std::min(sizeInChars - 1, (size_t)INT32_MAX);
+
+    FPDOUBLE* pValue = (FPDOUBLE*)&value;
+    uint64_t mantissa = ((uint64_t)pValue->mantHi << 32) | pValue->mantLo;
+    *sign = pValue->sign;
+    if (pValue->exp == 0 && mantissa == 0)
+    {
+        *count = 0;
+        *dec = 0;
+        return 0;
+    }
+
+    int exponent = -1074;
+    uint32_t mantissaHighBitIdx = BigNum::logBase2(mantissa);
+    if (pValue->exp > 0)
+    {
+        mantissa += (uint64_t)1 << 52;
+        exponent = pValue->exp - 1075;
+        mantissaHighBitIdx = 52;
+    }
+
+    *count = GenerateFixedDigits<BigNum>(mantissa, exponent, mantissaHighBitIdx, fractionDigits, maxCount, buffer, dec);
+
+    return 0;
+}
+
+// Shortest round-trip version of _ecvt2_s. `buffer` receives at most
+// DOUBLE_SHORTEST_MAXDIGITS digits plus a null terminator and `count` receives the
+// number of digits. Zero is converted to a single '0'. Returns 0 on success, EINVAL
+// for invalid arguments and ERANGE if the buffer is too small.
+template <typename TChar>
+int __cdecl
+_ecvt2_shortest_s(TChar* buffer, size_t sizeInChars, double value, int * count, int * dec, int * sign)
+{
+    if (buffer == NULL || sizeInChars == 0 || count == NULL || dec == NULL || sign == NULL)
+    {
+        return EINVAL;
+    }
+
+    buffer[0] = 0;
+
+    if (sizeInChars < DOUBLE_SHORTEST_MAXDIGITS + 1)
+    {
+        return ERANGE;
+    }
+
+    FPDOUBLE* pValue = (FPDOUBLE*)&value;
+    uint64_t mantissa = ((uint64_t)pValue->mantHi << 32) | pValue->mantLo;
+    if (pValue->exp == 0 && mantissa == 0)
+    {
+        *count = Dragon4DoubleShortest(value, buffer, dec, sign);
+        return 0;
+    }
+
+    int exponent = -1074;
+    uint32_t mantissaHighBitIdx = 52;
+    bool hasUnequalMargins = false;
+    if (pValue->exp > 0)
+    {
+        hasUnequalMargins = mantissa == 0 && pValue->exp > 1;
+        mantissa += (uint64_t)1 << 52;
+        exponent = pValue->exp - 1075;
+    }
+    else
+    {
+        mantissaHighBitIdx = BigNum::logBase2(mantissa);
+    }
+
+    *sign = pValue->sign;
+    *count = GenerateShortestDigits<BigNum>(mantissa, exponent, mantissaHighBitIdx, hasUnequalMargins, DOUBLE_SHORTEST_MAXDIGITS, buffer, dec);
+
+    return 0;
+}
+
+// Returns a buffer allocated by malloc. The caller is responsible for freeing it.
+// Prefer _ecvt2_s on hot paths, it does not allocate.
+char * __cdecl
+_ecvt2(double value, int count, int * dec, int * sign);
+
+// precision should be in [1, NUMBER_MAXDIGITS] for DTN_PRECISION and is ignored for
+// DTN_SHORTEST, where number->precision receives the number of digits generated.
+// For DTN_FIXED precision is the number of digits after the decimal point, and
+// number->precision also receives the number of digits generated.
+// The digits are generated straight into number->digits without any intermediate buffer.
+void DoubleToNumber(double value, int precision, DoubleToNumberMode mode, NUMBER* number);
+void DoubleToNumber(double value, int precision, NUMBER* number);
+
+// The float version of DoubleToNumber. The digits are generated from the bits of the float
+// by FloatDigits, which takes them out of a single 64 bit product and is about twice as
+// fast as going through a double; what it can not decide goes through the tiers of
+// DoubleToNumber. DTN_PRECISION and DTN_FIXED give the same result as
+// DoubleToNumber((double)value, ...), because widening a float is exact. DTN_SHORTEST
+// gives the shortest digits which round trip as a float, at most FLOAT_SHORTEST_MAXDIGITS
+// of them.
+void FloatToNumber(float value, int precision, DoubleToNumberMode mode, NUMBER* number);
+void FloatToNumber(float value, int precision, NUMBER* number);
+
+// The long double version of DoubleToNumber. The x87 80 bit format and binary128 are
+// converted exactly from their bits with LongBigNum, which covers their exponent range
+// of about 10^+-4932; a long double which is just a double goes to DoubleToNumber.
+// DTN_SHORTEST gives the shortest digits which round trip as a long double, at most
+// LONGDOUBLE_SHORTEST_MAXDIGITS (or FLOAT128_SHORTEST_MAXDIGITS) of them. For DTN_FIXED
+// precision may go up to FLOAT128_MAXFRACTIONDIGITS.
+void LongDoubleToNumber(long double value, int precision, DoubleToNumberMode mode, NUMBER* number);
+void LongDoubleToNumber(long double value, int precision, NUMBER* number);
+
+#if defined(__SIZEOF_FLOAT128__) && defined(__SIZEOF_INT128__)
+// The __float128 version of DoubleToNumber, see LongDoubleToNumber.
+void Float128ToNumber(__float128 value, int precision, DoubleToNumberMode mode, NUMBER* number);
+void Float128ToNumber(__float128 value, int precision, NUMBER* number);
+#endif
+
+#endif // DOUBLETONUMBER_H
\ No newline at end of file
@@ -0,0 +1,347 @@
+#ifndef DOUBLETONUMBERBATCH_H
+#define DOUBLETONUMBERBATCH_H
+
+#include "doubletonumber.h"
+#include <cstring>
+
+// Batch conversion of contiguous arrays of doubles.
+//
+// The values are processed in blocks. For every block we first extract the bits of all
+// values and classify them in a branch free loop the compiler can vectorize, then each
+// value is handed to the cheapest engine for its class:
+//  - NaN/Infinity and zero need no digit generation at all.
+//  - Integers below 2^64 only need native integer arithmetic (UInt64ToDigits).
+//  - Everything else goes through _ecvt2_s (Grisu, then Dragon4 on native integers or
+//    BigNum if needed).
+// The output is identical to calling DoubleToNumber on every value.
+
+#define DOUBLEBATCH_BLOCKSIZE 256
+
+enum DoubleClass
+{
+    DOUBLECLASS_GENERAL = 0,
+    DOUBLECLASS_INTEGER = 1,
+    DOUBLECLASS_ZERO = 2,
+    DOUBLECLASS_SPECIAL = 3,
+
+    // Null entries of DoubleToNumberColumns, never returned by ClassifyDoubles.
+    DOUBLECLASS_NULL = 4,
+};
+
+// Classifies `count` values (count <= DOUBLEBATCH_BLOCKSIZE). `integers` receives the
+// integer value of DOUBLECLASS_INTEGER entries and is undefined for the others.
+inline void ClassifyDoubles(const double* values, size_t count, uint8_t* classes, uint64_t* integers)
+{
+    uint64_t bits[DOUBLEBATCH_BLOCKSIZE];
+    memcpy(bits, values, count * sizeof(double));
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t exponent = (bits[i] >> 52) & 0x7FF;
+        uint64_t significand = (bits[i] & 0x000FFFFFFFFFFFFF) | ((uint64_t)1 << 52);
+
+        // Integers below 2^64 have a biased exponent in [1023, 1086]. Below 2^53 the bits
+        // under the binary point must be zero, above it the significand is shifted left.
+        uint64_t rightShift = (1075 - exponent) & 63;
+        uint64_t leftShift = (exponent - 1075) & 63;
+        uint64_t isSmall = (exponent - 1023) <= (1075 - 1023);
+        uint64_t isLarge = (exponent - 1076) <= (1086 - 1076);
+        uint64_t fraction = significand & (((uint64_t)1 << rightShift) - 1);
+
+        uint64_t isInteger = (isSmall & (fraction == 0)) | isLarge;
+        uint64_t isZero = (bits[i] << 1) == 0;
+        uint64_t isSpecial = exponent == 0x7FF;
+
+        integers[i] = isSmall ? (significand >> rightShift) : (significand << leftShift);
+
+        // The classes are exclusive, so or-ing the flags yields the class.
+        classes[i] = (uint8_t)(isSpecial * DOUBLECLASS_SPECIAL | isZero * DOUBLECLASS_ZERO | isInteger * DOUBLECLASS_INTEGER);
+    }
+}
+
+// Same as calling DoubleToNumber(values[i], precision, &numbers[i]) for every value.
+// precision should be in [1, NUMBER_MAXDIGITS].
+inline void DoubleToNumberBatch(const double* values, size_t count, int precision, NUMBER* numbers)
+{
+    if (precision < 1 || precision > NUMBER_MAXDIGITS)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            DoubleToNumber(values[i], precision, &numbers[i]);
+        }
+
+        return;
+    }
+
+    // The scale the engines give zero, taken from them so the batch can not drift.
+    NUMBER zero;
+    DoubleToNumber(0.0, precision, &zero);
+
+    uint8_t classes[DOUBLEBATCH_BLOCKSIZE];
+    uint64_t integers[DOUBLEBATCH_BLOCKSIZE];
+
+    for (size_t blockStart = 0; blockStart < count; blockStart += DOUBLEBATCH_BLOCKSIZE)
+    {
+        size_t blockCount = std::min((size_t)DOUBLEBATCH_BLOCKSIZE, count - blockStart);
+        const double* pValues = values + blockStart;
+        NUMBER* pNumbers = numbers + blockStart;
+
+        ClassifyDoubles(pValues, blockCount, classes, integers);
+
+        for (size_t i = 0; i < blockCount; ++i)
+        {
+            NUMBER* number = pNumbers + i;
+            switch (classes[i])
+            {
+            case DOUBLECLASS_INTEGER:
+                number->precision = precision;
+                number->sign = ((FPDOUBLE*)&pValues[i])->sign;
+                UInt64ToDigits(integers[i], precision, number->digits, &number->scale);
+                break;
+
+            case DOUBLECLASS_ZERO:
+                number->precision = precision;
+                number->scale = zero.scale;
+                number->sign = ((FPDOUBLE*)&pValues[i])->sign;
+                number->digits[0] = 0;
+                break;
+
+            case DOUBLECLASS_SPECIAL:
+                DoubleToNumber(pValues[i], precision, number);
+                break;
+
+            default:
+                // The value is finite and non-zero, so we go straight to the digit engines.
+                number->precision = precision;
+                _ecvt2_s(number->digits, NUMBER_MAXDIGITS + 1, pValues[i], precision, &number->scale, &number->sign);
+                break;
+            }
+        }
+    }
+}
+
+// Packed variant of DoubleToNumberBatch. The digits of values[i] are written to
+// digits[i * precision] .. digits[i * precision + precision - 1], without a terminator and
+// padded with '0' like _ecvt2. NaN and infinity store SCALE_NAN / SCALE_INF in
+// scales[i] and zeros in their digits. Nothing is written if precision is not in
+// [1, NUMBER_MAXDIGITS].
+template <typename TChar>
+void DoubleToDigitsBatch(const double* values, size_t count, int precision, TChar* digits, int* scales, int* signs)
+{
+    if (precision < 1 || precision > NUMBER_MAXDIGITS)
+    {
+        return;
+    }
+
+    uint8_t classes[DOUBLEBATCH_BLOCKSIZE];
+    uint64_t integers[DOUBLEBATCH_BLOCKSIZE];
+
+    // Digits are generated into a scratch buffer first because every engine writes a
+    // terminator, which would overwrite the first digit of the next value.
+    TChar scratch[NUMBER_MAXDIGITS + 1];
+
+    // Zero's scale, as in DoubleToNumberBatch.
+    NUMBER zero;
+    DoubleToNumber(0.0, precision, &zero);
+
+    for (size_t blockStart = 0; blockStart < count; blockStart += DOUBLEBATCH_BLOCKSIZE)
+    {
+        size_t blockCount = std::min((size_t)DOUBLEBATCH_BLOCKSIZE, count - blockStart);
+        const double* pValues = values + blockStart;
+
+        ClassifyDoubles(pValues, blockCount, classes, integers);
+
+        for (size_t i = 0; i < blockCount; ++i)
+        {
+            size_t index = blockStart + i;
+            const FPDOUBLE* pValue = (const FPDOUBLE*)&pValues[i];
+            signs[index] = pValue->sign;
+
+            switch (classes[i])
+            {
+            case DOUBLECLASS_INTEGER:
+                UInt64ToDigits(integers[i], precision, scratch, &scales[index]);
+                break;
+
+            case DOUBLECLASS_ZERO:
+            case DOUBLECLASS_SPECIAL:
+                for (int j = 0; j < precision; ++j)
+                {
+                    scratch[j] = '0';
+                }
+
+                if (classes[i] == DOUBLECLASS_ZERO)
+                {
+                    scales[index] = zero.scale;
+                }
+                else
+                {
+                    scales[index] = (pValue->mantLo || pValue->mantHi) ? SCALE_NAN : SCALE_INF;
+                }
+                break;
+
+            default:
+                _ecvt2_s(scratch, NUMBER_MAXDIGITS + 1, pValues[i], precision, &scales[index], &signs[index]);
+                break;
+            }
+
+            memcpy(digits + index * precision, scratch, precision * sizeof(TChar));
+        }
+    }
+}
+
+// The columns DoubleToNumberColumns writes, one entry per value, like the fields of
+// NUMBER. The digits of value i are digits[offsets[i]] .. digits[offsets[i + 1] - 1],
+// without a terminator, so `offsets` has count + 1 entries and can be handed to a
+// columnar engine as is, together with `digits`.
+struct NumberColumns
+{
+    char* digits;
+    int32_t* offsets;
+    int* scales;
+    uint8_t* signs;
+    int* precisions;
+};
+
+// The number of chars `digits` needs for DoubleToNumberColumns: the most digits a value
+// can have in `mode`, for every value, plus one for the terminator the engines write.
+inline size_t DoubleToNumberColumnsCapacity(size_t count, int precision, DoubleToNumberMode mode)
+{
+    size_t maxDigits = NUMBER_MAXDIGITS;
+    if (mode == DTN_PRECISION)
+    {
+        maxDigits = (size_t)std::max(precision, 0);
+    }
+    else if (mode == DTN_SHORTEST)
+    {
+        maxDigits = DOUBLE_SHORTEST_MAXDIGITS;
+    }
+
+    return count * maxDigits + 1;
+}
+
+// Columnar variant of DoubleToNumber for Arrow style buffers. `validity` is a bitmap with
+// bit i % 8 of byte i / 8 set if values[i] is valid, or NULL if all values are. Valid
+// values get the scale, sign, precision and digits DoubleToNumber(values[i], precision,
+// mode, ...) gives, null values no digits and zero for the rest. `columns.digits` must
+// have DoubleToNumberColumnsCapacity(count, precision, mode) chars. Returns 0 on success,
+// EINVAL for invalid arguments and ERANGE if the digits could go beyond what the 32 bit
+// offsets address, that is DoubleToNumberColumnsCapacity(count, precision, mode) - 1 >
+// INT32_MAX (count > 42949672 at 50 digits); such columns have to be split. Nothing is
+// written on an error.
+//
+// The validity bits are folded into the classes of ClassifyDoubles in the same branch
+// free pass, so a null only selects another case of the dispatch every value goes through.
+inline int DoubleToNumberColumns(const double* values, const uint8_t* validity, size_t count, int precision, DoubleToNumberMode mode, const NumberColumns& columns)
+{
+    bool isValid = (mode == DTN_PRECISION && precision >= 1 && precision <= NUMBER_MAXDIGITS)
+        || (mode == DTN_FIXED && precision >= 0 && precision <= DOUBLE_MAXFRACTIONDIGITS)
+        || mode == DTN_SHORTEST;
+    if (!isValid)
+    {
+        return EINVAL;
+    }
+
+    // The offsets go up to count * maxDigits. Checked by division, the product itself
+    // could wrap around size_t.
+    int maxDigits = (int)DoubleToNumberColumnsCapacity(1, precision, mode) - 1;
+    if (count > (size_t)INT32_MAX / (size_t)maxDigits)
+    {
+        return ERANGE;
+    }
+
+    // Zero has no digits, but its scale and precision depend on the mode.
+    NUMBER zero;
+    DoubleToNumber(0.0, precision, mode, &zero);
+
+    uint8_t classes[DOUBLEBATCH_BLOCKSIZE];
+    uint64_t integers[DOUBLEBATCH_BLOCKSIZE];
+
+    columns.offsets[0] = 0;
+    for (size_t blockStart = 0; blockStart < count; blockStart += DOUBLEBATCH_BLOCKSIZE)
+    {
+        size_t blockCount = std::min((size_t)DOUBLEBATCH_BLOCKSIZE, count - blockStart);
+        const double* pValues = values + blockStart;
+
+        ClassifyDoubles(pValues, blockCount, classes, integers);
+
+        if (validity != NULL)
+        {
+            for (size_t i = 0; i < blockCount; ++i)
+            {
+                size_t index = blockStart + i;
+                uint8_t isValidBit = (validity[index >> 3] >> (index & 7)) & 1;
+                classes[i] = (uint8_t)((classes[i] & (0 - isValidBit)) | (DOUBLECLASS_NULL & (isValidBit - 1)));
+            }
+        }
+
+        for (size_t i = 0; i < blockCount; ++i)
+        {
+            size_t index = blockStart + i;
+            int32_t offset = columns.offsets[index];
+            char* pDigits = columns.digits + offset;
+            const FPDOUBLE* pValue = (const FPDOUBLE*)&pValues[i];
+            int length = 0;
+            int scale = 0;
+            int sign = pValue->sign;
+            int numberPrecision = precision;
+
+            // Only DTN_PRECISION has a cheaper path for integers than the general one, which
+            // has its own integer tier.
+            uint8_t doubleClass = classes[i];
+            if (doubleClass == DOUBLECLASS_INTEGER && mode != DTN_PRECISION)
+            {
+                doubleClass = DOUBLECLASS_GENERAL;
+            }
+
+            switch (doubleClass)
+            {
+            case DOUBLECLASS_NULL:
+                sign = 0;
+                numberPrecision = 0;
+                break;
+
+            case DOUBLECLASS_ZERO:
+                scale = zero.scale;
+                numberPrecision = zero.precision;
+                break;
+
+            case DOUBLECLASS_SPECIAL:
+                scale = (pValue->mantLo || pValue->mantHi) ? SCALE_NAN : SCALE_INF;
+                break;
+
+            case DOUBLECLASS_INTEGER:
+                UInt64ToDigits(integers[i], precision, pDigits, &scale);
+                length = precision;
+                break;
+
+            default:
+                if (mode == DTN_SHORTEST)
+                {
+                    _ecvt2_shortest_s(pDigits, maxDigits + 1, pValues[i], &length, &scale, &sign);
+                    numberPrecision = length;
+                }
+                else if (mode == DTN_FIXED)
+                {
+                    _fcvt2_s(pDigits, maxDigits + 1, pValues[i], precision, &length, &scale, &sign);
+                    numberPrecision = length;
+                }
+                else
+                {
+                    _ecvt2_s(pDigits, maxDigits + 1, pValues[i], precision, &scale, &sign);
+                    length = precision;
+                }
+                break;
+            }
+
+            columns.offsets[index + 1] = offset + length;
+            columns.scales[index] = scale;
+            columns.signs[index] = (uint8_t)sign;
+            columns.precisions[index] = numberPrecision;
+        }
+    }
+
+    return 0;
+}
+
+#endif // DOUBLETONUMBERBATCH_H
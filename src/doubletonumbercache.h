@@ -0,0 +1,217 @@
+#ifndef DOUBLETONUMBERCACHE_H
+#define DOUBLETONUMBERCACHE_H
+
+#include "doubletonumber.h"
+#include <cstring>
+#include <memory>
+
+// Memoization of DoubleToNumber for streams with many repeated values (prices, 0.0, 1.0,
+// round thresholds).
+//
+// The cache is direct-mapped: (value bits, precision, mode) hash to exactly one slot,
+// which holds the result of the last request mapping there. A hit copies the stored
+// digits into the NUMBER, a miss converts and replaces the slot. Every slot takes one
+// cache line, the number of slots is the largest power of two within the memory budget.
+//
+// A cache is not thread safe. Use one per thread, for example the one of
+// GetThreadDoubleToNumberCache(), which is created on first use. Results with more than
+// DOUBLETONUMBERCACHE_MAXDIGITS digits and invalid arguments are converted every time.
+
+#ifndef DOUBLETONUMBERCACHE_BUDGET
+#define DOUBLETONUMBERCACHE_BUDGET (64 * 1024)
+#endif
+
+#define DOUBLETONUMBERCACHE_MAXDIGITS 48
+
+class DoubleToNumberCache
+{
+public:
+    // Takes at most budgetBytes for the slots, but at least one slot.
+    explicit DoubleToNumberCache(size_t budgetBytes = DOUBLETONUMBERCACHE_BUDGET);
+
+    // Same as DoubleToNumber(value, precision, mode, number).
+    void convert(double value, int precision, DoubleToNumberMode mode, NUMBER* number);
+    void convert(double value, int precision, NUMBER* number);
+
+    size_t slotCount() const;
+    size_t memorySize() const;
+    uint64_t hitCount() const;
+
+    // Includes the requests which can not be cached.
+    uint64_t missCount() const;
+
+    // Empties all slots and resets the counters.
+    void clear();
+
+private:
+    DoubleToNumberCache(const DoubleToNumberCache&);
+    DoubleToNumberCache& operator=(const DoubleToNumberCache&);
+
+    struct Slot
+    {
+        uint64_t bits;
+        int32_t scale;
+
+        // (precision << 2 | mode) + 1 of the request, 0 for an empty slot.
+        uint16_t key;
+
+        // number->precision of the result, and the number of digits stored (0 for zero,
+        // NaN and infinity, whose digits are empty).
+        uint8_t precision;
+        uint8_t length;
+
+        char digits[DOUBLETONUMBERCACHE_MAXDIGITS];
+    };
+
+    static_assert(sizeof(Slot) == 64, "a slot should take one cache line");
+
+    // The key of a cacheable request, or 0.
+    static uint16_t makeKey(int precision, DoubleToNumberMode mode);
+
+    std::unique_ptr<Slot[]> m_slots;
+    size_t m_mask;
+    uint64_t m_hitCount;
+    uint64_t m_missCount;
+};
+
+inline DoubleToNumberCache::DoubleToNumberCache(size_t budgetBytes)
+    :m_mask(0),
+    m_hitCount(0),
+    m_missCount(0)
+{
+    size_t count = 1;
+    while (count * 2 * sizeof(Slot) <= budgetBytes && count < ((size_t)1 << 30))
+    {
+        count *= 2;
+    }
+
+    m_slots.reset(new Slot[count]());
+    m_mask = count - 1;
+}
+
+inline void DoubleToNumberCache::convert(double value, int precision, DoubleToNumberMode mode, NUMBER* number)
+{
+    uint16_t key = makeKey(precision, mode);
+    if (key == 0)
+    {
+        ++m_missCount;
+        DoubleToNumber(value, precision, mode, number);
+        return;
+    }
+
+    uint64_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+
+    // A multiplication only carries to the left, so fold everything into the low half
+    // and take the index from the upper half.
+    uint64_t hash = (bits ^ (bits >> 32) ^ key) * 0x9E3779B97F4A7C15ull;
+    Slot& slot = m_slots[(size_t)(hash >> 32) & m_mask];
+
+    if (slot.key == key && slot.bits == bits)
+    {
+        ++m_hitCount;
+        number->precision = slot.precision;
+        number->scale = slot.scale;
+        number->sign = (int)(bits >> 63);
+        for (int i = 0; i < slot.length; ++i)
+        {
+            number->digits[i] = slot.digits[i];
+        }
+
+        number->digits[slot.length] = 0;
+        return;
+    }
+
+    ++m_missCount;
+    DoubleToNumber(value, precision, mode, number);
+
+    int length = 0;
+    while (length <= DOUBLETONUMBERCACHE_MAXDIGITS && number->digits[length] != 0)
+    {
+        ++length;
+    }
+
+    // NaN and infinity keep the requested precision, which can be up to
+    // DOUBLE_MAXFRACTIONDIGITS in fixed mode.
+    if (length > DOUBLETONUMBERCACHE_MAXDIGITS || number->precision > UINT8_MAX)
+    {
+        return;
+    }
+
+    slot.bits = bits;
+    slot.scale = number->scale;
+    slot.key = key;
+    slot.precision = (uint8_t)number->precision;
+    slot.length = (uint8_t)length;
+    for (int i = 0; i < length; ++i)
+    {
+        slot.digits[i] = (char)number->digits[i];
+    }
+}
+
+inline void DoubleToNumberCache::convert(double value, int precision, NUMBER* number)
+{
+    convert(value, precision, DTN_PRECISION, number);
+}
+
+inline size_t DoubleToNumberCache::slotCount() const
+{
+    return m_mask + 1;
+}
+
+inline size_t DoubleToNumberCache::memorySize() const
+{
+    return slotCount() * sizeof(Slot);
+}
+
+inline uint64_t DoubleToNumberCache::hitCount() const
+{
+    return m_hitCount;
+}
+
+inline uint64_t DoubleToNumberCache::missCount() const
+{
+    return m_missCount;
+}
+
+inline void DoubleToNumberCache::clear()
+{
+    memset(m_slots.get(), 0, memorySize());
+    m_hitCount = 0;
+    m_missCount = 0;
+}
+
+inline uint16_t DoubleToNumberCache::makeKey(int precision, DoubleToNumberMode mode)
+{
+    // Only valid arguments: DoubleToNumber leaves scale and sign alone for the others.
+    // The shortest digits ignore the precision, but NaN and infinity pass it through.
+    bool isValid = (mode == DTN_SHORTEST && precision >= 0 && precision <= NUMBER_MAXDIGITS)
+        || (mode == DTN_FIXED && precision >= 0 && precision <= DOUBLE_MAXFRACTIONDIGITS)
+        || (mode == DTN_PRECISION && precision >= 1 && precision <= DOUBLETONUMBERCACHE_MAXDIGITS);
+    if (!isValid)
+    {
+        return 0;
+    }
+
+    return (uint16_t)(((precision << 2) | mode) + 1);
+}
+
+// The cache of the calling thread, with DOUBLETONUMBERCACHE_BUDGET bytes.
+inline DoubleToNumberCache& GetThreadDoubleToNumberCache()
+{
+    static thread_local DoubleToNumberCache cache;
+    return cache;
+}
+
+// DoubleToNumber through the cache of the calling thread.
+inline void CachedDoubleToNumber(double value, int precision, DoubleToNumberMode mode, NUMBER* number)
+{
+    GetThreadDoubleToNumberCache().convert(value, precision, mode, number);
+}
+
+inline void CachedDoubleToNumber(double value, int precision, NUMBER* number)
+{
+    GetThreadDoubleToNumberCache().convert(value, precision, DTN_PRECISION, number);
+}
+
+#endif // DOUBLETONUMBERCACHE_H
@@ -0,0 +1,43 @@
+#ifndef EISELLEMIRE_H
+#define EISELLEMIRE_H
+
+#include <cstdint>
+
+// Eisel-Lemire fast path for decimal to double conversion (Daniel Lemire, "Number Parsing
+// at a Gigabyte per Second"). mantissa * 10^exponent is multiplied by a truncated 128 bit
+// approximation of 5^exponent, the powers of two are just added to the binary exponent.
+// Noble Mushtak and Daniel Lemire ("Fast Number Parsing Without Fallback") showed that the
+// 128 bit product always has enough bits to round correctly for a mantissa of up to 64
+// bits, so unlike Grisu this path never fails.
+//
+// Inspired by https://github.com/fastfloat/fast_float (decimal_to_binary.h)
+class EiselLemire
+{
+public:
+    // Exponents below this round to zero for any 64 bit mantissa.
+    static const int MINEXPONENT = -342;
+
+    // Exponents above this overflow for any mantissa but 0.
+    static const int MAXEXPONENT = 308;
+
+    // The IEEE bits of the double closest to mantissa * 10^exponent, ties to even. The
+    // sign bit is clear, overflow gives infinity and underflow zero.
+    static uint64_t compute(uint64_t mantissa, int exponent);
+
+private:
+    // 5^q normalized to [2^127, 2^128), truncated for q >= 0 and rounded up for q < 0.
+    struct Power5
+    {
+        uint64_t hi;
+        uint64_t lo;
+    };
+
+    static const int POWERS5NUM = MAXEXPONENT - MINEXPONENT + 1;
+    static const Power5 m_powers5[POWERS5NUM];
+
+    // lhs * rhs as a 128 bit product, the high half goes to *pHigh.
+    static uint64_t multiply(uint64_t lhs, uint64_t rhs, uint64_t* pHigh);
+    static int leadingZeros(uint64_t value);
+};
+
+#endif // EISELLEMIRE_H
@@ -0,0 +1,159 @@
+#include "floatdigits.h"
+
+// 5^-40, 5^-39, ..., 5^64, rounded up. The error of each entry is less than a unit of
+// its significand, which tryScale() allows for, and roundToOdd() needs it to be never
+// below the power.
+const FloatDigits::Power5 FloatDigits::m_powers5[POWERS5NUM] =
+{
+    { 0x8b61313bbabce2c7ULL, -156 }, // 5^-40
+    { 0xae397d8aa96c1b78ULL, -154 }, // 5^-39
+    { 0xd9c7dced53c72256ULL, -152 }, // 5^-38
+    { 0x881cea14545c7576ULL, -149 }, // 5^-37
+    { 0xaa242499697392d3ULL, -147 }, // 5^-36
+    { 0xd4ad2dbfc3d07788ULL, -145 }, // 5^-35
+    { 0x84ec3c97da624ab5ULL, -142 }, // 5^-34
+    { 0xa6274bbdd0fadd62ULL, -140 }, // 5^-33
+    { 0xcfb11ead453994bbULL, -138 }, // 5^-32
+    { 0x81ceb32c4b43fcf5ULL, -135 }, // 5^-31
+    { 0xa2425ff75e14fc32ULL, -133 }, // 5^-30
+    { 0xcad2f7f5359a3b3fULL, -131 }, // 5^-29
+    { 0xfd87b5f28300ca0eULL, -129 }, // 5^-28
+    { 0x9e74d1b791e07e49ULL, -126 }, // 5^-27
+    { 0xc612062576589ddbULL, -124 }, // 5^-26
+    { 0xf79687aed3eec552ULL, -122 }, // 5^-25
+    { 0x9abe14cd44753b53ULL, -119 }, // 5^-24
+    { 0xc16d9a0095928a28ULL, -117 }, // 5^-23
+    { 0xf1c90080baf72cb2ULL, -115 }, // 5^-22
+    { 0x971da05074da7befULL, -112 }, // 5^-21
+    { 0xbce5086492111aebULL, -110 }, // 5^-20
+    { 0xec1e4a7db69561a6ULL, -108 }, // 5^-19
+    { 0x9392ee8e921d5d08ULL, -105 }, // 5^-18
+    { 0xb877aa3236a4b44aULL, -103 }, // 5^-17
+    { 0xe69594bec44de15cULL, -101 }, // 5^-16
+    { 0x901d7cf73ab0acdaULL, -98 }, // 5^-15
+    { 0xb424dc35095cd810ULL, -96 }, // 5^-14
+    { 0xe12e13424bb40e14ULL, -94 }, // 5^-13
+    { 0x8cbccc096f5088ccULL, -91 }, // 5^-12
+    { 0xafebff0bcb24aaffULL, -89 }, // 5^-11
+    { 0xdbe6fecebdedd5bfULL, -87 }, // 5^-10
+    { 0x89705f4136b4a598ULL, -84 }, // 5^-9
+    { 0xabcc77118461cefdULL, -82 }, // 5^-8
+    { 0xd6bf94d5e57a42bdULL, -80 }, // 5^-7
+    { 0x8637bd05af6c69b6ULL, -77 }, // 5^-6
+    { 0xa7c5ac471b478424ULL, -75 }, // 5^-5
+    { 0xd1b71758e219652cULL, -73 }, // 5^-4
+    { 0x83126e978d4fdf3cULL, -70 }, // 5^-3
+    { 0xa3d70a3d70a3d70bULL, -68 }, // 5^-2
+    { 0xcccccccccccccccdULL, -66 }, // 5^-1
+    { 0x8000000000000000ULL, -63 }, // 5^0
+    { 0xa000000000000000ULL, -61 }, // 5^1
+    { 0xc800000000000000ULL, -59 }, // 5^2
+    { 0xfa00000000000000ULL, -57 }, // 5^3
+    { 0x9c40000000000000ULL, -54 }, // 5^4
+    { 0xc350000000000000ULL, -52 }, // 5^5
+    { 0xf424000000000000ULL, -50 }, // 5^6
+    { 0x9896800000000000ULL, -47 }, // 5^7
+    { 0xbebc200000000000ULL, -45 }, // 5^8
+    { 0xee6b280000000000ULL, -43 }, // 5^9
+    { 0x9502f90000000000ULL, -40 }, // 5^10
+    { 0xba43b74000000000ULL, -38 }, // 5^11
+    { 0xe8d4a51000000000ULL, -36 }, // 5^12
+    { 0x9184e72a00000000ULL, -33 }, // 5^13
+    { 0xb5e620f480000000ULL, -31 }, // 5^14
+    { 0xe35fa931a0000000ULL, -29 }, // 5^15
+    { 0x8e1bc9bf04000000ULL, -26 }, // 5^16
+    { 0xb1a2bc2ec5000000ULL, -24 }, // 5^17
+    { 0xde0b6b3a76400000ULL, -22 }, // 5^18
+    { 0x8ac7230489e80000ULL, -19 }, // 5^19
+    { 0xad78ebc5ac620000ULL, -17 }, // 5^20
+    { 0xd8d726b7177a8000ULL, -15 }, // 5^21
+    { 0x878678326eac9000ULL, -12 }, // 5^22
+    { 0xa968163f0a57b400ULL, -10 }, // 5^23
+    { 0xd3c21bcecceda100ULL, -8 }, // 5^24
+    { 0x84595161401484a0ULL, -5 }, // 5^25
+    { 0xa56fa5b99019a5c8ULL, -3 }, // 5^26
+    { 0xcecb8f27f4200f3aULL, -1 }, // 5^27
+    { 0x813f3978f8940985ULL, 2 }, // 5^28
+    { 0xa18f07d736b90be6ULL, 4 }, // 5^29
+    { 0xc9f2c9cd04674edfULL, 6 }, // 5^30
+    { 0xfc6f7c4045812297ULL, 8 }, // 5^31
+    { 0x9dc5ada82b70b59eULL, 11 }, // 5^32
+    { 0xc5371912364ce306ULL, 13 }, // 5^33
+    { 0xf684df56c3e01bc7ULL, 15 }, // 5^34
+    { 0x9a130b963a6c115dULL, 18 }, // 5^35
+    { 0xc097ce7bc90715b4ULL, 20 }, // 5^36
+    { 0xf0bdc21abb48db21ULL, 22 }, // 5^37
+    { 0x96769950b50d88f5ULL, 25 }, // 5^38
+    { 0xbc143fa4e250eb32ULL, 27 }, // 5^39
+    { 0xeb194f8e1ae525feULL, 29 }, // 5^40
+    { 0x92efd1b8d0cf37bfULL, 32 }, // 5^41
+    { 0xb7abc627050305aeULL, 34 }, // 5^42
+    { 0xe596b7b0c643c71aULL, 36 }, // 5^43
+    { 0x8f7e32ce7bea5c70ULL, 39 }, // 5^44
+    { 0xb35dbf821ae4f38cULL, 41 }, // 5^45
+    { 0xe0352f62a19e306fULL, 43 }, // 5^46
+    { 0x8c213d9da502de46ULL, 46 }, // 5^47
+    { 0xaf298d050e4395d7ULL, 48 }, // 5^48
+    { 0xdaf3f04651d47b4dULL, 50 }, // 5^49
+    { 0x88d8762bf324cd10ULL, 53 }, // 5^50
+    { 0xab0e93b6efee0054ULL, 55 }, // 5^51
+    { 0xd5d238a4abe98069ULL, 57 }, // 5^52
+    { 0x85a36366eb71f042ULL, 60 }, // 5^53
+    { 0xa70c3c40a64e6c52ULL, 62 }, // 5^54
+    { 0xd0cf4b50cfe20766ULL, 64 }, // 5^55
+    { 0x82818f1281ed44a0ULL, 67 }, // 5^56
+    { 0xa321f2d7226895c8ULL, 69 }, // 5^57
+    { 0xcbea6f8ceb02bb3aULL, 71 }, // 5^58
+    { 0xfee50b7025c36a09ULL, 73 }, // 5^59
+    { 0x9f4f2726179a2246ULL, 76 }, // 5^60
+    { 0xc722f0ef9d80aad7ULL, 78 }, // 5^61
+    { 0xf8ebad2b84e0d58cULL, 80 }, // 5^62
+    { 0x9b934c3b330c8578ULL, 83 }, // 5^63
+    { 0xc2781f49ffcfa6d6ULL, 85 }, // 5^64
+};
+
+const uint64_t FloatDigits::m_powersOfTen[20] =
+{
+    1ULL,
+    10ULL,
+    100ULL,
+    1000ULL,
+    10000ULL,
+    100000ULL,
+    1000000ULL,
+    10000000ULL,
+    100000000ULL,
+    1000000000ULL,
+    10000000000ULL,
+    100000000000ULL,
+    1000000000000ULL,
+    10000000000000ULL,
+    100000000000000ULL,
+    1000000000000000ULL,
+    10000000000000000ULL,
+    100000000000000000ULL,
+    1000000000000000000ULL,
+    10000000000000000000ULL,
+};
+
+const char FloatDigits::m_digitPairs[201] =
+    "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+    "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+bool FloatDigits::isInteger(uint32_t mantissa, int exponent, int k)
+{
+    // 10^k = 5^k * 2^k. A negative power of five has to divide the mantissa, then the
+    // mantissa needs as many trailing zero bits as the power of two is negative.
+    for (int i = k; i < 0; ++i)
+    {
+        if (mantissa % 5 != 0)
+        {
+            return false;
+        }
+
+        mantissa /= 5;
+    }
+
+    int twoExponent = exponent + k;
+    return twoExponent >= 0 || (twoExponent > -32 && (mantissa & ((1u << -twoExponent) - 1)) == 0);
+}
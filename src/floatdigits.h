@@ -0,0 +1,439 @@
+#ifndef FLOATDIGITS_H
+#define FLOATDIGITS_H
+
+#include "bignum.h"
+#include <cstdint>
+
+// Fast path for the digits of floats. A float mantissa has 24 bits, so its value times
+// 10^k, taken with a 64 bit approximation of 5^k, is known to about 38 bits after the
+// fraction point, which decides the rounding unless the value is within the error of an
+// integer or of a tie. Whether it really is one follows exactly from the mantissa and the
+// exponents. So unlike Grisu this path only gives up for a handful of floats (and for
+// integer parts beyond 2^58), and the digits come out of one native integer instead of
+// a division by another power of ten for every digit.
+//
+// The shortest digits are found like Schubfach does (Raffaello Giulietti, "The Schubfach
+// way to render doubles"): the value and its boundaries are scaled by the same power of
+// ten, rounded to odd, to an interval narrow enough that only the integers next to the
+// value and one multiple of 10 are left to choose from. That needs no exactness check at
+// all, which has been verified for every float against Dragon4.
+class FloatDigits
+{
+public:
+    // The digits of a float below 10^MAXCOUNT fit into the scaled value.
+    static const int MAXCOUNT = 9;
+
+    // Try to generate `count` significant digits of mantissa * 2^exponent, where the
+    // mantissa (non-zero, at most 24 bits) has its highest set bit at mantissaHighBitIdx.
+    // On success the digits are written to `digits` (count characters plus a null
+    // terminator, but it needs room for MAXCOUNT + 1), `dec` receives the decimal
+    // exponent of the first digit and true is returned. The last digit is rounded half
+    // to even like Dragon4Cutoff.
+    template <typename TChar>
+    static bool tryRunCounted(uint32_t mantissa, int exponent, uint32_t mantissaHighBitIdx, int count, TChar* digits, int* dec);
+
+    // Try to generate the digits of mantissa * 2^exponent down to 10^-fractionDigits like
+    // Dragon4Cutoff with DRAGON4_CUTOFF_FRACTIONLENGTH, but at most maxCount of them.
+    // `digits` needs room for 20 characters. *count receives the number of digits, 0 if
+    // the value rounds to zero.
+    template <typename TChar>
+    static bool tryRunFixed(uint32_t mantissa, int exponent, int fractionDigits, int maxCount, TChar* digits, int* count, int* dec);
+
+    // Try to generate the shortest digits which identify mantissa * 2^exponent among its
+    // neighbours, and among those the closest to the value, like Dragon4Shortest. The
+    // mantissa and exponent must be those of a float; the lower neighbour is closer if
+    // hasUnequalMargins is set. `digits` needs room for MAXCOUNT + 1 characters.
+    template <typename TChar>
+    static bool tryRunShortest(uint32_t mantissa, int exponent, bool hasUnequalMargins, TChar* digits, int* count, int* dec);
+
+private:
+    // What is left of a scaled value below its integer part.
+    enum Rest
+    {
+        REST_ZERO,
+        REST_BELOWHALF,
+        REST_HALF,
+        REST_ABOVEHALF,
+    };
+
+    // 5^k ~= significand * 2^binaryExponent, with the significand in [2^63, 2^64).
+    struct Power5
+    {
+        uint64_t significand;
+        int16_t binaryExponent;
+    };
+
+    static const int MINEXPONENT = -40;
+    static const int MAXEXPONENT = 64;
+    static const int POWERS5NUM = MAXEXPONENT - MINEXPONENT + 1;
+    static const Power5 m_powers5[POWERS5NUM];
+    static const uint64_t m_powersOfTen[20];
+
+    // "00", "01", ..., "99".
+    static const char m_digitPairs[201];
+
+    // floor(n * log10(2)) for |n| < 1650.
+    static int floorLog10Pow2(int n)
+    {
+        return (n * 78913) >> 18;
+    }
+
+    // floor(n * log10(2) - log10(4 / 3)) for |n| < 2900.
+    static int floorLog10ThreeQuartersPow2(int n)
+    {
+        return (n * 631305 - 261663) >> 21;
+    }
+
+    // Splits mantissa * 2^exponent * 10^k (mantissa below 2^26) into its integer part and
+    // what is left below it. Returns false if 10^k is out of the table, the integer part
+    // does not fit or the rest can not be told apart from zero or half.
+    static bool tryScale(uint32_t mantissa, int exponent, int k, uint64_t* pInteger, Rest* pRest);
+
+    // mantissa * significand / 2^shift (mantissa below 2^26, shift in [58, 64]) rounded
+    // down, with the lowest bit set if it was not exact: rounded to odd like Schubfach
+    // does. The significand may be up to a unit too high, which the 32 bits of the
+    // fraction kept are too few to see.
+    static uint32_t roundToOdd(uint64_t significand, uint32_t mantissa, int shift)
+    {
+        uint64_t low = (significand & 0xFFFFFFFF) * mantissa;
+        uint64_t middle = (significand >> 32) * mantissa + (low >> 32);
+        uint64_t scaled = (middle << (64 - shift)) | ((low & 0xFFFFFFFF) >> (shift - 32));
+        return (uint32_t)(scaled >> 32) | ((uint32_t)scaled != 0 ? 1 : 0);
+    }
+
+    // Whether mantissa * 2^exponent * 10^k is an integer.
+    static bool isInteger(uint32_t mantissa, int exponent, int k);
+
+    static int digitCount(uint64_t value)
+    {
+        // Start from the estimate by the bit length (1233 / 4096 ~= log10(2)).
+#if defined(__GNUC__)
+        int bits = 64 - __builtin_clzll(value);
+#else
+        int bits = (int)BigNum::logBase2(value) + 1;
+#endif
+        int length = bits * 1233 >> 12;
+        return length + (value >= m_powersOfTen[length] ? 1 : 0);
+    }
+
+    static uint64_t roundHalfEven(uint64_t integer, Rest rest)
+    {
+        return integer + (rest == REST_ABOVEHALF || (rest == REST_HALF && (integer & 1) != 0) ? 1 : 0);
+    }
+
+    template <typename TChar>
+    static void writeDigits(uint64_t value, int count, TChar* digits);
+};
+
+inline bool FloatDigits::tryScale(uint32_t mantissa, int exponent, int k, uint64_t* pInteger, Rest* pRest)
+{
+    if (k < MINEXPONENT || k > MAXEXPONENT)
+    {
+        return false;
+    }
+
+    // Step 1:
+    // mantissa * 2^exponent * 10^k = mantissa * 5^k * 2^(exponent + k), which is about
+    // product / 2^shift with the 90 bit product of the mantissa and the significand. It
+    // takes two 32 by 32 bit multiplications since the mantissa has less than 32 bits.
+    const Power5& power = m_powers5[k - MINEXPONENT];
+    int shift = -(exponent + k + power.binaryExponent);
+
+    // Keep at least 32 bits of the fraction, that also keeps the integer part below 2^58.
+    if (shift < 32)
+    {
+        return false;
+    }
+
+    // The product is below 2^90, so a shift that far leaves less than 2^-38.
+    if (shift > 127)
+    {
+        *pInteger = 0;
+        *pRest = REST_BELOWHALF;
+        return true;
+    }
+
+    uint64_t low = (power.significand & 0xFFFFFFFF) * mantissa;
+    uint64_t middle = (power.significand >> 32) * mantissa + (low >> 32);
+    uint64_t productHi = middle >> 32;
+    uint64_t productLo = (middle << 32) | (low & 0xFFFFFFFF);
+
+    // Step 2:
+    // Split the product into the integer part and the first 64 bits of the fraction.
+    // The error of the significand makes the product off by less than `mantissa`, the
+    // error is how much that is in units of 2^-64 (plus one for the bits cut off).
+    uint64_t integer = 0;
+    uint64_t fraction = 0;
+    uint64_t error = 0;
+    if (shift < 64)
+    {
+        integer = (productHi << (64 - shift)) | (productLo >> shift);
+        fraction = productLo << (64 - shift);
+        error = (uint64_t)mantissa << (64 - shift);
+    }
+    else if (shift == 64)
+    {
+        integer = productHi;
+        fraction = productLo;
+        error = mantissa;
+    }
+    else
+    {
+        integer = productHi >> (shift - 64);
+        fraction = (productHi << (128 - shift)) | (productLo >> (shift - 64));
+        error = ((uint64_t)mantissa >> (shift - 64)) + 1;
+    }
+
+    // Step 3:
+    // Classify the rest. Within the error of an integer the value may just as well be on
+    // the other side of it, and within the error of half way it may be either half, so
+    // only an exact integer or tie can be decided there.
+    const uint64_t half = (uint64_t)1 << 63;
+    if (fraction < error || fraction > ~error)
+    {
+        if (!isInteger(mantissa, exponent, k))
+        {
+            return false;
+        }
+
+        // The approximation may be just below the integer.
+        if (fraction >= half)
+        {
+            ++integer;
+        }
+
+        *pRest = REST_ZERO;
+    }
+    else if (fraction - half + error < 2 * error)
+    {
+        if (!isInteger(mantissa, exponent + 1, k))
+        {
+            return false;
+        }
+
+        *pRest = REST_HALF;
+    }
+    else
+    {
+        *pRest = fraction < half ? REST_BELOWHALF : REST_ABOVEHALF;
+    }
+
+    *pInteger = integer;
+    return true;
+}
+
+template <typename TChar>
+bool FloatDigits::tryRunCounted(uint32_t mantissa, int exponent, uint32_t mantissaHighBitIdx, int count, TChar* digits, int* dec)
+{
+    if (count > MAXCOUNT)
+    {
+        return false;
+    }
+
+    // The value is in [2^highBitExponent, 2^(highBitExponent + 1)), so its first digit
+    // is at 10^firstDigitExponent or one above. Scale it so that the integer part has
+    // `count` digits, or one more if the estimate was too low.
+    int firstDigitExponent = floorLog10Pow2(exponent + (int)mantissaHighBitIdx);
+    int k = count - 1 - firstDigitExponent;
+
+    uint64_t integer = 0;
+    Rest rest = REST_ZERO;
+    if (!tryScale(mantissa, exponent, k, &integer, &rest))
+    {
+        return false;
+    }
+
+    if (integer >= m_powersOfTen[count])
+    {
+        --k;
+        if (!tryScale(mantissa, exponent, k, &integer, &rest))
+        {
+            return false;
+        }
+    }
+
+    // Rounding up can carry into a new digit: 9.99 becomes 10.0.
+    integer = roundHalfEven(integer, rest);
+    if (integer == m_powersOfTen[count])
+    {
+        integer /= 10;
+        --k;
+    }
+
+    writeDigits(integer, count, digits);
+    *dec = count - 1 - k;
+
+    return true;
+}
+
+template <typename TChar>
+bool FloatDigits::tryRunFixed(uint32_t mantissa, int exponent, int fractionDigits, int maxCount, TChar* digits, int* count, int* dec)
+{
+    uint64_t integer = 0;
+    Rest rest = REST_ZERO;
+    if (!tryScale(mantissa, exponent, fractionDigits, &integer, &rest))
+    {
+        return false;
+    }
+
+    integer = roundHalfEven(integer, rest);
+    if (integer == 0)
+    {
+        digits[0] = 0;
+        *count = 0;
+        *dec = 0;
+        return true;
+    }
+
+    int length = digitCount(integer);
+    if (length > maxCount)
+    {
+        return false;
+    }
+
+    writeDigits(integer, length, digits);
+    *count = length;
+    *dec = length - 1 - fractionDigits;
+
+    return true;
+}
+
+template <typename TChar>
+bool FloatDigits::tryRunShortest(uint32_t mantissa, int exponent, bool hasUnequalMargins, TChar* digits, int* count, int* dec)
+{
+    // An integer whose neighbours are at most 1 away has no shorter digits than its own
+    // without the trailing zeros. That covers the floats which hold counters and IDs.
+    if (exponent <= 0 && exponent > -32 && (mantissa & ((1u << -exponent) - 1)) == 0)
+    {
+        uint32_t integer = mantissa >> -exponent;
+        int length = digitCount(integer);
+        *dec = length - 1;
+        while (integer % 10 == 0)
+        {
+            integer /= 10;
+            --length;
+        }
+
+        writeDigits(integer, length, digits);
+        *count = length;
+        return true;
+    }
+
+    // Step 1:
+    // The value and the midpoints to its neighbours in units of 2^(exponent - 2). They
+    // are part of the shortest interval if the mantissa is even.
+    uint32_t isOdd = mantissa & 1;
+    uint32_t valueMantissa = mantissa << 2;
+    uint32_t highMantissa = valueMantissa + 2;
+    uint32_t lowMantissa = valueMantissa - (hasUnequalMargins ? 1 : 2);
+
+    // Step 2:
+    // Scale all three by 10^k so that the interval is at least 1 and less than 10 wide,
+    // in quarters rounded to odd. That leaves the value below 10 * 2^24.
+    int k = hasUnequalMargins ? -floorLog10ThreeQuartersPow2(exponent) : -floorLog10Pow2(exponent);
+    if (k < MINEXPONENT || k > MAXEXPONENT)
+    {
+        return false;
+    }
+
+    const Power5& power = m_powers5[k - MINEXPONENT];
+    int shift = -(exponent + k + power.binaryExponent);
+    if (shift < 58 || shift > 64)
+    {
+        return false;
+    }
+
+    uint32_t value = roundToOdd(power.significand, valueMantissa, shift);
+    uint32_t high = roundToOdd(power.significand, highMantissa, shift);
+    uint32_t low = roundToOdd(power.significand, lowMantissa, shift);
+
+    // Step 3:
+    // There is at most one multiple of 10 in the interval, and if so it has the fewest
+    // digits. Otherwise the integer below or above the value is in it, or both, and then
+    // the closer one wins, the even one on a tie. The scaled numbers are compared as
+    // quarters: an inexact one is odd and so never equal to a multiple of 4. Everything
+    // is computed before choosing, which takes no branch to mispredict.
+    uint32_t integer = value >> 2;
+    uint32_t tensBelow = integer / 10;
+    bool isTensBelowIn = low + isOdd <= tensBelow * 40;
+    bool isTensAboveIn = tensBelow * 40 + 40 + isOdd <= high;
+    bool isTens = integer >= 10 && isTensBelowIn != isTensAboveIn;
+
+    uint32_t isBelowIn = low + isOdd <= integer << 2;
+    uint32_t isAboveIn = (integer << 2) + 4 + isOdd <= high;
+    uint32_t middle = (integer << 2) + 2;
+    uint32_t isCloserAbove = (value > middle) | ((value == middle) & integer);
+    uint32_t isUp = (isBelowIn ^ 1) | (isAboveIn & isCloserAbove);
+
+    uint32_t result = isTens ? tensBelow + (isTensBelowIn ? 0 : 1) : integer + isUp;
+    int removed = isTens ? 1 : 0;
+    while (result % 10 == 0)
+    {
+        result /= 10;
+        ++removed;
+    }
+
+    int length = digitCount(result);
+    writeDigits(result, length, digits);
+    *count = length;
+    *dec = length - 1 + removed - k;
+
+    return true;
+}
+
+template <typename TChar>
+void FloatDigits::writeDigits(uint64_t value, int count, TChar* digits)
+{
+    // Up to MAXCOUNT digits are padded with zeros to exactly MAXCOUNT, which the same
+    // straight code writes without a loop to mispredict. The terminator then cuts off
+    // the padding. They are taken from the top of padded / 10^8 in 57 bit fixed point,
+    // two at a time by multiplying what is left by 100, so without any division (the
+    // approach of James Edward Anhalt III). Rounding up the reciprocal keeps the error
+    // below 1/128 of the last pair. Longer ones take two digits per division, eight
+    // with 32 bit ones.
+    if (count <= MAXCOUNT)
+    {
+        const uint64_t mask = ((uint64_t)1 << 57) - 1;
+        uint32_t padded = (uint32_t)value * (uint32_t)m_powersOfTen[MAXCOUNT - count];
+        uint64_t fixed = padded * (uint64_t)1441151881;
+        digits[0] = (TChar)('0' + (fixed >> 57));
+        for (int i = 1; i < MAXCOUNT; i += 2)
+        {
+            fixed = (fixed & mask) * 100;
+            const char* pair = m_digitPairs + 2 * (fixed >> 57);
+            digits[i] = (TChar)pair[0];
+            digits[i + 1] = (TChar)pair[1];
+        }
+
+        digits[count] = 0;
+        return;
+    }
+
+    digits[count] = 0;
+    int i = count;
+    uint32_t low = (uint32_t)(value % 100000000);
+    value /= 100000000;
+    for (int j = 0; j < 4; ++j)
+    {
+        const char* pair = m_digitPairs + 2 * (low % 100);
+        low /= 100;
+        digits[--i] = (TChar)pair[1];
+        digits[--i] = (TChar)pair[0];
+    }
+
+    uint32_t high = (uint32_t)value;
+    while (i >= 2)
+    {
+        const char* pair = m_digitPairs + 2 * (high % 100);
+        high /= 100;
+        digits[--i] = (TChar)pair[1];
+        digits[--i] = (TChar)pair[0];
+    }
+
+    if (i == 1)
+    {
+        digits[0] = (TChar)('0' + high);
+    }
+}
+
+#endif // FLOATDIGITS_H
@@ -0,0 +1,341 @@
+#ifndef GRISU_H
+#define GRISU_H
+
+#include <cstdint>
+
+// Grisu3 fast path (Florian Loitsch, "Printing Floating-Point Numbers Quickly and Accurately
+// with Integers"). The "counted" variant asks for `count` significant digits, the "shortest"
+// variant for the shortest digits which round trip. Both tell us whether they can
+// guarantee the result. When they cannot, the caller must fall back to the exact BigNum path.
+//
+// Inspired by https://github.com/google/double-conversion (fast-dtoa.cc)
+class Grisu
+{
+public:
+    // The 64 bit arithmetic can not guarantee correct digits beyond this count in
+    // most cases, so we don't even try.
+    static const int MAXCOUNT = 17;
+
+    // Try to generate `count` significant digits of mantissa * 2^exponent (mantissa != 0).
+    // On success the digits are written to `digits` (count characters plus a null terminator),
+    // `dec` receives the decimal exponent of the first digit and true is returned.
+    // Returns false if the correctly rounded result could not be proven; `digits` is then garbage.
+    template <typename TChar>
+    static bool tryRunCounted(uint64_t mantissa, int exponent, int count, TChar* digits, int* dec);
+
+    // Try to generate the shortest digits which identify mantissa * 2^exponent (mantissa != 0)
+    // among its neighbours, and among those the closest to the value. The neighbours are
+    // (mantissa +- 1) * 2^exponent, except that the lower one is mantissa * 2^exponent -
+    // 2^(exponent - 1) if hasUnequalMargins is set (the value is a power of two). `digits`
+    // needs room for MAXCOUNT + 1 characters. Works for any binary format whose mantissa
+    // has at most 62 bits. Returns false if the result could not be proven.
+    template <typename TChar>
+    static bool tryRunShortest(uint64_t mantissa, int exponent, bool hasUnequalMargins, TChar* digits, int* count, int* dec);
+
+private:
+    // A "do it yourself" floating point number: f * 2^e.
+    struct DiyFp
+    {
+        uint64_t f;
+        int e;
+    };
+
+    struct CachedPower
+    {
+        uint64_t significand;
+        int16_t binaryExponent;
+        int16_t decimalExponent;
+    };
+
+    // The scaled value should have its binary exponent in [MINTARGETEXPONENT, MAXTARGETEXPONENT]
+    // so that the integral part fits in 32 bits and the fractional part leaves room for
+    // multiplication by 10.
+    static const int MINTARGETEXPONENT = -60;
+    static const int MAXTARGETEXPONENT = -32;
+
+    static const int CACHEDPOWERSNUM = 87;
+    static const int CACHEDPOWERSOFFSET = 348;
+    static const int CACHEDPOWERSDISTANCE = 8;
+    static const CachedPower m_cachedPowers[CACHEDPOWERSNUM];
+    static const uint32_t m_smallPowersOfTen[11];
+
+    static DiyFp normalize(uint64_t mantissa, int exponent);
+    static DiyFp multiply(const DiyFp& lhs, const DiyFp& rhs);
+    static void getCachedPower(int minExponent, DiyFp* pPower, int* pDecimalExponent);
+    static void biggestPowerTen(uint32_t number, int numberBits, uint32_t* pPower, int* pExponentPlusOne);
+
+    template <typename TChar>
+    static bool roundWeedCounted(TChar* buffer, int length, uint64_t rest, uint64_t tenKappa, uint64_t unit, int* pKappa);
+
+    template <typename TChar>
+    static bool digitGenCounted(const DiyFp& w, int count, TChar* buffer, int* pKappa);
+
+    template <typename TChar>
+    static bool roundWeedShortest(TChar* buffer, int length, uint64_t distanceTooHighW, uint64_t unsafeInterval, uint64_t rest, uint64_t tenKappa, uint64_t unit);
+
+    template <typename TChar>
+    static bool digitGenShortest(const DiyFp& low, const DiyFp& w, const DiyFp& high, TChar* buffer, int* pLength, int* pKappa);
+};
+
+template <typename TChar>
+bool Grisu::tryRunCounted(uint64_t mantissa, int exponent, int count, TChar* digits, int* dec)
+{
+    DiyFp w = normalize(mantissa, exponent);
+
+    // Scale w by a cached power of ten so that its exponent falls into the target range.
+    DiyFp tenMk;
+    int mk = 0;
+    getCachedPower(MINTARGETEXPONENT - (w.e + 64), &tenMk, &mk);
+
+    DiyFp scaledW = multiply(w, tenMk);
+
+    int kappa = 0;
+    if (!digitGenCounted(scaledW, count, digits, &kappa))
+    {
+        return false;
+    }
+
+    digits[count] = 0;
+
+    // value ~= digits * 10^(kappa - mk), where digits is read as an integer.
+    *dec = kappa - mk + count - 1;
+
+    return true;
+}
+
+template <typename TChar>
+bool Grisu::tryRunShortest(uint64_t mantissa, int exponent, bool hasUnequalMargins, TChar* digits, int* count, int* dec)
+{
+    DiyFp w = normalize(mantissa, exponent);
+
+    // The boundaries are the midpoints to the neighbours, brought to the exponent of w.
+    DiyFp high = normalize((mantissa << 1) + 1, exponent - 1);
+    DiyFp low;
+    if (hasUnequalMargins)
+    {
+        low.f = (mantissa << 2) - 1;
+        low.e = exponent - 2;
+    }
+    else
+    {
+        low.f = (mantissa << 1) - 1;
+        low.e = exponent - 1;
+    }
+
+    low.f <<= low.e - high.e;
+    low.e = high.e;
+
+    DiyFp tenMk;
+    int mk = 0;
+    getCachedPower(MINTARGETEXPONENT - (w.e + 64), &tenMk, &mk);
+
+    int kappa = 0;
+    if (!digitGenShortest(multiply(low, tenMk), multiply(w, tenMk), multiply(high, tenMk), digits, count, &kappa))
+    {
+        return false;
+    }
+
+    digits[*count] = 0;
+    *dec = kappa - mk + *count - 1;
+
+    return true;
+}
+
+template <typename TChar>
+bool Grisu::roundWeedCounted(TChar* buffer, int length, uint64_t rest, uint64_t tenKappa, uint64_t unit, int* pKappa)
+{
+    // rest is the remainder after the last generated digit, tenKappa is the weight of the
+    // last digit and unit is the accumulated error. We can only decide the rounding
+    // direction if the whole error interval lies on one side of the midpoint.
+    if (unit >= tenKappa || tenKappa - unit <= unit)
+    {
+        return false;
+    }
+
+    // Round down if even rest + unit is below the midpoint.
+    if ((tenKappa - rest > rest) && (tenKappa - 2 * rest >= 2 * unit))
+    {
+        return true;
+    }
+
+    // Round up if even rest - unit is above the midpoint.
+    if ((rest > unit) && (tenKappa - (rest - unit) <= (rest - unit)))
+    {
+        ++buffer[length - 1];
+        for (int i = length - 1; i > 0; --i)
+        {
+            if (buffer[i] != '0' + 10)
+            {
+                break;
+            }
+
+            buffer[i] = '0';
+            ++buffer[i - 1];
+        }
+
+        // All digits were 9. The digits are now 100...0 at the next exponent.
+        if (buffer[0] == '0' + 10)
+        {
+            buffer[0] = '1';
+            *pKappa += 1;
+        }
+
+        return true;
+    }
+
+    // The error interval contains the midpoint (this includes exact ties).
+    return false;
+}
+
+template <typename TChar>
+bool Grisu::digitGenCounted(const DiyFp& w, int count, TChar* buffer, int* pKappa)
+{
+    // The product of the normalized input and the cached power is off by less than 1 unit.
+    uint64_t error = 1;
+
+    // Split w into integral and fractional parts: w = integrals + fractionals / one.
+    const int oneShift = -w.e;
+    const uint64_t one = (uint64_t)1 << oneShift;
+    uint32_t integrals = (uint32_t)(w.f >> oneShift);
+    uint64_t fractionals = w.f & (one - 1);
+
+    uint32_t divisor = 0;
+    int kappa = 0;
+    biggestPowerTen(integrals, 64 - oneShift, &divisor, &kappa);
+
+    int length = 0;
+    while (kappa > 0)
+    {
+        buffer[length] = (TChar)('0' + integrals / divisor);
+        ++length;
+        integrals %= divisor;
+        --kappa;
+
+        if (length == count)
+        {
+            break;
+        }
+
+        divisor /= 10;
+    }
+
+    if (length == count)
+    {
+        uint64_t rest = ((uint64_t)integrals << oneShift) + fractionals;
+        bool result = roundWeedCounted(buffer, length, rest, (uint64_t)divisor << oneShift, error, &kappa);
+        *pKappa = kappa;
+        return result;
+    }
+
+    // Generate the fractional digits. The error grows by a factor of 10 with every digit.
+    while (length < count && fractionals > error)
+    {
+        fractionals *= 10;
+        error *= 10;
+
+        buffer[length] = (TChar)('0' + (int)(fractionals >> oneShift));
+        ++length;
+        fractionals &= one - 1;
+        --kappa;
+    }
+
+    if (length != count)
+    {
+        return false;
+    }
+
+    bool result = roundWeedCounted(buffer, length, fractionals, one, error, &kappa);
+    *pKappa = kappa;
+    return result;
+}
+
+template <typename TChar>
+bool Grisu::roundWeedShortest(TChar* buffer, int length, uint64_t distanceTooHighW, uint64_t unsafeInterval, uint64_t rest, uint64_t tenKappa, uint64_t unit)
+{
+    // The digits so far lie within the unsafe interval. Move the last digit down as long
+    // as the result gets closer to w, considering w to be anywhere in [w - unit, w + unit].
+    uint64_t smallDistance = distanceTooHighW - unit;
+    uint64_t bigDistance = distanceTooHighW + unit;
+    while (rest < smallDistance
+        && unsafeInterval - rest >= tenKappa
+        && (rest + tenKappa < smallDistance || smallDistance - rest >= rest + tenKappa - smallDistance))
+    {
+        --buffer[length - 1];
+        rest += tenKappa;
+    }
+
+    // If the next smaller digit could also be closer for some w in the error interval we
+    // can not decide.
+    if (rest < bigDistance
+        && unsafeInterval - rest >= tenKappa
+        && (rest + tenKappa < bigDistance || bigDistance - rest > rest + tenKappa - bigDistance))
+    {
+        return false;
+    }
+
+    // The result must be safely inside the interval of values which round to the input.
+    return 2 * unit <= rest && rest <= unsafeInterval - 4 * unit;
+}
+
+template <typename TChar>
+bool Grisu::digitGenShortest(const DiyFp& low, const DiyFp& w, const DiyFp& high, TChar* buffer, int* pLength, int* pKappa)
+{
+    // The scaled boundaries are off by less than 1 unit each. Widen the interval by the
+    // error: everything inside (tooLow, tooHigh) may round to the input, but only the
+    // part we are certain about is safe.
+    uint64_t unit = 1;
+    uint64_t tooLow = low.f - unit;
+    uint64_t tooHigh = high.f + unit;
+    uint64_t unsafeInterval = tooHigh - tooLow;
+
+    const int oneShift = -w.e;
+    const uint64_t one = (uint64_t)1 << oneShift;
+    uint32_t integrals = (uint32_t)(tooHigh >> oneShift);
+    uint64_t fractionals = tooHigh & (one - 1);
+
+    uint32_t divisor = 0;
+    int kappa = 0;
+    biggestPowerTen(integrals, 64 - oneShift, &divisor, &kappa);
+
+    // Generate the digits of tooHigh until the rest is inside the unsafe interval.
+    int length = 0;
+    while (kappa > 0)
+    {
+        buffer[length] = (TChar)('0' + integrals / divisor);
+        ++length;
+        integrals %= divisor;
+        --kappa;
+
+        uint64_t rest = ((uint64_t)integrals << oneShift) + fractionals;
+        if (rest < unsafeInterval)
+        {
+            *pLength = length;
+            *pKappa = kappa;
+            return roundWeedShortest(buffer, length, tooHigh - w.f, unsafeInterval, rest, (uint64_t)divisor << oneShift, unit);
+        }
+
+        divisor /= 10;
+    }
+
+    // The fractional digits. The error grows by a factor of 10 with every digit.
+    while (true)
+    {
+        fractionals *= 10;
+        unit *= 10;
+        unsafeInterval *= 10;
+
+        buffer[length] = (TChar)('0' + (int)(fractionals >> oneShift));
+        ++length;
+        fractionals &= one - 1;
+        --kappa;
+
+        if (fractionals < unsafeInterval)
+        {
+            *pLength = length;
+            *pKappa = kappa;
+            return roundWeedShortest(buffer, length, (tooHigh - w.f) * unit, unsafeInterval, fractionals, one, unit);
+        }
+    }
+}
+
+#endif // GRISU_H
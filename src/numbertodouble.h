@@ -0,0 +1,409 @@
+#ifndef NUMBERTODOUBLE_H
+#define NUMBERTODOUBLE_H
+
+#include "doubletonumber.h"
+#include "eisellemire.h"
+#include <cerrno>
+#include <cstring>
+
+// Correctly rounded conversion of decimal digits to the nearest double (ties to even), the
+// reverse of DoubleToNumber and DoubleToChars.
+//
+// With up to 19 significant digits the value is mantissa * 10^exponent with a 64 bit
+// mantissa. If both are exact doubles a single IEEE multiplication or division rounds
+// correctly (Clinger's fast path), otherwise Eisel-Lemire does. Longer inputs run
+// Eisel-Lemire on their first 19 digits and on those plus one unit in the last place. The
+// exact value lies strictly between the two, so when both round to the same double we are
+// done. Only when they differ the digits are compared with the halfway point between the
+// two doubles, exactly, in a ParseBigNum.
+//
+// A halfway point between two doubles has at most 768 significant digits, so digits beyond
+// PARSEDOUBLE_MAXDIGITS can only tell whether the rest is nonzero, and are replaced by a
+// single 1 if they are.
+//
+// Unlike strtod the result does not depend on the locale, and unlike std::from_chars a
+// value which is out of range is still stored (as infinity or zero).
+
+#define PARSEDOUBLE_MAXDIGITS 768
+
+// The powers of ten which are exact doubles.
+static const double DOUBLE_POWERSOFTEN[23] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+template <typename TChar>
+struct ParseDoubleResult
+{
+    // One past the last character of the number, or `first` if there is none.
+    const TChar* ptr;
+
+    // 0 on success, EINVAL if there is no number, ERANGE if the value overflowed to
+    // infinity or underflowed to zero.
+    int ec;
+};
+
+inline double DoubleFromBits(uint64_t bits, bool isNegative)
+{
+    bits |= (uint64_t)isNegative << 63;
+
+    double value = 0;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Sets result to the `count` decimal digits at pDigits as an integer. A '.' among the
+// digits is skipped.
+template <typename TChar>
+void SetParseBigNumDigits(ParseBigNum& result, const TChar* pDigits, int count)
+{
+    result.setUInt32(0);
+
+    // Nine digits at a time fit into the 32 bit multiplier.
+    while (count > 0)
+    {
+        int chunkCount = std::min(count, 9);
+        uint32_t chunk = 0;
+        uint32_t scale = 1;
+        for (int i = 0; i < chunkCount; ++pDigits)
+        {
+            if (*pDigits != '.')
+            {
+                chunk = chunk * 10 + (uint32_t)(*pDigits - '0');
+                scale *= 10;
+                ++i;
+            }
+        }
+
+        result.multiply(scale);
+        ParseBigNum::add(result, ParseBigNum(chunk), result);
+        count -= chunkCount;
+    }
+}
+
+// The IEEE bits of the double closest to D * 10^exponent (D as in DigitsToDouble), which
+// lies between the double `bits` and the next one.
+template <typename TChar>
+uint64_t RoundDigitsToDoubleBits(const TChar* pDigits, int count, int exponent, uint64_t bits)
+{
+    // Compare all digits with the halfway point (2m + 1) * 2^(e - 1) between bits = m * 2^e
+    // and the next double.
+    uint64_t m = bits & (((uint64_t)1 << 52) - 1);
+    int e = -1074;
+    if ((bits >> 52) != 0)
+    {
+        m |= (uint64_t)1 << 52;
+        e = (int)(bits >> 52) - 1075;
+    }
+
+    ParseBigNum digitsValue;
+    if (count > PARSEDOUBLE_MAXDIGITS)
+    {
+        // The dropped digits end with a nonzero one.
+        SetParseBigNumDigits(digitsValue, pDigits, PARSEDOUBLE_MAXDIGITS);
+        digitsValue.multiply(10);
+        ParseBigNum::add(digitsValue, ParseBigNum(1u), digitsValue);
+        exponent += count - PARSEDOUBLE_MAXDIGITS - 1;
+    }
+    else
+    {
+        SetParseBigNumDigits(digitsValue, pDigits, count);
+    }
+
+    ParseBigNum halfway(2 * m + 1);
+    if (exponent >= 0)
+    {
+        digitsValue.multiplyPow10((uint32_t)exponent);
+    }
+    else
+    {
+        halfway.multiplyPow10((uint32_t)-exponent);
+    }
+
+    if (e - 1 >= 0)
+    {
+        ParseBigNum::shiftLeft(&halfway, (uint32_t)(e - 1));
+    }
+    else
+    {
+        ParseBigNum::shiftLeft(&digitsValue, (uint32_t)(1 - e));
+    }
+
+    int compareResult = ParseBigNum::compare(digitsValue, halfway);
+    if (compareResult > 0 || (compareResult == 0 && (bits & 1) != 0))
+    {
+        ++bits;
+    }
+
+    return bits;
+}
+
+// The double closest to D * 10^exponent, where D is the integer made of the `count`
+// digits at pDigits and a '.' among them is skipped. The caller has already read the
+// first mantissaCount of them (at most 19) into mantissa, which must not be 0. The other
+// digits are only looked at if there are any, the last of them must not be '0' then.
+template <typename TChar>
+double DigitsToDouble(const TChar* pDigits, int count, int exponent, uint64_t mantissa, int mantissaCount, bool isNegative)
+{
+    // Step 1: mantissa * 10^mantissaExponent is the value with the digits after the first
+    // 19 cut off.
+    int mantissaExponent = exponent + (count - mantissaCount);
+    bool isTruncated = count > mantissaCount;
+
+    // Step 2: Clinger's fast path.
+    if (!isTruncated && mantissa <= ((uint64_t)1 << 53) && mantissaExponent >= -22 && mantissaExponent <= 22)
+    {
+        double value = (double)mantissa;
+        value = mantissaExponent < 0 ? value / DOUBLE_POWERSOFTEN[-mantissaExponent] : value * DOUBLE_POWERSOFTEN[mantissaExponent];
+        return isNegative ? -value : value;
+    }
+
+    // Step 3: Eisel-Lemire, for the truncated digits also one unit in the last place up.
+    // When the two differ the digits decide.
+    uint64_t bits = EiselLemire::compute(mantissa, mantissaExponent);
+    if (!isTruncated || bits == EiselLemire::compute(mantissa + 1, mantissaExponent))
+    {
+        return DoubleFromBits(bits, isNegative);
+    }
+
+    return DoubleFromBits(RoundDigitsToDoubleBits(pDigits, count, exponent, bits), isNegative);
+}
+
+// Whether [first, last) starts with the lower case letters of `text`, ignoring case.
+template <typename TChar>
+bool StartsWithIgnoreCase(const TChar* first, const TChar* last, const char* text)
+{
+    for (; *text != 0; ++text, ++first)
+    {
+        if (first == last || (*first | 0x20) != *text)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Parses a number at the start of [first, last) like strtod in the "C" locale, without
+// hexadecimal floats and without skipping white space:
+//
+//     [+|-] (digits [. [digits]] | . digits) [(e|E) [+|-] digits]
+//     [+|-] (inf | infinity | nan | nan(chars))
+//
+// The letters may be in any case. On success *value receives the correctly rounded
+// result, on ERANGE infinity or zero with the sign of the input. On EINVAL it is not
+// touched.
+template <typename TChar>
+ParseDoubleResult<TChar> ParseDouble(const TChar* first, const TChar* last, double* value)
+{
+    ParseDoubleResult<TChar> result = { first, EINVAL };
+
+    const TChar* pCurrent = first;
+    bool isNegative = false;
+    if (pCurrent != last && (*pCurrent == '-' || *pCurrent == '+'))
+    {
+        isNegative = *pCurrent == '-';
+        ++pCurrent;
+    }
+
+    // Step 1: Infinity and NaN.
+    if (pCurrent != last && ((*pCurrent | 0x20) == 'i' || (*pCurrent | 0x20) == 'n'))
+    {
+        if (StartsWithIgnoreCase(pCurrent, last, "inf"))
+        {
+            pCurrent += StartsWithIgnoreCase(pCurrent, last, "infinity") ? 8 : 3;
+            *value = DoubleFromBits((uint64_t)0x7FF << 52, isNegative);
+        }
+        else if (StartsWithIgnoreCase(pCurrent, last, "nan"))
+        {
+            pCurrent += 3;
+
+            // nan(chars) with letters, digits and underscores in the parentheses.
+            if (pCurrent != last && *pCurrent == '(')
+            {
+                const TChar* pEnd = pCurrent + 1;
+                while (pEnd != last && (((*pEnd | 0x20) >= 'a' && (*pEnd | 0x20) <= 'z') || (*pEnd >= '0' && *pEnd <= '9') || *pEnd == '_'))
+                {
+                    ++pEnd;
+                }
+
+                if (pEnd != last && *pEnd == ')')
+                {
+                    pCurrent = pEnd + 1;
+                }
+            }
+
+            *value = DoubleFromBits((uint64_t)0xFFF << 51, isNegative);
+        }
+        else
+        {
+            return result;
+        }
+
+        result.ptr = pCurrent;
+        result.ec = 0;
+        return result;
+    }
+
+    // Step 2: The digits, collected into a 64 bit mantissa. Any 19 digits fit, longer
+    // inputs are collected again below.
+    const TChar* pDigits = pCurrent;
+    uint64_t mantissa = 0;
+    for (; pCurrent != last && *pCurrent >= '0' && *pCurrent <= '9'; ++pCurrent)
+    {
+        mantissa = mantissa * 10 + (uint64_t)(*pCurrent - '0');
+    }
+
+    int digitCount = (int)(pCurrent - pDigits);
+    int fractionCount = 0;
+    if (pCurrent != last && *pCurrent == '.')
+    {
+        const TChar* pFraction = ++pCurrent;
+        for (; pCurrent != last && *pCurrent >= '0' && *pCurrent <= '9'; ++pCurrent)
+        {
+            mantissa = mantissa * 10 + (uint64_t)(*pCurrent - '0');
+        }
+
+        fractionCount = (int)(pCurrent - pFraction);
+        digitCount += fractionCount;
+    }
+
+    if (digitCount == 0)
+    {
+        return result;
+    }
+
+    const TChar* pDigitsEnd = pCurrent;
+
+    // Step 3: The exponent, only if it has digits. Huge exponents are clamped, they
+    // overflow or underflow anyway.
+    int explicitExponent = 0;
+    if (pCurrent != last && (*pCurrent | 0x20) == 'e')
+    {
+        const TChar* pExponent = pCurrent + 1;
+        bool isExponentNegative = false;
+        if (pExponent != last && (*pExponent == '-' || *pExponent == '+'))
+        {
+            isExponentNegative = *pExponent == '-';
+            ++pExponent;
+        }
+
+        if (pExponent != last && *pExponent >= '0' && *pExponent <= '9')
+        {
+            for (; pExponent != last && *pExponent >= '0' && *pExponent <= '9'; ++pExponent)
+            {
+                if (explicitExponent < 100000000)
+                {
+                    explicitExponent = explicitExponent * 10 + (int)(*pExponent - '0');
+                }
+            }
+
+            explicitExponent = isExponentNegative ? -explicitExponent : explicitExponent;
+            pCurrent = pExponent;
+        }
+    }
+
+    result.ptr = pCurrent;
+    result.ec = 0;
+
+    // Step 4: Leading zeros count as digits above, so more than 19 digits need a closer
+    // look: the significant digits run from the first to the last nonzero digit, and the
+    // mantissa takes the first 19 of them.
+    int exponent = explicitExponent - fractionCount;
+    int mantissaCount = digitCount;
+    if (digitCount > 19)
+    {
+        while (*pDigits == '0' || *pDigits == '.')
+        {
+            if (++pDigits == pDigitsEnd)
+            {
+                break;
+            }
+        }
+
+        while (pDigits != pDigitsEnd && (pDigitsEnd[-1] == '0' || pDigitsEnd[-1] == '.'))
+        {
+            exponent += pDigitsEnd[-1] == '0' ? 1 : 0;
+            --pDigitsEnd;
+        }
+
+        digitCount = 0;
+        mantissa = 0;
+        for (const TChar* pDigit = pDigits; pDigit != pDigitsEnd; ++pDigit)
+        {
+            if (*pDigit != '.')
+            {
+                mantissa = digitCount < 19 ? mantissa * 10 + (uint64_t)(*pDigit - '0') : mantissa;
+                ++digitCount;
+            }
+        }
+
+        mantissaCount = std::min(digitCount, 19);
+    }
+
+    if (mantissa == 0)
+    {
+        *value = DoubleFromBits(0, isNegative);
+        return result;
+    }
+
+    *value = DigitsToDouble(pDigits, digitCount, exponent, mantissa, mantissaCount, isNegative);
+
+    uint64_t bits = 0;
+    memcpy(&bits, value, sizeof(bits));
+    bits &= ~((uint64_t)1 << 63);
+    if (bits == 0 || bits == (uint64_t)0x7FF << 52)
+    {
+        result.ec = ERANGE;
+    }
+
+    return result;
+}
+
+// The double closest to the digits of `number`. NaN and infinity are taken from its scale,
+// no digits mean zero. Returns 0, or ERANGE if the value overflowed to infinity or
+// underflowed to zero.
+inline int NumberToDouble(const NUMBER* number, double* value)
+{
+    bool isNegative = number->sign != 0;
+    if ((unsigned int)number->scale == SCALE_NAN || number->scale == SCALE_INF)
+    {
+        *value = DoubleFromBits(number->scale == SCALE_INF ? (uint64_t)0x7FF << 52 : (uint64_t)0xFFF << 51, isNegative);
+        return 0;
+    }
+
+    // Trailing zeros (from DTN_PRECISION) are not significant.
+    int count = 0;
+    while (count < NUMBER_MAXDIGITS && number->digits[count] != 0)
+    {
+        ++count;
+    }
+
+    while (count > 0 && number->digits[count - 1] == '0')
+    {
+        --count;
+    }
+
+    if (count == 0)
+    {
+        *value = DoubleFromBits(0, isNegative);
+        return 0;
+    }
+
+    int mantissaCount = std::min(count, 19);
+    uint64_t mantissa = 0;
+    for (int i = 0; i < mantissaCount; ++i)
+    {
+        mantissa = mantissa * 10 + (uint64_t)(number->digits[i] - '0');
+    }
+
+    *value = DigitsToDouble(number->digits, count, number->scale - (count - 1), mantissa, mantissaCount, isNegative);
+
+    uint64_t bits = 0;
+    memcpy(&bits, value, sizeof(bits));
+    bits &= ~((uint64_t)1 << 63);
+    return (bits == 0 || bits == (uint64_t)0x7FF << 52) ? ERANGE : 0;
+}
+
+#endif // NUMBERTODOUBLE_H
@@ -0,0 +1,191 @@
+#ifndef PACKEDNUMBER_H
+#define PACKEDNUMBER_H
+
+#include "doubletonumber.h"
+#include <cstring>
+
+// A 16 byte form of NUMBER for buffering many converted values, where the 200+ bytes of
+// wide digits of NUMBER would mostly be memory traffic.
+//
+// The digits are stored as BCD, two per byte with the first digit in the high nibble,
+// without the trailing zeros which DTN_PRECISION pads to `precision` digits; those are
+// restored by UnpackNumber. A NUMBER fits if it has at most PACKEDNUMBER_MAXDIGITS digits
+// before the trailing zeros, a scale which fits into 16 bits and a precision up to 255.
+// That covers every double in DTN_SHORTEST mode and in DTN_PRECISION mode up to 22
+// digits. PackNumber and UnpackNumber round trip exactly.
+
+#define PACKEDNUMBER_MAXDIGITS 22
+
+#define PACKEDNUMBER_NEGATIVE 0x01
+#define PACKEDNUMBER_PADDED 0x02
+#define PACKEDNUMBER_NAN 0x04
+#define PACKEDNUMBER_INF 0x08
+
+struct PACKEDNUMBER
+{
+    int16_t scale;
+    uint8_t bcd[PACKEDNUMBER_MAXDIGITS / 2];
+
+    // The number of digits in `bcd`, and the precision of the NUMBER.
+    uint8_t length;
+    uint8_t precision;
+
+    // PACKEDNUMBER_NEGATIVE for sign 1, PACKEDNUMBER_PADDED if the digits are followed by
+    // zeros up to `precision` digits, PACKEDNUMBER_NAN and PACKEDNUMBER_INF for the
+    // scales SCALE_NAN and SCALE_INF.
+    uint8_t flags;
+};
+
+static_assert(sizeof(PACKEDNUMBER) == 16, "PACKEDNUMBER should take 16 bytes");
+
+// Packs the null terminated `digits` and precision, scale and sign of a NUMBER. All bytes
+// of *packed are written, so equal NUMBERs give equal PACKEDNUMBERs. Returns false, with
+// *packed undefined, if the NUMBER does not fit.
+template <typename TChar>
+bool PackDigits(const TChar* digits, int precision, int scale, int sign, PACKEDNUMBER* packed)
+{
+    memset(packed, 0, sizeof(*packed));
+    if (precision < 0 || precision > UINT8_MAX)
+    {
+        return false;
+    }
+
+    packed->precision = (uint8_t)precision;
+    packed->flags = sign ? PACKEDNUMBER_NEGATIVE : 0;
+    if (scale == (int)SCALE_NAN || scale == SCALE_INF)
+    {
+        packed->flags |= scale == SCALE_INF ? PACKEDNUMBER_INF : PACKEDNUMBER_NAN;
+    }
+    else if (scale >= INT16_MIN && scale <= INT16_MAX)
+    {
+        packed->scale = (int16_t)scale;
+    }
+    else
+    {
+        return false;
+    }
+
+    // Step 1: count the digits.
+    int count = 0;
+    while (digits[count] != 0)
+    {
+        ++count;
+    }
+
+    // Step 2: trailing zeros are dropped if they only pad the digits to `precision`, a
+    // shorter NUMBER keeps them.
+    int length = count;
+    if (count == precision && count > 0)
+    {
+        packed->flags |= PACKEDNUMBER_PADDED;
+        while (length > 0 && digits[length - 1] == '0')
+        {
+            --length;
+        }
+    }
+
+    if (length > PACKEDNUMBER_MAXDIGITS)
+    {
+        return false;
+    }
+
+    // Step 3: two digits per byte.
+    packed->length = (uint8_t)length;
+    for (int i = 0; i + 1 < length; i += 2)
+    {
+        packed->bcd[i / 2] = (uint8_t)(((digits[i] - '0') << 4) | (digits[i + 1] - '0'));
+    }
+
+    if (length & 1)
+    {
+        packed->bcd[length / 2] = (uint8_t)((digits[length - 1] - '0') << 4);
+    }
+
+    return true;
+}
+
+inline bool PackNumber(const NUMBER& number, PACKEDNUMBER* packed)
+{
+    return PackDigits(number.digits, number.precision, number.scale, number.sign, packed);
+}
+
+inline void UnpackNumber(const PACKEDNUMBER& packed, NUMBER* number)
+{
+    number->precision = packed.precision;
+    number->sign = (packed.flags & PACKEDNUMBER_NEGATIVE) ? 1 : 0;
+    number->scale = packed.scale;
+    if (packed.flags & PACKEDNUMBER_NAN)
+    {
+        number->scale = SCALE_NAN;
+    }
+    else if (packed.flags & PACKEDNUMBER_INF)
+    {
+        number->scale = SCALE_INF;
+    }
+
+    int count = packed.length;
+    for (int i = 0; i < count; ++i)
+    {
+        number->digits[i] = (wchar_t)('0' + ((packed.bcd[i / 2] >> ((i & 1) ? 0 : 4)) & 0xF));
+    }
+
+    if (packed.flags & PACKEDNUMBER_PADDED)
+    {
+        for (; count < packed.precision; ++count)
+        {
+            number->digits[count] = '0';
+        }
+    }
+
+    number->digits[count] = 0;
+}
+
+// Same as DoubleToNumber followed by PackNumber, but without the NUMBER: the digits are
+// generated into a small char buffer. Returns false if the result does not fit or the
+// arguments are invalid.
+inline bool DoubleToPackedNumber(double value, int precision, DoubleToNumberMode mode, PACKEDNUMBER* packed)
+{
+    const FPDOUBLE* pValue = (const FPDOUBLE*)&value;
+    if (pValue->exp == 0x7FF)
+    {
+        int scale = (pValue->mantLo || pValue->mantHi) ? SCALE_NAN : SCALE_INF;
+        return PackDigits("", precision, scale, pValue->sign, packed);
+    }
+
+    char digits[NUMBER_MAXDIGITS + 1];
+    int scale = 0;
+    int sign = 0;
+    int result = 0;
+    if (mode == DTN_SHORTEST)
+    {
+        result = _ecvt2_shortest_s(digits, NUMBER_MAXDIGITS + 1, value, &precision, &scale, &sign);
+    }
+    else if (mode == DTN_FIXED)
+    {
+        result = _fcvt2_s(digits, NUMBER_MAXDIGITS + 1, value, precision, &precision, &scale, &sign);
+    }
+    else
+    {
+        result = _ecvt2_s(digits, NUMBER_MAXDIGITS + 1, value, precision, &scale, &sign);
+    }
+
+    if (result != 0)
+    {
+        return false;
+    }
+
+    // Zero has no significant digits.
+    if (digits[0] == '0')
+    {
+        digits[0] = 0;
+    }
+
+    return PackDigits(digits, precision, scale, sign, packed);
+}
+
+inline bool DoubleToPackedNumber(double value, int precision, PACKEDNUMBER* packed)
+{
+    return DoubleToPackedNumber(value, precision, DTN_PRECISION, packed);
+}
+
+#endif // PACKEDNUMBER_H
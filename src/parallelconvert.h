@@ -0,0 +1,255 @@
+#ifndef PARALLELCONVERT_H
+#define PARALLELCONVERT_H
+
+#include "doubletonumberbatch.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Converts large arrays of doubles on a pool of worker threads.
+//
+// The input is cut into chunks of PARALLELCONVERT_CHUNKSIZE values. Every worker starts
+// with a contiguous range of chunks and takes chunks from the front of its own range.
+// A worker which runs out of work steals chunks from the back of the other workers'
+// ranges, so the workers which got expensive values (BigNum fallbacks) are helped out.
+//
+// Each chunk is converted with DoubleToNumberBatch into its own slots of the output
+// array, so the output is ordered and identical to the single threaded result no matter
+// which worker converted which chunk. The digit engines keep all their BigNum scratch
+// state on the stack, so every worker has its own and nothing is shared but the input.
+
+#define PARALLELCONVERT_CHUNKSIZE 4096
+
+class ParallelConverter
+{
+public:
+    // threadCount == 0 uses all hardware threads. The calling thread of convert()
+    // counts as one of the workers, so threadCount - 1 threads are started.
+    explicit ParallelConverter(unsigned int threadCount = 0);
+    ~ParallelConverter();
+
+    unsigned int threadCount() const;
+
+    // Same as DoubleToNumberBatch(values, count, precision, numbers), spread over all
+    // workers. Concurrent calls on the same converter are serialized.
+    void convert(const double* values, size_t count, int precision, NUMBER* numbers);
+
+private:
+    ParallelConverter(const ParallelConverter&);
+    ParallelConverter& operator=(const ParallelConverter&);
+
+    // The [begin, end) chunk range of a worker, packed into one word so that the owner
+    // (taking from the front) and thieves (taking from the back) can both claim a chunk
+    // with a single compare-and-swap. Padded to a cache line to avoid false sharing.
+    struct WorkRange
+    {
+        std::atomic<uint64_t> range;
+        char padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    static uint64_t packRange(uint32_t begin, uint32_t end);
+
+    bool takeChunk(unsigned int worker, uint32_t* pChunk);
+    bool stealChunk(unsigned int worker, uint32_t* pChunk);
+    void runWorker(unsigned int worker);
+    void workerLoop(unsigned int worker);
+
+    unsigned int m_threadCount;
+    std::unique_ptr<WorkRange[]> m_ranges;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_jobMutex;
+    std::mutex m_mutex;
+    std::condition_variable m_startCondition;
+    std::condition_variable m_doneCondition;
+    uint64_t m_generation;
+    unsigned int m_pendingWorkers;
+    bool m_isStopping;
+
+    // The current job.
+    const double* m_values;
+    size_t m_count;
+    int m_precision;
+    NUMBER* m_numbers;
+};
+
+inline ParallelConverter::ParallelConverter(unsigned int threadCount)
+    :m_threadCount(threadCount),
+    m_generation(0),
+    m_pendingWorkers(0),
+    m_isStopping(false),
+    m_values(NULL),
+    m_count(0),
+    m_precision(0),
+    m_numbers(NULL)
+{
+    if (m_threadCount == 0)
+    {
+        m_threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    m_ranges.reset(new WorkRange[m_threadCount]);
+    for (unsigned int i = 0; i < m_threadCount; ++i)
+    {
+        m_ranges[i].range.store(0);
+    }
+
+    for (unsigned int i = 1; i < m_threadCount; ++i)
+    {
+        m_threads.push_back(std::thread(&ParallelConverter::workerLoop, this, i));
+    }
+}
+
+inline ParallelConverter::~ParallelConverter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = true;
+    }
+
+    m_startCondition.notify_all();
+
+    for (size_t i = 0; i < m_threads.size(); ++i)
+    {
+        m_threads[i].join();
+    }
+}
+
+inline unsigned int ParallelConverter::threadCount() const
+{
+    return m_threadCount;
+}
+
+inline void ParallelConverter::convert(const double* values, size_t count, int precision, NUMBER* numbers)
+{
+    size_t chunkCount = (count + PARALLELCONVERT_CHUNKSIZE - 1) / PARALLELCONVERT_CHUNKSIZE;
+    if (m_threadCount == 1 || chunkCount < 2)
+    {
+        DoubleToNumberBatch(values, count, precision, numbers);
+        return;
+    }
+
+    std::lock_guard<std::mutex> jobLock(m_jobMutex);
+
+    m_values = values;
+    m_count = count;
+    m_precision = precision;
+    m_numbers = numbers;
+
+    // Hand out equal contiguous ranges of chunks. Stealing evens out the rest.
+    for (unsigned int i = 0; i < m_threadCount; ++i)
+    {
+        uint32_t begin = (uint32_t)(chunkCount * i / m_threadCount);
+        uint32_t end = (uint32_t)(chunkCount * (i + 1) / m_threadCount);
+        m_ranges[i].range.store(packRange(begin, end));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pendingWorkers = m_threadCount - 1;
+        ++m_generation;
+    }
+
+    m_startCondition.notify_all();
+
+    runWorker(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [this] { return m_pendingWorkers == 0; });
+}
+
+inline uint64_t ParallelConverter::packRange(uint32_t begin, uint32_t end)
+{
+    return ((uint64_t)begin << 32) | end;
+}
+
+inline bool ParallelConverter::takeChunk(unsigned int worker, uint32_t* pChunk)
+{
+    std::atomic<uint64_t>& range = m_ranges[worker].range;
+    uint64_t current = range.load();
+    while (true)
+    {
+        uint32_t begin = (uint32_t)(current >> 32);
+        uint32_t end = (uint32_t)current;
+        if (begin >= end)
+        {
+            return false;
+        }
+
+        if (range.compare_exchange_weak(current, packRange(begin + 1, end)))
+        {
+            *pChunk = begin;
+            return true;
+        }
+    }
+}
+
+inline bool ParallelConverter::stealChunk(unsigned int worker, uint32_t* pChunk)
+{
+    for (unsigned int i = 1; i < m_threadCount; ++i)
+    {
+        std::atomic<uint64_t>& range = m_ranges[(worker + i) % m_threadCount].range;
+        uint64_t current = range.load();
+        while (true)
+        {
+            uint32_t begin = (uint32_t)(current >> 32);
+            uint32_t end = (uint32_t)current;
+            if (begin >= end)
+            {
+                break;
+            }
+
+            if (range.compare_exchange_weak(current, packRange(begin, end - 1)))
+            {
+                *pChunk = end - 1;
+                return true;
+            }
+        }
+    }
+
+    // No work is added while a job runs, so once every range is empty we are done.
+    return false;
+}
+
+inline void ParallelConverter::runWorker(unsigned int worker)
+{
+    uint32_t chunk = 0;
+    while (takeChunk(worker, &chunk) || stealChunk(worker, &chunk))
+    {
+        size_t begin = (size_t)chunk * PARALLELCONVERT_CHUNKSIZE;
+        size_t count = std::min((size_t)PARALLELCONVERT_CHUNKSIZE, m_count - begin);
+        DoubleToNumberBatch(m_values + begin, count, m_precision, m_numbers + begin);
+    }
+}
+
+inline void ParallelConverter::workerLoop(unsigned int worker)
+{
+    uint64_t generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_startCondition.wait(lock, [this, generation] { return m_isStopping || m_generation != generation; });
+            if (m_isStopping)
+            {
+                return;
+            }
+
+            generation = m_generation;
+        }
+
+        runWorker(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_pendingWorkers;
+        }
+
+        m_doneCondition.notify_one();
+    }
+}
+
+#endif // PARALLELCONVERT_H
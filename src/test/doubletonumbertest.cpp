@@ -1,5 +1,19 @@
 #include "gmock/gmock.h"
+#include "conversionstats.h"
+#include "doubleformat.h"
+#include "doublestreamwriter.h"
+#include "doubletochars.h"
+#include "doubletodecimal.h"
 #include "doubletonumber.h"
+#include "doubletonumberbatch.h"
+#include "doubletonumbercache.h"
+#include "numbertodouble.h"
+#include "packednumber.h"
+#include "parallelconvert.h"
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <vector>
 
 class DoubleToNumberTestFixture : public::testing::Test
 {
@@ -12,6 +26,62 @@ public:
         EXPECT_EQ(expectedDigits, std::wstring(actual.digits));
     }
 
+    // The same xorshift64 sequence in every test, starting from the bits of 1.0.
+    static std::vector<uint64_t> randomBits(size_t count)
+    {
+        std::vector<uint64_t> bits(count);
+        uint64_t state = 0x3FF0000000000000;
+        for (size_t i = 0; i < count; ++i)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            bits[i] = state;
+        }
+
+        return bits;
+    }
+
+    // The doubles with the bits of randomBits(count), NaN and infinity included.
+    static std::vector<double> randomDoubles(size_t count)
+    {
+        std::vector<uint64_t> bits = randomBits(count);
+        std::vector<double> values(count);
+        memcpy(values.data(), bits.data(), count * sizeof(double));
+        return values;
+    }
+
+    // Integers of up to 64 bits: randomBits(count)[i] >> (i % 64).
+    static std::vector<double> randomIntegers(size_t count)
+    {
+        std::vector<uint64_t> bits = randomBits(count);
+        std::vector<double> values(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            values[i] = (double)(int64_t)(bits[i] >> (i % 64));
+        }
+
+        return values;
+    }
+
+    // Prices with two decimals below maxCents / 100.
+    static std::vector<double> randomPrices(size_t count, uint64_t maxCents)
+    {
+        std::vector<uint64_t> bits = randomBits(count);
+        std::vector<double> values(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            values[i] = (double)(bits[i] % maxCents) / 100;
+        }
+
+        return values;
+    }
+
+    static void appendValues(std::vector<double>* pValues, const std::vector<double>& values)
+    {
+        pValues->insert(pValues->end(), values.begin(), values.end());
+    }
+
 protected:
     virtual void SetUp()
     {
@@ -225,4 +295,1663 @@ TEST_F(DoubleToNumberTestFixture, TrailingZeroTest)
     // Assert
     DoubleToNumberTestFixture::assertResult(expected, L"10000000000000000", actual);
     DoubleToNumberTestFixture::assertResult(expected2, L"10000000000000000", actual2);
-}
\ No newline at end of file
+}
+
+TEST_F(DoubleToNumberTestFixture, CallerBufferNarrowTest)
+{
+    // Prepare
+    char buffer[18];
+    int dec = 0;
+    int sign = 0;
+
+    // Act
+    int result = _ecvt2_s(buffer, sizeof(buffer), -0.84551240822557006, 17, &dec, &sign);
+
+    // Assert
+    EXPECT_EQ(0, result);
+    EXPECT_EQ(-1, dec);
+    EXPECT_EQ(1, sign);
+    EXPECT_EQ(std::string("84551240822557006"), std::string(buffer));
+}
+
+TEST_F(DoubleToNumberTestFixture, CallerBufferWideTest)
+{
+    // Prepare
+    wchar_t buffer[NUMBER_MAXDIGITS + 1];
+    int dec = 0;
+    int sign = 0;
+
+    // Act
+    int result = _ecvt2_s(buffer, NUMBER_MAXDIGITS + 1, 1000.9999999999999999999, 17, &dec, &sign);
+
+    // Assert
+    EXPECT_EQ(0, result);
+    EXPECT_EQ(3, dec);
+    EXPECT_EQ(0, sign);
+    EXPECT_EQ(std::wstring(L"10010000000000000"), std::wstring(buffer));
+}
+
+TEST_F(DoubleToNumberTestFixture, CallerBufferInvalidArgumentTest)
+{
+    // Prepare
+    char buffer[8];
+    int dec = 0;
+    int sign = 0;
+
+    // Act & Assert
+    EXPECT_EQ(ERANGE, _ecvt2_s(buffer, sizeof(buffer), 1.5, 8, &dec, &sign));
+    EXPECT_EQ(0, buffer[0]);
+    EXPECT_EQ(EINVAL, _ecvt2_s(buffer, sizeof(buffer), 1.5, 0, &dec, &sign));
+    EXPECT_EQ(EINVAL, _ecvt2_s((char*)NULL, 0, 1.5, 1, &dec, &sign));
+    EXPECT_EQ(0, _ecvt2_s(buffer, sizeof(buffer), 1.5, 7, &dec, &sign));
+    EXPECT_EQ(std::string("1500000"), std::string(buffer));
+}
+
+TEST_F(DoubleToNumberTestFixture, BigNumMultiplyCarryTest)
+{
+    // Multiplying the numerator by 10 before the heuristic divide shift overflows its
+    // highest block. The carry must not be lost.
+
+    // Prepare
+    char digits[18];
+    int dec = 0;
+    int sign = 0;
+
+    // Act
+    Dragon4Double(116565.35, 17, digits, &dec, &sign);
+
+    // Assert
+    EXPECT_EQ(5, dec);
+    EXPECT_EQ(0, sign);
+    EXPECT_EQ(std::string("11656535000000001"), std::string(digits));
+}
+
+TEST_F(DoubleToNumberTestFixture, BigNumPow10ExtremesTest)
+{
+    // The largest and smallest exponents need the last entries of the power of ten table.
+    struct
+    {
+        double value;
+        int dec;
+        const char* digits;
+    } cases[] =
+    {
+        { 1.7976931348623157e308, 308, "17976931348623157081452742373170435679807056752584" },
+        { 4.9406564584124654e-324, -324, "49406564584124654417656879286822137236505980261432" },
+        { 1e300, 300, "10000000000000000525047602552044202487044685811082" },
+        { 1e-300, -300, "10000000000000000250590918352087596856961468077037" },
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i)
+    {
+        // Prepare
+        char digits[NUMBER_MAXDIGITS + 1];
+        int dec = 0;
+        int sign = 0;
+
+        // Act
+        Dragon4Double(cases[i].value, NUMBER_MAXDIGITS, digits, &dec, &sign);
+
+        // Assert
+        EXPECT_EQ(cases[i].dec, dec);
+        EXPECT_EQ(std::string(cases[i].digits), std::string(digits));
+    }
+}
+
+TEST_F(DoubleToNumberTestFixture, FastPathMatchesBigNumTest)
+{
+    // Every digit count the fast path accepts must produce exactly what the BigNum path produces.
+    std::vector<double> values = randomDoubles(20000);
+    for (int i = 0; i < 20000; ++i)
+    {
+        double value = values[i];
+        if (((FPDOUBLE*)&value)->exp == 0x7FF)
+        {
+            continue;
+        }
+
+        int count = 1 + i % 17;
+        char expected[18];
+        char actual[18];
+        int expectedDec = 0;
+        int actualDec = 0;
+        int expectedSign = 0;
+        int actualSign = 0;
+
+        Dragon4Double(value, count, expected, &expectedDec, &expectedSign);
+        ASSERT_EQ(0, _ecvt2_s(actual, sizeof(actual), value, count, &actualDec, &actualSign));
+
+        ASSERT_EQ(std::string(expected), std::string(actual)) << value;
+        ASSERT_EQ(expectedDec, actualDec) << value;
+        ASSERT_EQ(expectedSign, actualSign) << value;
+    }
+}
+
+TEST_F(DoubleToNumberTestFixture, NativeTiersMatchBigNumTest)
+{
+    // Integers, decimals with a few digits and values of moderate magnitude take the
+    // native integer paths. They must produce exactly what the BigNum path produces, also
+    // for digit counts beyond the Grisu fast path.
+    std::vector<uint64_t> allBits = randomBits(20000);
+    for (int i = 0; i < 20000; ++i)
+    {
+        uint64_t bits = allBits[i];
+        double value = 0;
+        if (i % 3 == 0)
+        {
+            value = (double)(bits >> (bits % 64));
+        }
+        else if (i % 3 == 1)
+        {
+            value = (double)(bits % 100000000) / UINT64_POWERSOFTEN[bits % 9];
+        }
+        else
+        {
+            // Exponents from 2^-40 to 2^70, with up to 52 trailing zero bits.
+            uint64_t valueBits = (bits & 0x800FFFFFFFFFFFFF) | ((uint64_t)(983 + bits % 111) << 52);
+            valueBits &= ~(((uint64_t)1 << (bits >> 58 | (bits & 0x30))) - 1);
+            memcpy(&value, &valueBits, sizeof(value));
+        }
+
+        int count = 1 + i % NUMBER_MAXDIGITS;
+        char expected[NUMBER_MAXDIGITS + 1];
+        char actual[NUMBER_MAXDIGITS + 1];
+        int expectedDec = 0;
+        int actualDec = 0;
+        int expectedCount = 0;
+        int actualCount = 0;
+        int sign = 0;
+
+        Dragon4Double(value, count, expected, &expectedDec, &sign);
+        ASSERT_EQ(0, _ecvt2_s(actual, sizeof(actual), value, count, &actualDec, &sign));
+        ASSERT_EQ(std::string(expected), std::string(actual)) << value;
+        ASSERT_EQ(expectedDec, actualDec) << value;
+
+        int fractionDigits = i % 30;
+        expectedCount = Dragon4DoubleCutoff(value, DRAGON4_CUTOFF_FRACTIONLENGTH, fractionDigits, NUMBER_MAXDIGITS, expected, &expectedDec, &sign);
+        ASSERT_EQ(0, _fcvt2_s(actual, sizeof(actual), value, fractionDigits, &actualCount, &actualDec, &sign));
+        ASSERT_EQ(std::string(expected, expectedCount), std::string(actual, actualCount)) << value;
+        ASSERT_EQ(expectedDec, actualDec) << value;
+
+        expectedCount = Dragon4DoubleShortest(value, expected, &expectedDec, &sign);
+        ASSERT_EQ(0, _ecvt2_shortest_s(actual, sizeof(actual), value, &actualCount, &actualDec, &sign));
+        ASSERT_EQ(std::string(expected), std::string(actual)) << value;
+        ASSERT_EQ(expectedDec, actualDec) << value;
+    }
+}
+
+TEST_F(DoubleToNumberTestFixture, ConversionStatsTest)
+{
+    // With DOUBLETONUMBER_STATS every call is counted for the engine which served it,
+    // without it nothing is counted at all.
+
+    // Prepare
+    char digits[NUMBER_MAXDIGITS + 1];
+    int dec = 0;
+    int sign = 0;
+    ResetConversionStats();
+
+    // Act
+    _ecvt2_s(digits, sizeof(digits), 12345.0, 3, &dec, &sign);
+    _ecvt2_s(digits, sizeof(digits), 0.3, 17, &dec, &sign);
+    _ecvt2_s(digits, sizeof(digits), 1.5, 30, &dec, &sign);
+    _ecvt2_s(digits, sizeof(digits), 0.3, 30, &dec, &sign);
+    _ecvt2_s(digits, sizeof(digits), 5e-324, 30, &dec, &sign);
+
+    ConversionStats stats;
+    GetConversionStats(&stats);
+
+    // Assert
+    uint64_t calls = 0;
+    for (int i = 0; i < CONVERSIONSTATS_BUCKETCOUNT; ++i)
+    {
+        calls += stats.phaseHistograms[CONVERSIONPHASE_CALL][i];
+    }
+
+    if (!stats.isEnabled)
+    {
+        EXPECT_EQ(0u, calls);
+        EXPECT_EQ(0u, stats.engineCalls[CONVERSIONENGINE_BIGNUM]);
+        EXPECT_EQ(0u, stats.maxBigNumLength);
+        return;
+    }
+
+    EXPECT_EQ(5u, calls);
+    EXPECT_EQ(1u, stats.engineCalls[CONVERSIONENGINE_UINT64]);
+    EXPECT_EQ(1u, stats.engineCalls[CONVERSIONENGINE_GRISU]);
+    EXPECT_EQ(1u, stats.engineCalls[CONVERSIONENGINE_NATIVE64]);
+    EXPECT_EQ(1u, stats.engineCalls[CONVERSIONENGINE_NATIVE128]);
+    EXPECT_EQ(1u, stats.engineCalls[CONVERSIONENGINE_BIGNUM]);
+    EXPECT_LT(0u, stats.maxBigNumLength);
+    EXPECT_LT(0u, stats.slowestCallTicks);
+}
+
+TEST_F(DoubleToNumberTestFixture, ShortestSimpleTest)
+{
+    // Prepare
+    NUMBER expected;
+    expected.precision = 1;
+    expected.scale = -1;
+    expected.sign = 0;
+
+    NUMBER expected2;
+    expected2.precision = 9;
+    expected2.scale = 5;
+    expected2.sign = 1;
+
+    // Act
+    NUMBER actual;
+    DoubleToNumber(0.1, 0, DTN_SHORTEST, &actual);
+
+    NUMBER actual2;
+    DoubleToNumber(-123456.789, 0, DTN_SHORTEST, &actual2);
+
+    // Assert
+    DoubleToNumberTestFixture::assertResult(expected, L"1", actual);
+    DoubleToNumberTestFixture::assertResult(expected2, L"123456789", actual2);
+}
+
+TEST_F(DoubleToNumberTestFixture, ShortestExtremeValuesTest)
+{
+    // Prepare
+    NUMBER expected;
+    expected.precision = 17;
+    expected.scale = 308;
+    expected.sign = 0;
+
+    NUMBER expected2;
+    expected2.precision = 1;
+    expected2.scale = -324;
+    expected2.sign = 0;
+
+    NUMBER expected3;
+    expected3.precision = 17;
+    expected3.scale = -308;
+    expected3.sign = 0;
+
+    // Act
+    NUMBER actual;
+    DoubleToNumber(1.7976931348623157e+308, 0, DTN_SHORTEST, &actual);
+
+    NUMBER actual2;
+    DoubleToNumber(pow(0.5, 1074), 0, DTN_SHORTEST, &actual2);
+
+    NUMBER actual3;
+    DoubleToNumber(2.2250738585072014e-308, 0, DTN_SHORTEST, &actual3);
+
+    // Assert
+    DoubleToNumberTestFixture::assertResult(expected, L"17976931348623157", actual);
+    DoubleToNumberTestFixture::assertResult(expected2, L"5", actual2);
+    DoubleToNumberTestFixture::assertResult(expected3, L"22250738585072014", actual3);
+}
+
+TEST_F(DoubleToNumberTestFixture, ShortestUnequalMarginsTest)
+{
+    // For a power of two the lower neighbour is twice as close as the upper one.
+
+    // Prepare
+    NUMBER expected;
+    expected.precision = 16;
+    expected.scale = -14;
+    expected.sign = 0;
+
+    NUMBER expected2;
+    expected2.precision = 16;
+    expected2.scale = 18;
+    expected2.sign = 0;
+
+    // Act
+    NUMBER actual;
+    DoubleToNumber(pow(2.0, -44), 0, DTN_SHORTEST, &actual);
+
+    NUMBER actual2;
+    DoubleToNumber(pow(2.0, 60), 0, DTN_SHORTEST, &actual2);
+
+    // Assert
+    DoubleToNumberTestFixture::assertResult(expected, L"5684341886080802", actual);
+    DoubleToNumberTestFixture::assertResult(expected2, L"1152921504606847", actual2);
+}
+
+TEST_F(DoubleToNumberTestFixture, ShortestBoundaryTest)
+{
+    // 1e23 is not representable. The closest double is below it, but its upper
+    // boundary still reaches 1e23.
+
+    // Prepare
+    NUMBER expected;
+    expected.precision = 1;
+    expected.scale = 23;
+    expected.sign = 0;
+
+    NUMBER expected2;
+    expected2.precision = 1;
+    expected2.scale = 0;
+    expected2.sign = 0;
+
+    // Act
+    NUMBER actual;
+    DoubleToNumber(1e23, 0, DTN_SHORTEST, &actual);
+
+    NUMBER actual2;
+    DoubleToNumber(0.0, 0, DTN_SHORTEST, &actual2);
+
+    // Assert
+    DoubleToNumberTestFixture::assertResult(expected, L"1", actual);
+    DoubleToNumberTestFixture::assertResult(expected2, L"", actual2);
+}
+
+TEST_F(DoubleToNumberTestFixture, FixedSimpleTest)
+{
+    // Prepare
+    NUMBER expected;
+    expected.precision = 6;
+    expected.scale = 3;
+    expected.sign = 0;
+
+    NUMBER expected2;
+    expected2.precision = 2;
+    expected2.scale = -1;
+    expected2.sign = 1;
+
+    NUMBER expected3;
+    expected3.precision = 4;
+    expected3.scale = 1;
+    expected3.sign = 0;
+
+    // Act
+    NUMBER actual;
+    DoubleToNumber(1234.5678, 2, DTN_FIXED, &actual);
+
+    // -0.125 is exactly between -0.12 and -0.13.
+    NUMBER actual2;
+    DoubleToNumber(-0.125, 2, DTN_FIXED, &actual2);
+
+    // Rounding carries into a new integer digit.
+    NUMBER actual3;
+    DoubleToNumber(9.996, 2, DTN_FIXED, &actual3);
+
+    // Assert
+    DoubleToNumberTestFixture::assertResult(expected, L"123457", actual);
+    DoubleToNumberTestFixture::assertResult(expected2, L"12", actual2);
+    DoubleToNumberTestFixture::assertResult(expected3, L"1000", actual3);
+}
+
+TEST_F(DoubleToNumberTestFixture, FixedSmallValuesTest)
+{
+    // Prepare
+    NUMBER expected;
+    expected.precision = 1;
+    expected.scale = -2;
+    expected.sign = 0;
+
+    NUMBER expected2;
+    expected2.precision = 0;
+    expected2.scale = 0;
+    expected2.sign = 0;
+
+    // Act
+    // The double closest to 0.005 is slightly above it, so it rounds up to 0.01.
+    NUMBER actual;
+    DoubleToNumber(0.005, 2, DTN_FIXED, &actual);
+
+    NUMBER actual2;
+    DoubleToNumber(0.0004, 2, DTN_FIXED, &actual2);
+
+    NUMBER actual3;
+    DoubleToNumber(0.0, 2, DTN_FIXED, &actual3);
+
+    // Assert
+    DoubleToNumberTestFixture::assertResult(expected, L"1", actual);
+    DoubleToNumberTestFixture::assertResult(expected2, L"", actual2);
+    DoubleToNumberTestFixture::assertResult(expected2, L"", actual3);
+}
+
+TEST_F(DoubleToNumberTestFixture, FixedLongIntegerPartTest)
+{
+    // The integer part has more digits than NUMBER can hold. The digits are rounded at
+    // NUMBER_MAXDIGITS and the scale tells where the decimal point is.
+
+    // Prepare
+    NUMBER expected;
+    expected.precision = NUMBER_MAXDIGITS;
+    expected.scale = 59;
+    expected.sign = 0;
+
+    // Act
+    NUMBER actual;
+    DoubleToNumber(1e60, 2, DTN_FIXED, &actual);
+
+    // Assert
+    DoubleToNumberTestFixture::assertResult(expected, L"99999999999999994938713529707401886696364501101341", actual);
+}
+
+TEST_F(DoubleToNumberTestFixture, FixedInvalidArgumentTest)
+{
+    // Prepare
+    char buffer[8];
+    int count = 0;
+    int dec = 0;
+    int sign = 0;
+
+    // Act & Assert
+    EXPECT_EQ(EINVAL, _fcvt2_s(buffer, sizeof(buffer), 1.5, -1, &count, &dec, &sign));
+    EXPECT_EQ(EINVAL, _fcvt2_s(buffer, sizeof(buffer), 1.5, DOUBLE_MAXFRACTIONDIGITS + 1, &count, &dec, &sign));
+    EXPECT_EQ(ERANGE, _fcvt2_s(buffer, 1, 1.5, 2, &count, &dec, &sign));
+    EXPECT_EQ(0, _fcvt2_s(buffer, sizeof(buffer), 1.5, 2, &count, &dec, &sign));
+    EXPECT_EQ(3, count);
+    EXPECT_EQ(std::string("150"), std::string(buffer));
+}
+
+TEST_F(DoubleToNumberTestFixture, FloatShortestTest)
+{
+    // Prepare
+    NUMBER expected;
+    expected.precision = 1;
+    expected.scale = -1;
+    expected.sign = 0;
+
+    NUMBER expected2;
+    expected2.precision = 8;
+    expected2.scale = 38;
+    expected2.sign = 1;
+
+    NUMBER expected3;
+    expected3.precision = 1;
+    expected3.scale = -45;
+    expected3.sign = 0;
+
+    // 58120408 lies between 58120404 and 58120412, the upper boundary 58120410 is
+    // included because the mantissa is even.
+    NUMBER expected4;
+    expected4.precision = 7;
+    expected4.scale = 7;
+    expected4.sign = 0;
+
+    // Act
+    NUMBER actual;
+    FloatToNumber(0.1f, 0, DTN_SHORTEST, &actual);
+
+    NUMBER actual2;
+    FloatToNumber(-std::numeric_limits<float>::max(), 0, DTN_SHORTEST, &actual2);
+
+    NUMBER actual3;
+    FloatToNumber(std::numeric_limits<float>::denorm_min(), 0, DTN_SHORTEST, &actual3);
+
+    NUMBER actual4;
+    FloatToNumber(58120408.0f, 0, DTN_SHORTEST, &actual4);
+
+    // Assert
+    DoubleToNumberTestFixture::assertResult(expected, L"1", actual);
+    DoubleToNumberTestFixture::assertResult(expected2, L"34028235", actual2);
+    DoubleToNumberTestFixture::assertResult(expected3, L"1", actual3);
+    DoubleToNumberTestFixture::assertResult(expected4, L"5812041", actual4);
+}
+
+TEST_F(DoubleToNumberTestFixture, FloatMatchesDoubleTest)
+{
+    // Widening a float is exact, so everything but the shortest digits is the same.
+
+    // Prepare
+    std::vector<float> values;
+    values.push_back(0.0f);
+    values.push_back(std::numeric_limits<float>::quiet_NaN());
+    values.push_back(-std::numeric_limits<float>::infinity());
+    values.push_back(16777216.0f);
+    values.push_back(0.0004f);
+    values.push_back(std::numeric_limits<float>::max());
+
+    uint32_t bits = 0x3F800000;
+    for (int i = 0; i < 2000; ++i)
+    {
+        // xorshift32
+        bits ^= bits << 13;
+        bits ^= bits >> 17;
+        bits ^= bits << 5;
+
+        float value = 0;
+        uint32_t finiteBits = bits & 0x7F7FFFFF;
+        memcpy(&value, &finiteBits, sizeof(value));
+        values.push_back(value);
+        values.push_back((float)(bits % 100000000));
+        values.push_back((float)(bits % 100000) / 100);
+    }
+
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        int precision = 1 + (int)(i % NUMBER_MAXDIGITS);
+        int fractionDigits = (int)(i % 12);
+
+        // Act
+        NUMBER actual;
+        FloatToNumber(values[i], precision, &actual);
+
+        NUMBER actual2;
+        FloatToNumber(values[i], fractionDigits, DTN_FIXED, &actual2);
+
+        // Assert
+        NUMBER expected;
+        DoubleToNumber((double)values[i], precision, &expected);
+        DoubleToNumberTestFixture::assertResult(expected, expected.digits, actual);
+
+        NUMBER expected2;
+        DoubleToNumber((double)values[i], fractionDigits, DTN_FIXED, &expected2);
+        DoubleToNumberTestFixture::assertResult(expected2, expected2.digits, actual2);
+    }
+}
+
+#if LDBL_MANT_DIG == 64
+TEST_F(DoubleToNumberTestFixture, LongDoubleExtremeValuesTest)
+{
+    // Prepare
+    NUMBER expected;
+    expected.precision = 1;
+    expected.scale = -4951;
+    expected.sign = 0;
+
+    NUMBER expected2;
+    expected2.precision = 25;
+    expected2.scale = -4951;
+    expected2.sign = 0;
+
+    NUMBER expected3;
+    expected3.precision = 19;
+    expected3.scale = 4932;
+    expected3.sign = 1;
+
+    NUMBER expected4;
+    expected4.precision = 1;
+    expected4.scale = -1;
+    expected4.sign = 0;
+
+    // Act
+    NUMBER actual;
+    LongDoubleToNumber(std::numeric_limits<long double>::denorm_min(), 0, DTN_SHORTEST, &actual);
+
+    NUMBER actual2;
+    LongDoubleToNumber(std::numeric_limits<long double>::denorm_min(), 25, &actual2);
+
+    NUMBER actual3;
+    LongDoubleToNumber(-std::numeric_limits<long double>::max(), 0, DTN_SHORTEST, &actual3);
+
+    NUMBER actual4;
+    LongDoubleToNumber(0.1L, 0, DTN_SHORTEST, &actual4);
+
+    // Assert
+    DoubleToNumberTestFixture::assertResult(expected, L"4", actual);
+    DoubleToNumberTestFixture::assertResult(expected2, L"3645199531882474602528406", actual2);
+    DoubleToNumberTestFixture::assertResult(expected3, L"1189731495357231765", actual3);
+    DoubleToNumberTestFixture::assertResult(expected4, L"1", actual4);
+}
+#endif
+
+#if defined(__SIZEOF_FLOAT128__) && defined(__SIZEOF_INT128__)
+TEST_F(DoubleToNumberTestFixture, Float128ExtremeValuesTest)
+{
+    // Prepare
+    NUMBER expected;
+    expected.precision = 1;
+    expected.scale = -4966;
+    expected.sign = 0;
+
+    NUMBER expected2;
+    expected2.precision = 34;
+    expected2.scale = 4932;
+    expected2.sign = 0;
+
+    // The smallest subnormal and the largest finite value.
+    uint64_t minBits[2] = { 1, 0 };
+    uint64_t maxBits[2] = { 0xFFFFFFFFFFFFFFFF, 0x7FFEFFFFFFFFFFFF };
+    __float128 minValue = 0;
+    __float128 maxValue = 0;
+    memcpy(&minValue, minBits, sizeof(minValue));
+    memcpy(&maxValue, maxBits, sizeof(maxValue));
+
+    // Act
+    NUMBER actual;
+    Float128ToNumber(minValue, 0, DTN_SHORTEST, &actual);
+
+    NUMBER actual2;
+    Float128ToNumber(maxValue, 0, DTN_SHORTEST, &actual2);
+
+    // Assert
+    DoubleToNumberTestFixture::assertResult(expected, L"6", actual);
+    DoubleToNumberTestFixture::assertResult(expected2, L"1189731495357231765085759326628007", actual2);
+
+    // Widening a double is exact, so its digits are the same as DoubleToNumber's.
+    const double values[] = { 0.1, -1e300, 4.9406564584124654e-324, 123456789.0 };
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i)
+    {
+        NUMBER expected3;
+        DoubleToNumber(values[i], 40, &expected3);
+
+        NUMBER actual3;
+        Float128ToNumber((__float128)values[i], 40, &actual3);
+        DoubleToNumberTestFixture::assertResult(expected3, expected3.digits, actual3);
+
+        NUMBER actual4;
+        LongDoubleToNumber((long double)values[i], 40, &actual4);
+        DoubleToNumberTestFixture::assertResult(expected3, expected3.digits, actual4);
+    }
+}
+#endif
+
+// Runs DoubleToChars into a large buffer and returns the text, or "ERANGE".
+static std::string charsToString(double value, int format, int precision)
+{
+    char buffer[1500];
+    DoubleToCharsResult<char> result = format == 0
+        ? DoubleToChars(buffer, buffer + sizeof(buffer), value)
+        : precision < 0
+        ? DoubleToChars(buffer, buffer + sizeof(buffer), value, (CharsFormat)format)
+        : DoubleToChars(buffer, buffer + sizeof(buffer), value, (CharsFormat)format, precision);
+
+    return result.ec == 0 ? std::string(buffer, result.ptr) : std::string("ERANGE");
+}
+
+TEST_F(DoubleToNumberTestFixture, CharsShortestTest)
+{
+    // Act & Assert
+    EXPECT_EQ("0.1", charsToString(0.1, 0, -1));
+    EXPECT_EQ("1e+21", charsToString(1e21, 0, -1));
+    EXPECT_EQ("123456.789", charsToString(123456.789, 0, -1));
+    EXPECT_EQ("-0", charsToString(-0.0, 0, -1));
+    EXPECT_EQ("5e-324", charsToString(4.9406564584124654e-324, 0, -1));
+    EXPECT_EQ("1.7976931348623157e+308", charsToString(1.7976931348623157e308, 0, -1));
+
+    EXPECT_EQ("1.23456789e+05", charsToString(123456.789, CHARS_FORMAT_SCIENTIFIC, -1));
+    EXPECT_EQ("0e+00", charsToString(0.0, CHARS_FORMAT_SCIENTIFIC, -1));
+    EXPECT_EQ("0.0001", charsToString(1e-4, CHARS_FORMAT_FIXED, -1));
+
+    // Integers are printed with their exact digits rather than the shortest digits padded
+    // with zeros.
+    EXPECT_EQ("1000000000000000000000", charsToString(1e21, CHARS_FORMAT_FIXED, -1));
+    EXPECT_EQ("9999999999999999583119736832", charsToString(1e28, CHARS_FORMAT_FIXED, -1));
+
+    // %g style: scientific unless the exponent is in [-4, 6).
+    EXPECT_EQ("0.0001", charsToString(1e-4, CHARS_FORMAT_GENERAL, -1));
+    EXPECT_EQ("100000", charsToString(1e5, CHARS_FORMAT_GENERAL, -1));
+    EXPECT_EQ("1e+06", charsToString(1e6, CHARS_FORMAT_GENERAL, -1));
+    EXPECT_EQ("1.2345e-05", charsToString(1.2345e-5, CHARS_FORMAT_GENERAL, -1));
+
+    EXPECT_EQ("inf", charsToString(std::numeric_limits<double>::infinity(), 0, -1));
+    EXPECT_EQ("-inf", charsToString(-std::numeric_limits<double>::infinity(), CHARS_FORMAT_FIXED, 2));
+    EXPECT_EQ("nan", charsToString(std::numeric_limits<double>::quiet_NaN(), CHARS_FORMAT_SCIENTIFIC, -1));
+}
+
+TEST_F(DoubleToNumberTestFixture, CharsPrecisionMatchesPrintfTest)
+{
+    const char* printfFormats[] = { "%.*e", "%.*f", "%.*g" };
+    const CharsFormat formats[] = { CHARS_FORMAT_SCIENTIFIC, CHARS_FORMAT_FIXED, CHARS_FORMAT_GENERAL };
+
+    std::vector<uint64_t> allBits = randomBits(3000);
+    for (int i = 0; i < 3000; ++i)
+    {
+        // Prepare
+        uint64_t bits = allBits[i];
+        double value = 0;
+        memcpy(&value, &bits, sizeof(value));
+        if (i % 2 == 1)
+        {
+            value = (double)(int64_t)(bits % 2000000 - 1000000) / 1000;
+        }
+
+        int precision = (int)(bits >> 58) % 25;
+        for (int j = 0; j < 3; ++j)
+        {
+            char expected[1500];
+            snprintf(expected, sizeof(expected), printfFormats[j], precision, value);
+
+            // Act & Assert
+            EXPECT_EQ(std::string(expected), charsToString(value, formats[j], precision));
+        }
+    }
+
+    EXPECT_EQ("0.000000", charsToString(0.0, CHARS_FORMAT_FIXED, 6));
+    EXPECT_EQ("0", charsToString(0.0, CHARS_FORMAT_GENERAL, 0));
+    EXPECT_EQ("0.00e+00", charsToString(0.0, CHARS_FORMAT_SCIENTIFIC, 2));
+    EXPECT_EQ("-0.00", charsToString(-0.001, CHARS_FORMAT_FIXED, 2));
+    EXPECT_EQ("1.000e+100", charsToString(1e100, CHARS_FORMAT_SCIENTIFIC, 3));
+}
+
+TEST_F(DoubleToNumberTestFixture, CharsWideTest)
+{
+    // Prepare
+    char16_t buffer16[32];
+    wchar_t wideBuffer[32];
+
+    // Act
+    DoubleToCharsResult<char16_t> result16 = DoubleToChars(buffer16, buffer16 + 32, -2.5e-7, CHARS_FORMAT_SCIENTIFIC, 3);
+    DoubleToCharsResult<wchar_t> wideResult = DoubleToChars(wideBuffer, wideBuffer + 32, 1234.5);
+
+    // Assert
+    EXPECT_EQ(0, result16.ec);
+    EXPECT_EQ(std::u16string(u"-2.500e-07"), std::u16string(buffer16, result16.ptr));
+    EXPECT_EQ(0, wideResult.ec);
+    EXPECT_EQ(std::wstring(L"1234.5"), std::wstring(wideBuffer, wideResult.ptr));
+}
+
+TEST_F(DoubleToNumberTestFixture, CharsRangeTooSmallTest)
+{
+    // Prepare
+    char buffer[400];
+
+    // Act & Assert
+    // The exact length fits, one less does not. Nothing is written past the end.
+    for (size_t length = 0; length <= 6; ++length)
+    {
+        memset(buffer, 'x', sizeof(buffer));
+        DoubleToCharsResult<char> result = DoubleToChars(buffer, buffer + length, -1.25, CHARS_FORMAT_FIXED, 2);
+        EXPECT_EQ(length < 5 ? ERANGE : 0, result.ec);
+        EXPECT_EQ(length < 5 ? buffer + length : buffer + 5, result.ptr);
+        EXPECT_EQ('x', buffer[length]);
+    }
+
+    // The 309 digits of the largest double fit into a range of exactly their length.
+    DoubleToCharsResult<char> result = DoubleToChars(buffer, buffer + 309, 1.7976931348623157e308, CHARS_FORMAT_FIXED, 0);
+    EXPECT_EQ(0, result.ec);
+    EXPECT_EQ(buffer + 309, result.ptr);
+    EXPECT_EQ(ERANGE, DoubleToChars(buffer, buffer + 308, 1.7976931348623157e308, CHARS_FORMAT_FIXED, 0).ec);
+}
+
+// Reads everything written to the file so far.
+static std::string readFile(FILE* file)
+{
+    std::string text;
+    rewind(file);
+
+    char buffer[4096];
+    size_t length = 0;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        text.append(buffer, length);
+    }
+
+    return text;
+}
+
+TEST_F(DoubleToNumberTestFixture, StreamWriterCsvJsonTest)
+{
+    // Prepare
+    FILE* file = tmpfile();
+    ASSERT_TRUE(file != NULL);
+
+    const double row[] = { 1.5, -0.1, 1e21, std::numeric_limits<double>::quiet_NaN() };
+    const double array[] = { 0.25, std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity() };
+
+    // Act
+    {
+        DoubleStreamWriter writer(fileno(file));
+        writer.writeRow(row, 4);
+        writer.writeRow(row, 2, ';');
+        writer.writeRow(row, 0);
+
+        writer.setNonFinite(DOUBLESTREAM_NONFINITE_NULL);
+        writer.writeJsonArray(array, 3);
+        writer.writeChar('\n');
+
+        writer.setNonFinite(DOUBLESTREAM_NONFINITE_QUOTED);
+        writer.writeJsonArray(array, 3);
+        writer.writeJsonArray(array, 0);
+        writer.writeChar('\n');
+
+        EXPECT_EQ(0, writer.setPrecision(17));
+        EXPECT_EQ(EINVAL, writer.setPrecision(NUMBER_MAXDIGITS + 1));
+        writer.writeDouble(0.1);
+        writer.writeString(" end", 4);
+        EXPECT_EQ(0, writer.flush());
+    }
+
+    // Assert
+    EXPECT_EQ(
+        "1.5,-0.1,1e+21,nan\n"
+        "1.5;-0.1\n"
+        "\n"
+        "[0.25,null,null]\n"
+        "[0.25,\"Infinity\",\"-Infinity\"][]\n"
+        "0.10000000000000001 end",
+        readFile(file));
+
+    fclose(file);
+}
+
+TEST_F(DoubleToNumberTestFixture, StreamWriterRoundTripTest)
+{
+    // Prepare
+    FILE* file = tmpfile();
+    ASSERT_TRUE(file != NULL);
+
+    std::vector<uint64_t> bits = randomBits(10000);
+    std::vector<double> values(bits.size());
+    for (size_t i = 0; i < bits.size(); ++i)
+    {
+        uint64_t finiteBits = bits[i] & 0xFFEFFFFFFFFFFFFF;
+        memcpy(&values[i], &finiteBits, sizeof(double));
+    }
+
+    // Act
+    // A tiny buffer, so that the writer flushes after every few values.
+    {
+        DoubleStreamWriter writer(fileno(file), 100);
+        writer.writeRow(values.data(), values.size());
+        writer.setPrecision(17);
+        writer.writeRow(values.data(), values.size(), '\t');
+    }
+
+    // Assert
+    std::string text = readFile(file);
+    const char* pCurrent = text.c_str();
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            char* pEnd = NULL;
+            EXPECT_EQ(values[i], strtod(pCurrent, &pEnd));
+            EXPECT_EQ(i + 1 < values.size() ? (pass == 0 ? ',' : '\t') : '\n', *pEnd);
+            pCurrent = pEnd + 1;
+        }
+    }
+
+    EXPECT_EQ('\0', *pCurrent);
+
+    fclose(file);
+}
+
+TEST_F(DoubleToNumberTestFixture, BatchMatchesSingleTest)
+{
+    // Prepare
+    std::vector<double> values;
+    values.push_back(0.0);
+    values.push_back(-0.0);
+    values.push_back(std::numeric_limits<double>::quiet_NaN());
+    values.push_back(-std::numeric_limits<double>::infinity());
+    values.push_back(1.0);
+    values.push_back(-42.0);
+    values.push_back(9007199254740993.0);
+    values.push_back(18446744073709549568.0);
+    values.push_back(18446744073709551616.0);
+    values.push_back(0.5);
+    values.push_back(1e300);
+    appendValues(&values, randomDoubles(2000));
+    appendValues(&values, randomIntegers(2000));
+    appendValues(&values, randomPrices(2000, 100000));
+
+    for (int precision = 1; precision <= 20; precision += 3)
+    {
+        // Act
+        std::vector<NUMBER> actual(values.size());
+        DoubleToNumberBatch(values.data(), values.size(), precision, actual.data());
+
+        // Assert
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            NUMBER expected;
+            DoubleToNumber(values[i], precision, &expected);
+            DoubleToNumberTestFixture::assertResult(expected, expected.digits, actual[i]);
+        }
+    }
+}
+
+TEST_F(DoubleToNumberTestFixture, BatchPackedTest)
+{
+    // Prepare
+    const double values[] = { 123456789.0, -0.84551240822557006, 0.0, std::numeric_limits<double>::infinity(), 2.5 };
+    const size_t count = sizeof(values) / sizeof(values[0]);
+    char digits[count * 3];
+    int scales[count];
+    int signs[count];
+    NUMBER zero;
+    DoubleToNumber(0.0, 3, &zero);
+
+    // Act
+    DoubleToDigitsBatch(values, count, 3, digits, scales, signs);
+
+    // Assert
+    EXPECT_EQ(std::string("123846000000250"), std::string(digits, sizeof(digits)));
+    EXPECT_EQ(8, scales[0]);
+    EXPECT_EQ(-1, scales[1]);
+    EXPECT_EQ(zero.scale, scales[2]);
+    EXPECT_EQ((int)SCALE_INF, scales[3]);
+    EXPECT_EQ(0, scales[4]);
+    EXPECT_EQ(0, signs[0]);
+    EXPECT_EQ(1, signs[1]);
+}
+
+// The decimal digits of the integer in `words`, least significant word first.
+static std::string wordsToString(std::vector<uint32_t> words)
+{
+    std::string text;
+    for (;;)
+    {
+        uint64_t remainder = 0;
+        bool isZero = true;
+        for (size_t i = words.size(); i-- > 0;)
+        {
+            uint64_t dividend = (remainder << 32) | words[i];
+            words[i] = (uint32_t)(dividend / 10);
+            remainder = dividend % 10;
+            isZero = isZero && words[i] == 0;
+        }
+
+        text.insert(text.begin(), (char)('0' + remainder));
+        if (isZero)
+        {
+            return text;
+        }
+    }
+}
+
+// The `count` digits of the engines, with the exponent of the first one in `dec`, as a
+// coefficient without trailing zeros and the exponent of its last digit.
+static std::string digitsToCoefficient(const char* digits, int count, int dec, int* pExponent10)
+{
+    std::string coefficient(digits, count);
+    *pExponent10 = dec - count + 1;
+    while (!coefficient.empty() && coefficient[coefficient.size() - 1] == '0')
+    {
+        coefficient.erase(coefficient.size() - 1);
+        *pExponent10 += 1;
+    }
+
+    if (coefficient.empty())
+    {
+        *pExponent10 = 0;
+        return "0";
+    }
+
+    return coefficient;
+}
+
+static std::vector<double> decimalTestValues()
+{
+    std::vector<double> values;
+    const double specials[] = { 0.0, -0.0, 0.1, -2.5, 1.0 / 3, 123.456, 99.995, 9.5, 1e22, 9223372036854775808.0,
+        1180591620717411303424.0, 7.9e28, 7.922816251426434e28, 8e28, 1e-28, 5e-29, 5.04e-29, 5.5e-29, 6e-29, 9.9e-29, 4e-29, 5e-324, 1.7976931348623157e308 };
+    values.assign(specials, specials + sizeof(specials) / sizeof(specials[0]));
+
+    std::vector<uint64_t> bits = DoubleToNumberTestFixture::randomBits(1000);
+    for (size_t i = 0; i < bits.size(); ++i)
+    {
+        double value = 0;
+        uint64_t moderateBits = (bits[i] & 0x800FFFFFFFFFFFFF) | ((uint64_t)(930 + (bits[i] >> 52) % 200) << 52);
+        memcpy(&value, &moderateBits, sizeof(value));
+        values.push_back(value);
+    }
+
+    DoubleToNumberTestFixture::appendValues(&values, DoubleToNumberTestFixture::randomDoubles(1000));
+    DoubleToNumberTestFixture::appendValues(&values, DoubleToNumberTestFixture::randomPrices(1000, 10000000));
+    DoubleToNumberTestFixture::appendValues(&values, DoubleToNumberTestFixture::randomIntegers(1000));
+
+    return values;
+}
+
+TEST_F(DoubleToNumberTestFixture, DecimalMatchesFcvtTest)
+{
+    // Prepare
+    std::vector<double> values = decimalTestValues();
+    const int precisions[] = { 1, 7, 15, 17, 28, 29 };
+    const std::string maxCoefficient = "79228162514264337593543950335";
+
+    for (size_t p = 0; p < sizeof(precisions) / sizeof(precisions[0]); ++p)
+    {
+        int precision = precisions[p];
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            if (!std::isfinite(values[i]))
+            {
+                continue;
+            }
+
+            char digits[DECIMAL96_MAXDIGITS + 1];
+            int count = 0;
+            int dec = 0;
+            int sign = 0;
+            _fcvt2_s(digits, precision + 1, values[i], DECIMAL96_MAXSCALE, &count, &dec, &sign);
+            int exponent10 = 0;
+            std::string expected = digitsToCoefficient(digits, count, dec, &exponent10);
+            for (; exponent10 > 0; --exponent10)
+            {
+                expected += '0';
+            }
+
+            bool isOverflow = expected.size() > maxCoefficient.size() || (expected.size() == maxCoefficient.size() && expected > maxCoefficient);
+
+            // Act
+            DECIMAL96 decimal;
+            int result = DoubleToDecimal(values[i], precision, &decimal);
+
+            // Assert
+            if (isOverflow)
+            {
+                ASSERT_EQ(ERANGE, result) << values[i];
+                continue;
+            }
+
+            ASSERT_EQ(0, result) << values[i];
+            std::vector<uint32_t> words;
+            words.push_back(decimal.lo);
+            words.push_back(decimal.mid);
+            words.push_back(decimal.hi);
+            ASSERT_EQ(expected, wordsToString(words)) << values[i] << " " << precision;
+            ASSERT_EQ(-exponent10, decimal.scale) << values[i];
+            ASSERT_EQ(sign, decimal.sign) << values[i];
+        }
+    }
+}
+
+TEST_F(DoubleToNumberTestFixture, Decimal128MatchesEcvtTest)
+{
+    // Prepare
+    std::vector<double> values = decimalTestValues();
+    const int precisions[] = { 1, 15, 17, 25, 34 };
+
+    for (size_t p = 0; p < sizeof(precisions) / sizeof(precisions[0]); ++p)
+    {
+        int precision = precisions[p];
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            if (!std::isfinite(values[i]))
+            {
+                continue;
+            }
+
+            char digits[DECIMAL128_MAXDIGITS + 1];
+            int dec = 0;
+            int sign = 0;
+            _ecvt2_s(digits, precision + 1, values[i], precision, &dec, &sign);
+            int exponent10 = 0;
+            std::string expected = values[i] == 0 ? "0" : digitsToCoefficient(digits, precision, dec, &exponent10);
+
+            // Act
+            DECIMAL128 decimal = {};
+            int result = DoubleToDecimal128(values[i], precision, &decimal);
+
+            // Assert
+            ASSERT_EQ(0, result);
+            std::vector<uint32_t> words;
+            words.push_back((uint32_t)decimal.low);
+            words.push_back((uint32_t)(decimal.low >> 32));
+            words.push_back((uint32_t)decimal.high);
+            words.push_back((uint32_t)(decimal.high >> 32) & 0x1FFFF);
+            ASSERT_EQ(expected, wordsToString(words)) << values[i] << " " << precision;
+            ASSERT_EQ(exponent10, (int)((decimal.high >> 49) & 0x3FFF) - DECIMAL128_EXPONENTBIAS) << values[i];
+            ASSERT_EQ((uint64_t)sign, decimal.high >> 63) << values[i];
+        }
+    }
+}
+
+TEST_F(DoubleToNumberTestFixture, DecimalSpecialValuesTest)
+{
+    // Prepare
+    DECIMAL96 decimal;
+    DECIMAL128 decimal128 = {};
+
+    // Act
+    int result = DoubleToDecimal(-0.1, 15, &decimal);
+
+    // Assert
+    EXPECT_EQ(0, result);
+    EXPECT_EQ(1u, decimal.lo);
+    EXPECT_EQ(0u, decimal.mid);
+    EXPECT_EQ(0u, decimal.hi);
+    EXPECT_EQ(1, decimal.scale);
+    EXPECT_EQ(1, decimal.sign);
+    EXPECT_EQ(EINVAL, DoubleToDecimal(std::numeric_limits<double>::quiet_NaN(), 15, &decimal));
+    EXPECT_EQ(ERANGE, DoubleToDecimal(std::numeric_limits<double>::infinity(), 15, &decimal));
+    EXPECT_EQ(EINVAL, DoubleToDecimal(1.0, 0, &decimal));
+    EXPECT_EQ(EINVAL, DoubleToDecimal128(1.0, DECIMAL128_MAXDIGITS + 1, &decimal128));
+
+    EXPECT_EQ(0, DoubleToDecimal128(1.0, 34, &decimal128));
+    EXPECT_EQ(0x3040000000000000ull, decimal128.high);
+    EXPECT_EQ(1ull, decimal128.low);
+    EXPECT_EQ(0, DoubleToDecimal128(-std::numeric_limits<double>::infinity(), 34, &decimal128));
+    EXPECT_EQ(0xF800000000000000ull, decimal128.high);
+    EXPECT_EQ(0, DoubleToDecimal128(std::numeric_limits<double>::quiet_NaN(), 34, &decimal128));
+    EXPECT_EQ(0x7C00000000000000ull, decimal128.high);
+}
+
+static std::string formatToString(const DoubleFormat& plan, double value)
+{
+    char text[DOUBLEFORMAT_FIXEDDIGITSSIZE + 512];
+    DoubleToCharsResult<char> result = plan.format(text, text + sizeof(text), value);
+    EXPECT_EQ(0, result.ec);
+    EXPECT_LE((size_t)(result.ptr - text), plan.maxLength());
+    return std::string(text, result.ptr);
+}
+
+static std::string formatToString(const char* format, double value)
+{
+    DoubleFormat plan;
+    EXPECT_EQ(0, plan.compile(format));
+    return formatToString(plan, value);
+}
+
+// printf's %E with at least 3 exponent digits, like .NET's E format.
+static std::string printfScientific(int precision, double value)
+{
+    char text[128];
+    snprintf(text, sizeof(text), "%.*E", precision, value);
+    std::string result(text);
+    size_t exponentDigits = result.size() - result.find('E') - 2;
+    if (exponentDigits < 3)
+    {
+        result.insert(result.find('E') + 2, 3 - exponentDigits, '0');
+    }
+
+    return result;
+}
+
+TEST_F(DoubleToNumberTestFixture, FormatMatchesPrintfTest)
+{
+    // Prepare
+    std::vector<double> values = decimalTestValues();
+    values.push_back(1.7976931348623157e308);
+    values.push_back(4.9e-324);
+    values.push_back(123456789012345678.0);
+    values.push_back(-0.0);
+
+    const int fixedPrecisions[] = { 0, 2, 6, 20 };
+    const int scientificPrecisions[] = { 0, 3, 10, 16 };
+    const int generalPrecisions[] = { 1, 6, 15, 17 };
+    DoubleFormat fixedPlans[4];
+    DoubleFormat scientificPlans[4];
+    DoubleFormat generalPlans[4];
+    for (int p = 0; p < 4; ++p)
+    {
+        char format[16];
+        snprintf(format, sizeof(format), "F%d", fixedPrecisions[p]);
+        ASSERT_EQ(0, fixedPlans[p].compile(format));
+        snprintf(format, sizeof(format), "E%d", scientificPrecisions[p]);
+        ASSERT_EQ(0, scientificPlans[p].compile(format));
+        snprintf(format, sizeof(format), "G%d", generalPrecisions[p]);
+        ASSERT_EQ(0, generalPlans[p].compile(format));
+    }
+
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        // printf writes NaN and infinity differently.
+        if (values[i] != values[i] || values[i] - values[i] != 0)
+        {
+            continue;
+        }
+
+        for (int p = 0; p < 4; ++p)
+        {
+            // Act
+            std::string fixed = formatToString(fixedPlans[p], values[i]);
+            std::string scientific = formatToString(scientificPlans[p], values[i]);
+            std::string general = formatToString(generalPlans[p], values[i]);
+
+            NUMBER number;
+            DoubleToNumber(values[i], generalPlans[p].numberPrecision(), generalPlans[p].numberMode(), &number);
+            char text[128];
+            DoubleToCharsResult<char> result = generalPlans[p].format(text, text + sizeof(text), number);
+
+            // Assert
+            char expected[2048];
+            snprintf(expected, sizeof(expected), "%.*f", fixedPrecisions[p], values[i]);
+            EXPECT_EQ(std::string(expected), fixed);
+            EXPECT_EQ(printfScientific(scientificPrecisions[p], values[i]), scientific);
+            snprintf(expected, sizeof(expected), "%.*G", generalPrecisions[p], values[i]);
+            EXPECT_EQ(std::string(expected), general);
+            EXPECT_EQ(general, std::string(text, result.ptr));
+        }
+    }
+}
+
+TEST_F(DoubleToNumberTestFixture, FormatLayoutTest)
+{
+    // Prepare
+    NumberFormatSymbols symbols = GetInvariantNumberFormatSymbols();
+    symbols.decimalSeparator = ",";
+    symbols.groupSeparator = ".";
+    symbols.currencySymbol = "EUR ";
+    DoubleFormat custom;
+    DoubleFormat plan;
+    char text[8];
+
+    // Act
+    int result = custom.compile("C", symbols);
+
+    // Assert
+    EXPECT_EQ(0, result);
+    EXPECT_EQ("(EUR 1.234.567,89)", formatToString(custom, -1234567.891));
+    EXPECT_EQ("1,234,567.89", formatToString("N2", 1234567.891));
+    EXPECT_EQ("-0.00", formatToString("N", -0.001));
+    EXPECT_EQ("999.0", formatToString("n1", 999.0));
+    EXPECT_EQ("\xC2\xA4" "1,000.00", formatToString("C", 1000.0));
+    EXPECT_EQ("12.3 %", formatToString("P1", 0.1234));
+    EXPECT_EQ("-50 %", formatToString("P0", -0.5));
+    EXPECT_EQ("1,234,567.00 %", formatToString("P", 12345.67));
+    EXPECT_EQ("2", formatToString("F0", 2.5));
+    EXPECT_EQ("1.235E+003", formatToString("E3", 1234.5678));
+    EXPECT_EQ("-1.000000e-300", formatToString("e", -1e-300));
+    EXPECT_EQ("0.000000E+000", formatToString("E", 0.0));
+    EXPECT_EQ("0.1", formatToString("R", 0.1));
+    EXPECT_EQ("0.10000000000000001", formatToString("G17", 0.1));
+    EXPECT_EQ("100000000000000", formatToString("G", 1e14));
+    EXPECT_EQ("1E+15", formatToString("G", 1e15));
+    EXPECT_EQ("12345678901234568", formatToString("G", 12345678901234567.0));
+    EXPECT_EQ("0.0001", formatToString("G", 0.0001));
+    EXPECT_EQ("1e-05", formatToString("g", 0.00001));
+    EXPECT_EQ("-0", formatToString("G", -0.0));
+    EXPECT_EQ("NaN", formatToString("F2", std::numeric_limits<double>::quiet_NaN()));
+    EXPECT_EQ("-Infinity", formatToString("N", -std::numeric_limits<double>::infinity()));
+
+    EXPECT_EQ(EINVAL, plan.compile("X"));
+    EXPECT_EQ(EINVAL, plan.compile("F2x"));
+    EXPECT_EQ(EINVAL, plan.compile("G51"));
+    EXPECT_EQ(EINVAL, plan.compile("E50"));
+    EXPECT_EQ(EINVAL, plan.compile("P1073"));
+    EXPECT_EQ(0, plan.compile("F1074"));
+    EXPECT_EQ(DTN_FIXED, plan.numberMode());
+    EXPECT_EQ(1074, plan.numberPrecision());
+    EXPECT_EQ(ERANGE, plan.format(text, text + sizeof(text), 123456.0).ec);
+    EXPECT_EQ(0, plan.compile(NULL));
+    EXPECT_EQ(DTN_SHORTEST, plan.numberMode());
+    EXPECT_EQ(ERANGE, plan.format(text, text + 2, 123.0).ec);
+    EXPECT_EQ("123", std::string(text, plan.format(text, text + 3, 123.0).ptr));
+}
+
+TEST_F(DoubleToNumberTestFixture, ColumnsMatchSingleTest)
+{
+    // Prepare
+    std::vector<double> values;
+    values.push_back(0.0);
+    values.push_back(-0.0);
+    values.push_back(std::numeric_limits<double>::quiet_NaN());
+    values.push_back(-std::numeric_limits<double>::infinity());
+    values.push_back(1.0);
+    values.push_back(-42.0);
+    values.push_back(18446744073709551616.0);
+    values.push_back(0.0001);
+    appendValues(&values, randomDoubles(600));
+    appendValues(&values, randomIntegers(600));
+
+    // Every third value is null.
+    std::vector<uint8_t> validity((values.size() + 7) / 8);
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        if (i % 3 != 2)
+        {
+            validity[i / 8] |= (uint8_t)(1 << (i % 8));
+        }
+    }
+
+    const struct
+    {
+        DoubleToNumberMode mode;
+        int precision;
+    } modes[] =
+    {
+        { DTN_PRECISION, 1 }, { DTN_PRECISION, 17 }, { DTN_PRECISION, 25 }, { DTN_SHORTEST, 0 }, { DTN_FIXED, 3 },
+    };
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m)
+    {
+        for (int hasValidity = 0; hasValidity < 2; ++hasValidity)
+        {
+            // Act
+            std::vector<char> digits(DoubleToNumberColumnsCapacity(values.size(), modes[m].precision, modes[m].mode));
+            std::vector<int32_t> offsets(values.size() + 1);
+            std::vector<int> scales(values.size());
+            std::vector<uint8_t> signs(values.size());
+            std::vector<int> precisions(values.size());
+            NumberColumns columns = { digits.data(), offsets.data(), scales.data(), signs.data(), precisions.data() };
+            int result = DoubleToNumberColumns(values.data(), hasValidity ? validity.data() : NULL, values.size(), modes[m].precision, modes[m].mode, columns);
+
+            // Assert
+            ASSERT_EQ(0, result);
+            for (size_t i = 0; i < values.size(); ++i)
+            {
+                std::string actualDigits(digits.data() + offsets[i], digits.data() + offsets[i + 1]);
+                if (hasValidity && i % 3 == 2)
+                {
+                    ASSERT_EQ(std::string(), actualDigits);
+                    ASSERT_EQ(0, scales[i]);
+                    ASSERT_EQ(0, signs[i]);
+                    ASSERT_EQ(0, precisions[i]);
+                    continue;
+                }
+
+                NUMBER expected;
+                DoubleToNumber(values[i], modes[m].precision, modes[m].mode, &expected);
+                ASSERT_EQ(expected.precision, precisions[i]) << values[i];
+                ASSERT_EQ(expected.scale, scales[i]) << values[i];
+                ASSERT_EQ(expected.sign, signs[i]) << values[i];
+                ASSERT_EQ(std::wstring(expected.digits), std::wstring(actualDigits.begin(), actualDigits.end())) << values[i];
+            }
+        }
+    }
+}
+
+TEST_F(DoubleToNumberTestFixture, ColumnsOffsetLimitTest)
+{
+    // Prepare
+    // The arguments are checked before anything is read or written, so the columns can
+    // stay empty for the counts which are refused.
+    double values[1] = { 1.0 };
+    char digits[51];
+    int32_t offsets[2];
+    int scales[1];
+    uint8_t signs[1];
+    int precisions[1];
+    NumberColumns columns = { digits, offsets, scales, signs, precisions };
+    NumberColumns emptyColumns = { NULL, NULL, NULL, NULL, NULL };
+    size_t maxCount = (size_t)INT32_MAX / NUMBER_MAXDIGITS;
+
+    // Act & Assert
+    EXPECT_EQ(0, DoubleToNumberColumns(values, NULL, 1, NUMBER_MAXDIGITS, DTN_PRECISION, columns));
+    EXPECT_EQ(0, offsets[0]);
+    EXPECT_EQ(NUMBER_MAXDIGITS, offsets[1]);
+    EXPECT_EQ(ERANGE, DoubleToNumberColumns(values, NULL, maxCount + 1, NUMBER_MAXDIGITS, DTN_PRECISION, emptyColumns));
+    EXPECT_LE(DoubleToNumberColumnsCapacity(maxCount, NUMBER_MAXDIGITS, DTN_PRECISION) - 1, (size_t)INT32_MAX);
+    EXPECT_GT(DoubleToNumberColumnsCapacity(maxCount + 1, NUMBER_MAXDIGITS, DTN_PRECISION) - 1, (size_t)INT32_MAX);
+    EXPECT_EQ(ERANGE, DoubleToNumberColumns(values, NULL, (size_t)INT32_MAX / DOUBLE_SHORTEST_MAXDIGITS + 1, 0, DTN_SHORTEST, emptyColumns));
+    EXPECT_EQ(ERANGE, DoubleToNumberColumns(values, NULL, SIZE_MAX, 3, DTN_FIXED, emptyColumns));
+    EXPECT_EQ(EINVAL, DoubleToNumberColumns(values, NULL, 1, 0, DTN_PRECISION, columns));
+}
+
+TEST_F(DoubleToNumberTestFixture, PackedNumberRoundTripTest)
+{
+    // Prepare
+    std::vector<double> values;
+    values.push_back(0.0);
+    values.push_back(-0.0);
+    values.push_back(std::numeric_limits<double>::quiet_NaN());
+    values.push_back(-std::numeric_limits<double>::infinity());
+    values.push_back(1.0);
+    values.push_back(100.0);
+    values.push_back(5e-324);
+    values.push_back(1.7976931348623157e308);
+    appendValues(&values, randomDoubles(500));
+    appendValues(&values, randomPrices(500, 100000));
+
+    const struct
+    {
+        DoubleToNumberMode mode;
+        int precision;
+    } modes[] =
+    {
+        { DTN_PRECISION, 1 }, { DTN_PRECISION, 17 }, { DTN_PRECISION, 22 }, { DTN_PRECISION, 30 },
+        { DTN_SHORTEST, 0 }, { DTN_FIXED, 2 }, { DTN_FIXED, 20 },
+    };
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m)
+    {
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            // Act
+            NUMBER expected;
+            DoubleToNumber(values[i], modes[m].precision, modes[m].mode, &expected);
+            PACKEDNUMBER packed;
+            bool isPacked = PackNumber(expected, &packed);
+            PACKEDNUMBER direct;
+            bool isDirect = DoubleToPackedNumber(values[i], modes[m].precision, modes[m].mode, &direct);
+
+            // Assert
+            ASSERT_EQ(isPacked, isDirect) << values[i];
+            if (modes[m].mode != DTN_FIXED && modes[m].precision <= DOUBLE_SHORTEST_MAXDIGITS)
+            {
+                ASSERT_TRUE(isPacked) << values[i];
+            }
+
+            if (isPacked)
+            {
+                ASSERT_EQ(0, memcmp(&packed, &direct, sizeof(packed))) << values[i];
+                NUMBER actual;
+                UnpackNumber(packed, &actual);
+                ASSERT_EQ(expected.precision, actual.precision) << values[i];
+                ASSERT_EQ(expected.scale, actual.scale) << values[i];
+                ASSERT_EQ(expected.sign, actual.sign) << values[i];
+                ASSERT_EQ(std::wstring(expected.digits), std::wstring(actual.digits)) << values[i];
+            }
+        }
+    }
+}
+
+TEST_F(DoubleToNumberTestFixture, PackedNumberLimitsTest)
+{
+    // Prepare
+    PACKEDNUMBER packed;
+    NUMBER number;
+    NUMBER expected;
+    expected.precision = 30;
+    expected.scale = -1;
+
+    // Act
+    bool isHalfPacked = DoubleToPackedNumber(0.5, 30, &packed);
+    UnpackNumber(packed, &number);
+
+    // Assert
+    EXPECT_EQ(16u, sizeof(PACKEDNUMBER));
+    EXPECT_TRUE(isHalfPacked);
+    EXPECT_EQ(1, packed.length);
+    DoubleToNumberTestFixture::assertResult(expected, L"500000000000000000000000000000", number);
+    EXPECT_FALSE(DoubleToPackedNumber(0.1, 30, &packed));
+    EXPECT_FALSE(DoubleToPackedNumber(std::numeric_limits<double>::quiet_NaN(), 400, DTN_FIXED, &packed));
+    EXPECT_FALSE(DoubleToPackedNumber(1.0, 0, &packed));
+}
+
+TEST_F(DoubleToNumberTestFixture, CacheMatchesUncachedTest)
+{
+    // A small cache, so that some slots are replaced all the time.
+    DoubleToNumberCache cache(32 * 64);
+    const double values[] = { 19.99, 0.0, -0.0, 1.0, std::numeric_limits<double>::quiet_NaN(), -std::numeric_limits<double>::infinity(),
+        123456789012345678.0, 5e-324, 0.1, 100.25, -19.99 };
+    const int valueCount = sizeof(values) / sizeof(values[0]);
+    const DoubleToNumberMode modes[] = { DTN_PRECISION, DTN_SHORTEST, DTN_FIXED };
+
+    uint64_t calls = 0;
+    for (int round = 0; round < 3; ++round)
+    {
+        for (int i = 0; i < valueCount * 5; ++i)
+        {
+            // Prepare
+            double value = values[(i * 7) % valueCount];
+            DoubleToNumberMode mode = modes[i % 3];
+            int precision = mode == DTN_FIXED ? (i * 37) % 400 : 1 + i % NUMBER_MAXDIGITS;
+            NUMBER expected;
+            NUMBER actual;
+
+            // Act
+            DoubleToNumber(value, precision, mode, &expected);
+            cache.convert(value, precision, mode, &actual);
+            ++calls;
+
+            // Assert
+            ASSERT_EQ(expected.precision, actual.precision) << value;
+            ASSERT_EQ(expected.scale, actual.scale) << value;
+            ASSERT_EQ(expected.sign, actual.sign) << value;
+            ASSERT_EQ(std::wstring(expected.digits), std::wstring(actual.digits)) << value;
+        }
+    }
+
+    EXPECT_LT(0u, cache.hitCount());
+    EXPECT_EQ(calls, cache.hitCount() + cache.missCount());
+}
+
+TEST_F(DoubleToNumberTestFixture, CacheBudgetTest)
+{
+    // Prepare
+    DoubleToNumberCache cache(1000);
+    DoubleToNumberCache smallCache(0);
+    NUMBER number;
+
+    // Act
+    cache.convert(19.99, 17, &number);
+    cache.convert(19.99, 17, &number);
+    cache.convert(19.99, 16, &number);
+    smallCache.convert(19.99, 17, &number);
+    smallCache.convert(19.99, 17, &number);
+
+    // Assert
+    EXPECT_EQ(8u, cache.slotCount());
+    EXPECT_GE(1000u, cache.memorySize());
+    EXPECT_EQ(1u, cache.hitCount());
+    EXPECT_EQ(2u, cache.missCount());
+    EXPECT_EQ(1u, smallCache.slotCount());
+    EXPECT_EQ(1u, smallCache.hitCount());
+}
+
+TEST_F(DoubleToNumberTestFixture, ParallelMatchesSingleTest)
+{
+    // Prepare
+    std::vector<double> values = randomDoubles(25000);
+    appendValues(&values, randomPrices(25000, 1000000));
+
+    ParallelConverter converter(4);
+
+    // Act
+    std::vector<NUMBER> actual(values.size());
+    converter.convert(values.data(), values.size(), 17, actual.data());
+
+    // Run a second job on the same workers.
+    std::vector<NUMBER> actual2(values.size() - 1);
+    converter.convert(values.data() + 1, values.size() - 1, 15, actual2.data());
+
+    // Assert
+    EXPECT_EQ(4u, converter.threadCount());
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        NUMBER expected;
+        DoubleToNumber(values[i], 17, &expected);
+        DoubleToNumberTestFixture::assertResult(expected, expected.digits, actual[i]);
+
+        if (i > 0)
+        {
+            DoubleToNumber(values[i], 15, &expected);
+            DoubleToNumberTestFixture::assertResult(expected, expected.digits, actual2[i - 1]);
+        }
+    }
+}
+
+// Runs ParseDouble over the whole text. Returns the value, or NaN if the text was not
+// consumed completely or ec differs from expectedEc.
+static double parseToDouble(const char* text, int expectedEc = 0)
+{
+    double value = 0;
+    const char* pEnd = text + strlen(text);
+    ParseDoubleResult<char> result = ParseDouble(text, pEnd, &value);
+
+    return (result.ptr == pEnd && result.ec == expectedEc) ? value : std::numeric_limits<double>::quiet_NaN();
+}
+
+TEST_F(DoubleToNumberTestFixture, ParseSimpleTest)
+{
+    // Act & Assert
+    EXPECT_EQ(0.1, parseToDouble("0.1"));
+    EXPECT_EQ(0.1, parseToDouble(".1"));
+    EXPECT_EQ(5.0, parseToDouble("5."));
+    EXPECT_EQ(-123456.789, parseToDouble("-123456.789"));
+    EXPECT_EQ(1.25, parseToDouble("+1.25"));
+    EXPECT_EQ(1e21, parseToDouble("1E21"));
+    EXPECT_EQ(1e-5, parseToDouble("0.00001000"));
+    EXPECT_EQ(123.0, parseToDouble("0000123e-0"));
+    EXPECT_EQ(9007199254740992.0, parseToDouble("9007199254740993"));
+    EXPECT_EQ(0.3, parseToDouble("0.299999999999999988897769753748434595763683319091796875"));
+    EXPECT_EQ(1.7976931348623157e308, parseToDouble("1.7976931348623157e308"));
+    EXPECT_EQ(4.9406564584124654e-324, parseToDouble("5e-324"));
+
+    double zero = parseToDouble("-0.000e+12");
+    EXPECT_EQ(0.0, zero);
+    EXPECT_TRUE(std::signbit(zero));
+
+    EXPECT_EQ(std::numeric_limits<double>::infinity(), parseToDouble("inf"));
+    EXPECT_EQ(-std::numeric_limits<double>::infinity(), parseToDouble("-Infinity"));
+    EXPECT_TRUE(std::isnan(parseToDouble("NaN")));
+    EXPECT_TRUE(std::isnan(parseToDouble("nan(0x1f)")));
+}
+
+TEST_F(DoubleToNumberTestFixture, ParseHalfwayTest)
+{
+    // 2^53 + 1 lies halfway between 2^53 and 2^53 + 2. Ties go to the even mantissa, any
+    // digit beyond the 19th decides the rest.
+    EXPECT_EQ(9007199254740992.0, parseToDouble("9007199254740993.0000000000000000000000"));
+    EXPECT_EQ(9007199254740994.0, parseToDouble("9007199254740993.0000000000000000000001"));
+    EXPECT_EQ(9007199254740996.0, parseToDouble("9007199254740995.0000000000000000000000"));
+    EXPECT_EQ(9007199254740994.0, parseToDouble("9007199254740994.9999999999999999999999"));
+
+    // Halfway between 0 and the smallest subnormal, 2^-1075, and a hair above it.
+    std::string halfway = "2.4703282292062327208828439643411068618252990130716238221279284125033775363510437593264991818081799618989828234772285886546332835517796989819938739800539093906315035659515570226392290858392449105184435931802849936536152500319370457678249219365623669863658480757001585769269903706311928279558551332927834338409351978015531246597263579574622766465272827220056374006485499977096599470454020828166226237857393450736339007967761930577506740176324673600968951340535537458516661134223766678604162159680461914467291840300530057530849048765391711386591646239524912623653881879636239373280423891018672348497668235089863388587925628302755995657524455507255189313690836254779186948667994968324049705821028513185451396213837722826145437693412532098591327667236328125";
+    EXPECT_EQ(0.0, parseToDouble((halfway + "e-324").c_str(), ERANGE));
+    EXPECT_EQ(4.9406564584124654e-324, parseToDouble((halfway + "00000000000000000000000000000001e-324").c_str()));
+
+    // Halfway between the largest double and the next power of two overflows.
+    EXPECT_EQ(1.7976931348623157e308, parseToDouble("1.7976931348623158079372897140530341507993413271003782693617377898044496829276475094664901797758720709633028641669288791094655554785194040263065748867150582068190890200070838367627385484581771153176447573027006985557136695962284291481986083493647529271907416844436551070434271155969950809304288017790417449779199999999999e308"));
+    EXPECT_EQ(std::numeric_limits<double>::infinity(), parseToDouble("1.79769313486231580793728971405303415079934132710037826936173778980444968292764750946649017977587207096330286416692887910946555547851940402630657488671505820681908902000708383676273854845817711531764475730270069855571366959622842914819860834936475292719074168444365510704342711559699508093042880177904174497792e308", ERANGE));
+}
+
+TEST_F(DoubleToNumberTestFixture, ParseSyntaxTest)
+{
+    const char* texts[] = { "", "-", ".", "+.e5", "e5", "in", "1.5e", "1.5e+", "1e5x", "2.5.1", "nan(1", "infinit", " 1" };
+    const int expectedLengths[] = { 0, 0, 0, 0, 0, 0, 3, 3, 3, 3, 3, 3, 0 };
+    const int expectedEcs[] = { EINVAL, EINVAL, EINVAL, EINVAL, EINVAL, EINVAL, 0, 0, 0, 0, 0, 0, EINVAL };
+
+    for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i)
+    {
+        // Prepare
+        double value = 42;
+
+        // Act
+        ParseDoubleResult<char> result = ParseDouble(texts[i], texts[i] + strlen(texts[i]), &value);
+
+        // Assert
+        EXPECT_EQ(expectedLengths[i], result.ptr - texts[i]) << texts[i];
+        EXPECT_EQ(expectedEcs[i], result.ec) << texts[i];
+        if (result.ec == EINVAL)
+        {
+            EXPECT_EQ(42.0, value);
+        }
+    }
+
+    // Out of range values are still stored.
+    EXPECT_EQ(-std::numeric_limits<double>::infinity(), parseToDouble("-1e309", ERANGE));
+    EXPECT_EQ(0.0, parseToDouble("1e-99999999999", ERANGE));
+    EXPECT_EQ(std::numeric_limits<double>::infinity(), parseToDouble("0.001e99999999999", ERANGE));
+
+    // Wide characters.
+    const wchar_t wideText[] = L"-2.5e-3";
+    double value = 0;
+    ParseDoubleResult<wchar_t> result = ParseDouble(wideText, wideText + 7, &value);
+    EXPECT_EQ(wideText + 7, result.ptr);
+    EXPECT_EQ(-2.5e-3, value);
+}
+
+TEST_F(DoubleToNumberTestFixture, ParseRoundTripTest)
+{
+    std::vector<double> values = randomDoubles(20000);
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        // Prepare
+        double value = values[i];
+        if (std::isnan(value))
+        {
+            continue;
+        }
+
+        char buffer[64];
+        DoubleToCharsResult<char> chars = DoubleToChars(buffer, buffer + sizeof(buffer), value);
+        *chars.ptr = 0;
+
+        NUMBER shortest;
+        DoubleToNumber(value, 0, DTN_SHORTEST, &shortest);
+        NUMBER padded;
+        DoubleToNumber(value, 25, DTN_PRECISION, &padded);
+
+        // Act
+        double parsed = parseToDouble(buffer, std::isinf(value) ? ERANGE : 0);
+        double fromShortest = 0;
+        NumberToDouble(&shortest, &fromShortest);
+        double fromPadded = 0;
+        NumberToDouble(&padded, &fromPadded);
+
+        // Assert
+        EXPECT_EQ(0, memcmp(&value, &parsed, sizeof(value))) << buffer;
+        EXPECT_EQ(0, memcmp(&value, &fromShortest, sizeof(value))) << buffer;
+        EXPECT_EQ(0, memcmp(&value, &fromPadded, sizeof(value))) << buffer;
+
+        // The 17 digits of printf as a cross check.
+        snprintf(buffer, sizeof(buffer), "%.17g", value);
+        EXPECT_EQ(strtod(buffer, NULL), parseToDouble(buffer, std::isinf(value) ? ERANGE : 0)) << buffer;
+    }
+}
@@ -0,0 +1,52 @@
+#include "gmock/gmock.h"
+#include "eisellemire.h"
+#include <cstring>
+
+class EiselLemireTestFixture : public::testing::Test
+{
+public:
+    double run(uint64_t mantissa, int exponent)
+    {
+        uint64_t bits = EiselLemire::compute(mantissa, exponent);
+
+        double value = 0;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
+
+TEST_F(EiselLemireTestFixture, SimpleTest)
+{
+    // Act & Assert
+    EXPECT_EQ(0.1, run(1, -1));
+    EXPECT_EQ(123456.789, run(123456789, -3));
+    EXPECT_EQ(1e23, run(1, 23));
+    EXPECT_EQ(0.84551240822557006, run(84551240822557006, -17));
+    EXPECT_EQ(18446744073709551615.0, run(18446744073709551615ULL, 0));
+}
+
+TEST_F(EiselLemireTestFixture, HalfwayTiesToEvenTest)
+{
+    // 2^53 + 1 and 2^53 + 3 lie halfway between two doubles.
+    EXPECT_EQ(9007199254740992.0, run(9007199254740993, 0));
+    EXPECT_EQ(9007199254740996.0, run(9007199254740995, 0));
+
+    // The same with a power of ten in play: (2^53 + 1) * 2^-4 = (2^53 + 1) * 5^4 * 10^-4.
+    EXPECT_EQ(562949953421312.0, run(5629499534213120625, -4));
+    EXPECT_EQ(562949953421312.25, run(5629499534213121875, -4));
+}
+
+TEST_F(EiselLemireTestFixture, ExtremeValuesTest)
+{
+    // Act & Assert
+    EXPECT_EQ(4.9406564584124654e-324, run(5, -324));
+    EXPECT_EQ(0.0, run(2, -324));
+    EXPECT_EQ(2.2250738585072014e-308, run(22250738585072014, -324));
+    EXPECT_EQ(1.7976931348623157e308, run(17976931348623157, 292));
+    EXPECT_EQ(0.0, run(1, EiselLemire::MINEXPONENT - 1));
+
+    uint64_t infinityBits = (uint64_t)0x7FF << 52;
+    EXPECT_EQ(infinityBits, EiselLemire::compute(18, 307));
+    EXPECT_EQ(infinityBits, EiselLemire::compute(1, EiselLemire::MAXEXPONENT + 1));
+    EXPECT_EQ(0u, EiselLemire::compute(0, 100));
+}
@@ -0,0 +1,185 @@
+#include "gmock/gmock.h"
+#include "floatdigits.h"
+
+class FloatDigitsTestFixture : public::testing::Test
+{
+public:
+    void split(float value, uint32_t* pMantissa, int* pExponent, uint32_t* pHighBitIdx, bool* pHasUnequalMargins)
+    {
+        uint32_t bits = 0;
+        memcpy(&bits, &value, sizeof(bits));
+
+        uint32_t mantissa = bits & ((1u << 23) - 1);
+        int biasedExponent = (int)((bits >> 23) & 0xFF);
+        *pExponent = -149;
+        *pHasUnequalMargins = false;
+        if (biasedExponent > 0)
+        {
+            *pHasUnequalMargins = mantissa == 0 && biasedExponent > 1;
+            mantissa += 1u << 23;
+            *pExponent = biasedExponent - 150;
+        }
+
+        *pMantissa = mantissa;
+        *pHighBitIdx = 31;
+        while ((mantissa >> *pHighBitIdx) == 0)
+        {
+            --*pHighBitIdx;
+        }
+    }
+
+    bool runCounted(float value, int count, std::string& digits, int* dec)
+    {
+        uint32_t mantissa = 0;
+        int exponent = 0;
+        uint32_t highBitIdx = 0;
+        bool hasUnequalMargins = false;
+        split(value, &mantissa, &exponent, &highBitIdx, &hasUnequalMargins);
+
+        char buffer[FloatDigits::MAXCOUNT + 1];
+        bool result = FloatDigits::tryRunCounted(mantissa, exponent, highBitIdx, count, buffer, dec);
+        digits = result ? std::string(buffer) : std::string();
+
+        return result;
+    }
+
+    bool runFixed(float value, int fractionDigits, std::string& digits, int* dec)
+    {
+        uint32_t mantissa = 0;
+        int exponent = 0;
+        uint32_t highBitIdx = 0;
+        bool hasUnequalMargins = false;
+        split(value, &mantissa, &exponent, &highBitIdx, &hasUnequalMargins);
+
+        char buffer[20];
+        int count = 0;
+        bool result = FloatDigits::tryRunFixed(mantissa, exponent, fractionDigits, (int)sizeof(buffer) - 1, buffer, &count, dec);
+        digits = result ? std::string(buffer, count) : std::string();
+
+        return result;
+    }
+
+    bool runShortest(float value, std::string& digits, int* dec)
+    {
+        uint32_t mantissa = 0;
+        int exponent = 0;
+        uint32_t highBitIdx = 0;
+        bool hasUnequalMargins = false;
+        split(value, &mantissa, &exponent, &highBitIdx, &hasUnequalMargins);
+
+        char buffer[FloatDigits::MAXCOUNT + 1];
+        int count = 0;
+        bool result = FloatDigits::tryRunShortest(mantissa, exponent, hasUnequalMargins, buffer, &count, dec);
+        digits = result ? std::string(buffer, count) : std::string();
+
+        return result;
+    }
+};
+
+TEST_F(FloatDigitsTestFixture, CountedDigitsTest)
+{
+    // Prepare
+    std::string digits;
+    int dec = 0;
+
+    // Act
+    bool result = runCounted(0.1f, 9, digits, &dec);
+
+    // Assert
+    EXPECT_TRUE(result);
+    EXPECT_EQ(-1, dec);
+    EXPECT_EQ(std::string("100000001"), digits);
+}
+
+TEST_F(FloatDigitsTestFixture, CountedTieRoundsToEvenTest)
+{
+    // Prepare
+    std::string digits;
+    int dec = 0;
+
+    // Act & Assert
+    // Unlike Grisu the exact ties are decided here.
+    EXPECT_TRUE(runCounted(2.5f, 1, digits, &dec));
+    EXPECT_EQ(std::string("2"), digits);
+    EXPECT_TRUE(runCounted(3.5f, 1, digits, &dec));
+    EXPECT_EQ(std::string("4"), digits);
+}
+
+TEST_F(FloatDigitsTestFixture, RoundUpCarryTest)
+{
+    // Prepare
+    std::string digits;
+    int dec = 0;
+
+    // Act
+    bool result = runCounted(9.9999f, 3, digits, &dec);
+
+    // Assert
+    EXPECT_TRUE(result);
+    EXPECT_EQ(1, dec);
+    EXPECT_EQ(std::string("100"), digits);
+}
+
+TEST_F(FloatDigitsTestFixture, FixedDigitsTest)
+{
+    // Prepare
+    std::string digits;
+    int dec = 0;
+
+    // Act & Assert
+    // 1.005f is just below 1.005.
+    EXPECT_TRUE(runFixed(1.005f, 2, digits, &dec));
+    EXPECT_EQ(0, dec);
+    EXPECT_EQ(std::string("100"), digits);
+
+    EXPECT_TRUE(runFixed(0.0004f, 3, digits, &dec));
+    EXPECT_EQ(0, dec);
+    EXPECT_EQ(std::string(), digits);
+}
+
+TEST_F(FloatDigitsTestFixture, ShortestDigitsTest)
+{
+    // Prepare
+    std::string digits;
+    int dec = 0;
+
+    // Act & Assert
+    EXPECT_TRUE(runShortest(0.1f, digits, &dec));
+    EXPECT_EQ(-1, dec);
+    EXPECT_EQ(std::string("1"), digits);
+
+    EXPECT_TRUE(runShortest(1.23f, digits, &dec));
+    EXPECT_EQ(0, dec);
+    EXPECT_EQ(std::string("123"), digits);
+
+    EXPECT_TRUE(runShortest(16777216.0f, digits, &dec));
+    EXPECT_EQ(7, dec);
+    EXPECT_EQ(std::string("16777216"), digits);
+}
+
+TEST_F(FloatDigitsTestFixture, ShortestLimitsTest)
+{
+    // Prepare
+    std::string digits;
+    int dec = 0;
+
+    // Act & Assert
+    EXPECT_TRUE(runShortest(std::numeric_limits<float>::denorm_min(), digits, &dec));
+    EXPECT_EQ(-45, dec);
+    EXPECT_EQ(std::string("1"), digits);
+
+    EXPECT_TRUE(runShortest(std::numeric_limits<float>::max(), digits, &dec));
+    EXPECT_EQ(38, dec);
+    EXPECT_EQ(std::string("34028235"), digits);
+}
+
+TEST_F(FloatDigitsTestFixture, OutOfRangeBailsOutTest)
+{
+    // Prepare
+    std::string digits;
+    int dec = 0;
+
+    // Act & Assert
+    // The integer part of 1e30f does not fit into the product.
+    EXPECT_FALSE(runFixed(1e30f, 0, digits, &dec));
+}
@@ -0,0 +1,86 @@
+#include "gmock/gmock.h"
+#include "grisu.h"
+
+class GrisuTestFixture : public::testing::Test
+{
+public:
+    bool run(double value, int count, std::string& digits, int* dec)
+    {
+        uint64_t bits = 0;
+        memcpy(&bits, &value, sizeof(bits));
+
+        uint64_t mantissa = bits & (((uint64_t)1 << 52) - 1);
+        int biasedExponent = (int)((bits >> 52) & 0x7FF);
+        int exponent = -1074;
+        if (biasedExponent > 0)
+        {
+            mantissa += (uint64_t)1 << 52;
+            exponent = biasedExponent - 1075;
+        }
+
+        char buffer[Grisu::MAXCOUNT + 1];
+        bool result = Grisu::tryRunCounted(mantissa, exponent, count, buffer, dec);
+        digits = result ? std::string(buffer) : std::string();
+
+        return result;
+    }
+};
+
+TEST_F(GrisuTestFixture, CountedDigitsTest)
+{
+    // Prepare
+    std::string digits;
+    int dec = 0;
+
+    // Act
+    bool result = run(0.84551240822557006, 17, digits, &dec);
+
+    // Assert
+    EXPECT_TRUE(result);
+    EXPECT_EQ(-1, dec);
+    EXPECT_EQ(std::string("84551240822557006"), digits);
+}
+
+TEST_F(GrisuTestFixture, SubnormalTest)
+{
+    // Prepare
+    std::string digits;
+    int dec = 0;
+
+    // Act
+    bool result = run(pow(0.5, 1074), 15, digits, &dec);
+
+    // Assert
+    EXPECT_TRUE(result);
+    EXPECT_EQ(-324, dec);
+    EXPECT_EQ(std::string("494065645841247"), digits);
+}
+
+TEST_F(GrisuTestFixture, RoundUpCarryTest)
+{
+    // Prepare
+    std::string digits;
+    int dec = 0;
+
+    // Act
+    bool result = run(999.99999999999999999999, 5, digits, &dec);
+
+    // Assert
+    EXPECT_TRUE(result);
+    EXPECT_EQ(3, dec);
+    EXPECT_EQ(std::string("10000"), digits);
+}
+
+TEST_F(GrisuTestFixture, ExactTieBailsOutTest)
+{
+    // Prepare
+    std::string digits;
+    int dec = 0;
+
+    // Act & Assert
+    // 2.5 is exactly in the middle of 2 and 3. Only the BigNum path can apply round half to even.
+    EXPECT_FALSE(run(2.5, 1, digits, &dec));
+
+    // 1.0 has no more digits to offer, so the error interval can not be narrowed down.
+    EXPECT_FALSE(run(1.0, 17, digits, &dec));
+}
@@ -0,0 +1,693 @@
+#include "doubletonumber.h"
+#include "doubletonumberbatch.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Differential verification of the digit engines against the BigNum Dragon4 oracle.
+//
+// Usage: doubletonumberverify [--quick] [--threads N] [--random N] [--seed S]
+//                             [--float-step N] [suite...]
+//
+// Every fast path in front of BigNum (the native integer tiers, Grisu, the float digits,
+// the batch classifier) has to produce exactly the digits, digit count and
+// decimal exponent of Dragon4Double, Dragon4DoubleCutoff and Dragon4DoubleShortest on
+// BigNum, which are the reference here. The suites are:
+//  - boundaries: powers of two and ten with their neighbours, subnormals and values
+//    which are exact decimal ties, each at every digit count up to 19, at 50 digits
+//    and at 0 to 25 fraction digits, where the rounding ties to even.
+//  - random: --random doubles (default 4 billion) from a mix of uniform bit patterns,
+//    moderate exponents and short decimals. Every value is checked in counted, fixed
+//    and shortest mode and through DoubleToNumberBatch.
+//  - floats: every --float-step'th float bit pattern (default 1, i.e. all 2^32),
+//    through FloatToNumber in all three modes.
+//
+// The work is cut into chunks which all hardware threads (or --threads) take from a
+// shared counter. Progress goes to stderr every 10 seconds. Each suite reports its
+// throughput and the mismatch with the lowest input index, if any; the exit code is 1
+// if there was one. --quick runs a small sample of each suite, which is what ctest does.
+
+#define VERIFY_CHUNKSIZE (64 * DOUBLEBATCH_BLOCKSIZE)
+#define VERIFY_MAXFIXEDDIGITS 25
+#define VERIFY_PROGRESSSECONDS 10
+
+struct Digits
+{
+    char text[NUMBER_MAXDIGITS + 1];
+    int count;
+    int dec;
+};
+
+// Where and how the engines disagreed with the oracle.
+struct Mismatch
+{
+    uint64_t index;
+    uint64_t bits;
+    bool isFloat;
+    const char* check;
+    int argument;
+    Digits expected;
+    Digits actual;
+};
+
+// Checks the items [begin, end) of a suite. Adds the number of comparisons made to
+// *pChecks. Returns false and fills *pMismatch at the first mismatch.
+typedef bool (*CheckRangeFunction)(uint64_t begin, uint64_t end, uint64_t* pChecks, Mismatch* pMismatch);
+
+static unsigned int threadCount = 0;
+static uint64_t randomCount = 4000000000ull;
+static uint64_t randomSeed = 0x5DEECE66Dull;
+static uint64_t floatStep = 1;
+static std::vector<double> boundaryValues;
+
+static uint64_t mixBits(uint64_t value)
+{
+    // splitmix64
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+static uint64_t doubleBits(double value)
+{
+    uint64_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double bitsDouble(uint64_t bits)
+{
+    double value = 0;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// The oracle results. The digit strings are compared up to `count`, so the padding of
+// the counted digits is part of the comparison.
+
+static void oracleCounted(double value, int count, Digits* pDigits)
+{
+    int sign = 0;
+    Dragon4Double(value, count, pDigits->text, &pDigits->dec, &sign);
+    pDigits->count = count;
+}
+
+static void oracleFixed(double value, int fractionDigits, Digits* pDigits)
+{
+    // _fcvt2_s reports zero with no digits, Dragon4 needs a non-zero mantissa.
+    if ((doubleBits(value) << 1) == 0)
+    {
+        pDigits->count = 0;
+        pDigits->dec = 0;
+        return;
+    }
+
+    int sign = 0;
+    pDigits->count = Dragon4DoubleCutoff(value, DRAGON4_CUTOFF_FRACTIONLENGTH, fractionDigits, NUMBER_MAXDIGITS, pDigits->text, &pDigits->dec, &sign);
+}
+
+static void oracleShortest(double value, Digits* pDigits)
+{
+    int sign = 0;
+    pDigits->count = Dragon4DoubleShortest(value, pDigits->text, &pDigits->dec, &sign);
+}
+
+// Shortest digits which round trip as a float, with the BigNum Dragon4 of the doubles
+// rather than the FloatDigits fast path FloatToNumber uses.
+static void oracleFloatShortest(float value, Digits* pDigits)
+{
+    FPSINGLE* pValue = (FPSINGLE*)&value;
+    uint64_t realMantissa = pValue->mant;
+    int realExponent = -149;
+    uint32_t mantissaHighBitIdx = 23;
+    bool hasUnequalMargins = false;
+    if (pValue->exp > 0)
+    {
+        hasUnequalMargins = realMantissa == 0 && pValue->exp > 1;
+        realMantissa += (uint64_t)1 << 23;
+        realExponent = pValue->exp - 150;
+    }
+    else if (realMantissa != 0)
+    {
+        mantissaHighBitIdx = BigNum::logBase2(realMantissa);
+    }
+    else
+    {
+        oracleShortest(0.0, pDigits);
+        return;
+    }
+
+    pDigits->count = Dragon4Shortest<BigNum>(realMantissa, realExponent, mantissaHighBitIdx, hasUnequalMargins, FLOAT_SHORTEST_MAXDIGITS, pDigits->text, &pDigits->dec);
+}
+
+// The digits of a NUMBER as the oracle writes them: zero has its digits cleared there.
+static void getNumberDigits(const NUMBER& number, Digits* pDigits)
+{
+    pDigits->count = number.precision;
+    pDigits->dec = number.scale;
+    for (int i = 0; i < number.precision && i < NUMBER_MAXDIGITS; ++i)
+    {
+        pDigits->text[i] = number.digits[0] == 0 ? '0' : (char)number.digits[i];
+    }
+}
+
+static bool isSameDigits(const Digits& expected, const Digits& actual)
+{
+    return expected.count == actual.count
+        && expected.dec == actual.dec
+        && memcmp(expected.text, actual.text, expected.count) == 0;
+}
+
+// Compares and fills *pMismatch if the results differ.
+static bool compare(const Digits& expected, const Digits& actual, const char* check, int argument, Mismatch* pMismatch)
+{
+    if (isSameDigits(expected, actual))
+    {
+        return true;
+    }
+
+    pMismatch->check = check;
+    pMismatch->argument = argument;
+    pMismatch->expected = expected;
+    pMismatch->actual = actual;
+    return false;
+}
+
+static bool checkCounted(double value, int count, Mismatch* pMismatch)
+{
+    Digits expected;
+    Digits actual;
+    int sign = 0;
+    oracleCounted(value, count, &expected);
+    _ecvt2_s(actual.text, sizeof(actual.text), value, count, &actual.dec, &sign);
+    actual.count = count;
+    return compare(expected, actual, "_ecvt2_s", count, pMismatch);
+}
+
+static bool checkFixed(double value, int fractionDigits, Mismatch* pMismatch)
+{
+    Digits expected;
+    Digits actual;
+    int sign = 0;
+    oracleFixed(value, fractionDigits, &expected);
+    _fcvt2_s(actual.text, sizeof(actual.text), value, fractionDigits, &actual.count, &actual.dec, &sign);
+    return compare(expected, actual, "_fcvt2_s", fractionDigits, pMismatch);
+}
+
+static bool checkShortest(double value, Mismatch* pMismatch)
+{
+    Digits expected;
+    Digits actual;
+    int sign = 0;
+    oracleShortest(value, &expected);
+    _ecvt2_shortest_s(actual.text, sizeof(actual.text), value, &actual.count, &actual.dec, &sign);
+    return compare(expected, actual, "_ecvt2_shortest_s", 0, pMismatch);
+}
+
+static void addNeighbours(double value, int distance)
+{
+    uint64_t bits = doubleBits(value);
+    for (int i = -distance; i <= distance; ++i)
+    {
+        uint64_t neighbourBits = bits + i;
+        if (((neighbourBits >> 52) & 0x7FF) != 0x7FF && (neighbourBits >> 63) == 0)
+        {
+            boundaryValues.push_back(bitsDouble(neighbourBits));
+        }
+    }
+}
+
+static void generateBoundaryValues()
+{
+    // Powers of two, where the lower margin is half the upper one, and the largest and
+    // smallest values of every binade.
+    for (int exponent = -1074; exponent <= 1023; ++exponent)
+    {
+        addNeighbours(ldexp(1.0, exponent), 1);
+    }
+
+    // The doubles closest to the powers of ten, where the digit count and the
+    // estimated exponent change.
+    for (int exponent = -323; exponent <= 308; ++exponent)
+    {
+        char text[16];
+        sprintf(text, "1e%d", exponent);
+        addNeighbours(strtod(text, NULL), 2);
+    }
+
+    // The smallest and largest subnormals and those with one or two bits set.
+    for (uint64_t mantissa = 1; mantissa <= 4096; ++mantissa)
+    {
+        boundaryValues.push_back(bitsDouble(mantissa));
+        boundaryValues.push_back(bitsDouble(((uint64_t)1 << 52) - mantissa));
+    }
+
+    for (int i = 0; i < 52; ++i)
+    {
+        for (int j = i + 1; j < 52; ++j)
+        {
+            boundaryValues.push_back(bitsDouble(((uint64_t)1 << i) | ((uint64_t)1 << j)));
+        }
+    }
+
+    // odd / 2^k ends in a 5 at the k-th fraction digit, so rounding to k - 1 fraction
+    // digits or to one digit less than it has is an exact tie. Multiplied by powers of
+    // ten instead they are ties in the integer part, as long as they are exact.
+    for (uint64_t odd = 1; odd < 512; odd += 2)
+    {
+        for (int k = 1; k <= 60; ++k)
+        {
+            boundaryValues.push_back(ldexp((double)odd, -k));
+        }
+
+        uint64_t integer = odd * 5;
+        while (integer < ((uint64_t)1 << 53))
+        {
+            boundaryValues.push_back((double)integer);
+            integer *= 10;
+        }
+    }
+
+    // Exact integers around the native tier limits.
+    for (int bits = 52; bits <= 64; ++bits)
+    {
+        addNeighbours(ldexp(1.0, bits) * 1.5, 2);
+    }
+
+    addNeighbours(0.0, 0);
+}
+
+static bool checkBoundaries(uint64_t begin, uint64_t end, uint64_t* pChecks, Mismatch* pMismatch)
+{
+    for (uint64_t i = begin; i < end; ++i)
+    {
+        double value = boundaryValues[i];
+        pMismatch->index = i;
+        pMismatch->bits = doubleBits(value);
+        pMismatch->isFloat = false;
+
+        for (int count = 1; count <= DOUBLE_SHORTEST_MAXDIGITS + 2; ++count)
+        {
+            if (!checkCounted(value, count, pMismatch))
+            {
+                return false;
+            }
+        }
+
+        if (!checkCounted(value, NUMBER_MAXDIGITS, pMismatch))
+        {
+            return false;
+        }
+
+        for (int fractionDigits = 0; fractionDigits <= VERIFY_MAXFIXEDDIGITS; ++fractionDigits)
+        {
+            if (!checkFixed(value, fractionDigits, pMismatch))
+            {
+                return false;
+            }
+        }
+
+        if (!checkShortest(value, pMismatch))
+        {
+            return false;
+        }
+
+        *pChecks += DOUBLE_SHORTEST_MAXDIGITS + 2 + 1 + VERIFY_MAXFIXEDDIGITS + 1 + 1;
+    }
+
+    return true;
+}
+
+// The random input number `index`: uniform bit patterns half of the time, otherwise
+// values of moderate magnitude with trailing zero bits or short decimals, which take
+// the native tiers. Never NaN or infinity. *pHash receives more random bits.
+static double getRandomValue(uint64_t index, uint64_t* pHash)
+{
+    uint64_t bits = mixBits(randomSeed + index);
+    uint64_t hash = mixBits(bits);
+    *pHash = hash;
+
+    switch (hash % 4)
+    {
+    case 0:
+    case 1:
+        if (((bits >> 52) & 0x7FF) == 0x7FF)
+        {
+            bits ^= (uint64_t)1 << 62;
+        }
+
+        return bitsDouble(bits);
+
+    case 2:
+    {
+        // Exponents from 2^-40 to 2^70, with up to 52 trailing zero bits.
+        uint64_t valueBits = (bits & 0x800FFFFFFFFFFFFF) | ((uint64_t)(983 + bits % 111) << 52);
+        valueBits &= ~(((uint64_t)1 << ((hash >> 8) % 53)) - 1);
+        return bitsDouble(valueBits);
+    }
+
+    default:
+        return (double)(bits % 100000000) / UINT64_POWERSOFTEN[(hash >> 8) % 9];
+    }
+}
+
+static bool checkRandom(uint64_t begin, uint64_t end, uint64_t* pChecks, Mismatch* pMismatch)
+{
+    double values[DOUBLEBATCH_BLOCKSIZE];
+    NUMBER numbers[DOUBLEBATCH_BLOCKSIZE];
+
+    for (uint64_t blockBegin = begin; blockBegin < end; blockBegin += DOUBLEBATCH_BLOCKSIZE)
+    {
+        size_t blockCount = (size_t)std::min((uint64_t)DOUBLEBATCH_BLOCKSIZE, end - blockBegin);
+
+        // One digit count per block, so that the batch can be compared with the same
+        // oracle result. Mostly up to the shortest length, where Grisu and the native
+        // tiers work, sometimes up to NUMBER_MAXDIGITS.
+        uint64_t blockHash = mixBits(randomSeed ^ blockBegin);
+        int count = (blockHash & 7) != 0
+            ? 1 + (int)((blockHash >> 8) % (DOUBLE_SHORTEST_MAXDIGITS + 2))
+            : 1 + (int)((blockHash >> 8) % NUMBER_MAXDIGITS);
+
+        uint64_t hashes[DOUBLEBATCH_BLOCKSIZE];
+        for (size_t i = 0; i < blockCount; ++i)
+        {
+            values[i] = getRandomValue(blockBegin + i, &hashes[i]);
+        }
+
+        DoubleToNumberBatch(values, blockCount, count, numbers);
+
+        for (size_t i = 0; i < blockCount; ++i)
+        {
+            double value = values[i];
+            pMismatch->index = blockBegin + i;
+            pMismatch->bits = doubleBits(value);
+            pMismatch->isFloat = false;
+
+            Digits expected;
+            Digits actual;
+            int sign = 0;
+            oracleCounted(value, count, &expected);
+            _ecvt2_s(actual.text, sizeof(actual.text), value, count, &actual.dec, &sign);
+            actual.count = count;
+            if (!compare(expected, actual, "_ecvt2_s", count, pMismatch))
+            {
+                return false;
+            }
+
+            getNumberDigits(numbers[i], &actual);
+            if (!compare(expected, actual, "DoubleToNumberBatch", count, pMismatch))
+            {
+                return false;
+            }
+
+            if (!checkFixed(value, (int)((hashes[i] >> 16) % (VERIFY_MAXFIXEDDIGITS + 1)), pMismatch)
+                || !checkShortest(value, pMismatch))
+            {
+                return false;
+            }
+        }
+
+        *pChecks += blockCount * 4;
+    }
+
+    return true;
+}
+
+static bool checkFloats(uint64_t begin, uint64_t end, uint64_t* pChecks, Mismatch* pMismatch)
+{
+    for (uint64_t i = begin; i < end; ++i)
+    {
+        uint32_t bits = (uint32_t)(i * floatStep);
+        float value = 0;
+        memcpy(&value, &bits, sizeof(value));
+
+        pMismatch->index = i;
+        pMismatch->bits = bits;
+        pMismatch->isFloat = true;
+
+        NUMBER number;
+        Digits expected;
+        Digits actual;
+        if (((bits >> 23) & 0xFF) == 0xFF)
+        {
+            FloatToNumber(value, 0, DTN_SHORTEST, &number);
+            expected.count = 0;
+            expected.dec = (bits & 0x7FFFFF) != 0 ? SCALE_NAN : SCALE_INF;
+            actual.count = 0;
+            actual.dec = number.scale;
+            if (!compare(expected, actual, "FloatToNumber special", 0, pMismatch))
+            {
+                return false;
+            }
+
+            *pChecks += 1;
+            continue;
+        }
+
+        oracleFloatShortest(value, &expected);
+        FloatToNumber(value, 0, DTN_SHORTEST, &number);
+        getNumberDigits(number, &actual);
+        if (!compare(expected, actual, "FloatToNumber shortest", 0, pMismatch))
+        {
+            return false;
+        }
+
+        // Widening to double is exact, so the double oracle applies.
+        int count = 1 + (int)(mixBits(i) % (FLOAT_SHORTEST_MAXDIGITS + 3));
+        oracleCounted(value, count, &expected);
+        FloatToNumber(value, count, DTN_PRECISION, &number);
+        getNumberDigits(number, &actual);
+        if (!compare(expected, actual, "FloatToNumber precision", count, pMismatch))
+        {
+            return false;
+        }
+
+        int fractionDigits = (int)((mixBits(i) >> 32) % (VERIFY_MAXFIXEDDIGITS + 1));
+        oracleFixed(value, fractionDigits, &expected);
+        FloatToNumber(value, fractionDigits, DTN_FIXED, &number);
+        getNumberDigits(number, &actual);
+        if (!compare(expected, actual, "FloatToNumber fixed", fractionDigits, pMismatch))
+        {
+            return false;
+        }
+
+        *pChecks += 3;
+    }
+
+    return true;
+}
+
+// The state shared by the workers of one suite.
+struct SuiteRun
+{
+    CheckRangeFunction checkRange;
+    uint64_t itemCount;
+    std::atomic<uint64_t> nextItem;
+    std::atomic<uint64_t> doneItems;
+    std::atomic<uint64_t> checks;
+    std::atomic<uint64_t> firstMismatchIndex;
+    std::atomic<unsigned int> runningWorkers;
+    std::mutex mismatchMutex;
+    Mismatch mismatch;
+};
+
+static void runSuiteWorker(SuiteRun* pRun)
+{
+    Mismatch mismatch;
+    uint64_t checks = 0;
+    for (;;)
+    {
+        uint64_t begin = pRun->nextItem.fetch_add(VERIFY_CHUNKSIZE);
+
+        // Chunks after a known mismatch cannot give the first one.
+        if (begin >= pRun->itemCount || begin > pRun->firstMismatchIndex.load())
+        {
+            break;
+        }
+
+        uint64_t end = std::min(begin + VERIFY_CHUNKSIZE, pRun->itemCount);
+        if (!pRun->checkRange(begin, end, &checks, &mismatch))
+        {
+            std::lock_guard<std::mutex> lock(pRun->mismatchMutex);
+            if (mismatch.index < pRun->firstMismatchIndex.load())
+            {
+                pRun->mismatch = mismatch;
+                pRun->firstMismatchIndex.store(mismatch.index);
+            }
+        }
+
+        pRun->doneItems.fetch_add(end - begin);
+    }
+
+    pRun->checks.fetch_add(checks);
+    pRun->runningWorkers.fetch_sub(1);
+}
+
+static void printDigits(const Digits& digits)
+{
+    printf("\"%.*s\" count %d dec %d", digits.count, digits.text, digits.count, digits.dec);
+}
+
+// Runs a suite on all workers. Returns false if there was a mismatch.
+static bool runSuite(const char* name, uint64_t itemCount, CheckRangeFunction checkRange)
+{
+    SuiteRun run;
+    run.checkRange = checkRange;
+    run.itemCount = itemCount;
+    run.nextItem = 0;
+    run.doneItems = 0;
+    run.checks = 0;
+    run.firstMismatchIndex = UINT64_MAX;
+    run.runningWorkers = threadCount;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < threadCount; ++i)
+    {
+        threads.push_back(std::thread(runSuiteWorker, &run));
+    }
+
+    double nextProgress = VERIFY_PROGRESSSECONDS;
+    while (run.runningWorkers.load() > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (seconds >= nextProgress)
+        {
+            uint64_t doneItems = run.doneItems.load();
+            fprintf(stderr, "%-10s %5.1f%% %14llu items %10.0f items/s\n", name, 100.0 * doneItems / itemCount,
+                (unsigned long long)doneItems, doneItems / seconds);
+            nextProgress += VERIFY_PROGRESSSECONDS;
+        }
+    }
+
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    bool isSuccess = run.firstMismatchIndex.load() == UINT64_MAX;
+    uint64_t doneItems = run.doneItems.load();
+    printf("%-10s %14llu items %14llu checks %9.1f s %12.0f items/s %12.0f checks/s  %s\n", name,
+        (unsigned long long)doneItems, (unsigned long long)run.checks.load(), seconds, doneItems / seconds,
+        run.checks.load() / seconds, isSuccess ? "OK" : "MISMATCH");
+
+    if (!isSuccess)
+    {
+        const Mismatch& mismatch = run.mismatch;
+        if (mismatch.isFloat)
+        {
+            float value = 0;
+            uint32_t bits = (uint32_t)mismatch.bits;
+            memcpy(&value, &bits, sizeof(value));
+            printf("  first mismatch: item %llu, float 0x%08X (%.9g)\n", (unsigned long long)mismatch.index, bits, value);
+        }
+        else
+        {
+            printf("  first mismatch: item %llu, double 0x%016llX (%.17g)\n", (unsigned long long)mismatch.index,
+                (unsigned long long)mismatch.bits, bitsDouble(mismatch.bits));
+        }
+
+        printf("  %s(%d)\n  expected ", mismatch.check, mismatch.argument);
+        printDigits(mismatch.expected);
+        printf("\n  actual   ");
+        printDigits(mismatch.actual);
+        printf("\n");
+    }
+
+    fflush(stdout);
+    return isSuccess;
+}
+
+static bool isSuiteSelected(const std::vector<const char*>& suites, const char* name)
+{
+    if (suites.empty())
+    {
+        return true;
+    }
+
+    for (size_t i = 0; i < suites.size(); ++i)
+    {
+        if (strcmp(suites[i], name) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<const char*> suites;
+    for (int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--quick") == 0)
+        {
+            randomCount = 1 << 20;
+            floatStep = 4099;
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+        {
+            threadCount = (unsigned int)strtoul(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "--random") == 0 && hasValue)
+        {
+            randomCount = strtoull(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && hasValue)
+        {
+            randomSeed = strtoull(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "--float-step") == 0 && hasValue)
+        {
+            floatStep = std::max(strtoull(argv[++i], NULL, 0), 1ull);
+        }
+        else if (argv[i][0] != '-')
+        {
+            suites.push_back(argv[i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--quick] [--threads N] [--random N] [--seed S] [--float-step N] [boundaries|random|floats...]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (threadCount == 0)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    printf("%u threads, seed 0x%llX\n", threadCount, (unsigned long long)randomSeed);
+
+    bool isSuccess = true;
+    if (isSuiteSelected(suites, "boundaries"))
+    {
+        generateBoundaryValues();
+        isSuccess &= runSuite("boundaries", boundaryValues.size(), checkBoundaries);
+    }
+
+    if (isSuiteSelected(suites, "random"))
+    {
+        isSuccess &= runSuite("random", randomCount, checkRandom);
+    }
+
+    if (isSuiteSelected(suites, "floats"))
+    {
+        isSuccess &= runSuite("floats", (((uint64_t)1 << 32) + floatStep - 1) / floatStep, checkFloats);
+    }
+
+    return isSuccess ? 0 : 1;
+}